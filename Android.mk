@@ -24,6 +24,10 @@ ifneq ($(TARGET_BUILD_VARIANT),eng)
 local_cflags_for_slang += -D__DISABLE_ASSERTS
 endif
 local_cflags_for_slang += -DTARGET_BUILD_VARIANT=$(TARGET_BUILD_VARIANT)
+# Release builds strip rsDebug() calls from scripts unless told otherwise
+ifeq ($(TARGET_BUILD_VARIANT),user)
+local_cflags_for_slang += -DSLANG_STRIP_RSDEBUG_BY_DEFAULT
+endif
 
 ifeq "REL" "$(PLATFORM_VERSION_CODENAME)"
   RS_VERSION := $(PLATFORM_SDK_VERSION)
@@ -101,8 +105,11 @@ LOCAL_SRC_FILES :=	\
 	slang.cpp	\
 	slang_utils.cpp	\
 	slang_backend.cpp	\
+	slang_code_report.cpp	\
 	slang_pragma_recorder.cpp	\
-	slang_diagnostic_buffer.cpp
+	slang_diagnostic_buffer.cpp	\
+	slang_rs_internalize.cpp	\
+	slang_rs_passes.cpp
 
 LOCAL_C_INCLUDES += frameworks/compile/libbcc/include
 
@@ -129,6 +136,29 @@ LOCAL_MODULE_CLASS := STATIC_LIBRARIES
 include $(LOCAL_PATH)/SlangData.mk
 include $(BUILD_HOST_STATIC_LIBRARY)
 
+# Host static library containing rslib_vec.bc (assembled from rslib_vec.ll)
+# ========================================================
+include $(CLEAR_VARS)
+
+LOCAL_IS_HOST_MODULE := true
+LOCAL_MODULE := librslib_vec
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_MODULE_CLASS := STATIC_LIBRARIES
+
+LLVM_AS := $(HOST_OUT_EXECUTABLES)/llvm-as$(HOST_EXECUTABLE_SUFFIX)
+
+intermediates := $(call local-intermediates-dir)
+input_data_file := $(intermediates)/rslib_vec.bc
+slangdata_output_var_name := rslib_vec_bc
+
+$(input_data_file): $(LOCAL_PATH)/rslib_vec.ll $(LLVM_AS)
+	@mkdir -p $(dir $@)
+	$(hide) $(LLVM_AS) $< -o $@
+
+include $(LOCAL_PATH)/SlangData.mk
+include $(BUILD_HOST_STATIC_LIBRARY)
+
 # Executable slang-data for host
 # ========================================================
 include $(CLEAR_VARS)
@@ -158,7 +188,7 @@ LOCAL_SRC_FILES :=	\
 	llvm-rs-link.cpp
 
 LOCAL_STATIC_LIBRARIES :=	\
-	librslib libslang \
+	librslib librslib_vec libslang \
 	$(static_libraries_needed_by_slang)
 
 LOCAL_LDLIBS := -ldl -lpthread
@@ -181,6 +211,27 @@ LOCAL_SRC_FILES :=	\
 
 include $(BUILD_HOST_EXECUTABLE)
 
+# Executable rs-host-bench for host
+# ========================================================
+ifeq ($(HOST_OS),linux)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := rs-host-bench
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_MODULE_CLASS := EXECUTABLES
+
+LOCAL_SRC_FILES :=	\
+	rs_host_bench.cpp	\
+	rs_host_runtime.cpp
+
+# The scripts it loads link against the runtime functions it exports
+LOCAL_LDFLAGS := -rdynamic
+LOCAL_LDLIBS := -ldl -lpthread -lrt -lm
+
+include $(BUILD_HOST_EXECUTABLE)
+endif
+
 # Executable llvm-rs-cc for host
 # ========================================================
 include $(CLEAR_VARS)
@@ -226,9 +277,17 @@ LOCAL_SRC_FILES :=	\
 	slang_rs_export_var.cpp	\
 	slang_rs_export_func.cpp	\
 	slang_rs_export_foreach.cpp \
+	slang_rs_instrumentation.cpp	\
+	slang_rs_kernel_cost.cpp	\
+	slang_rs_loop_hints.cpp	\
 	slang_rs_object_ref_count.cpp	\
+	slang_rs_opt_remarks.cpp	\
+	slang_rs_profile.cpp	\
 	slang_rs_reflection.cpp \
 	slang_rs_reflect_utils.cpp  \
+	slang_rs_side_effects.cpp	\
+	slang_rs_double_lint.cpp	\
+	slang_rs_access_pattern.cpp	\
 
 LOCAL_STATIC_LIBRARIES :=	\
 	libclangDriver libslang \
@@ -35,6 +35,7 @@
 #include "llvm/ADT/OwningPtr.h"
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -140,9 +141,40 @@ class RSCCOptions {
 
   unsigned int mTargetAPI;
 
+  // "var=value" pairs for -specialize
+  std::vector<std::string> mSpecializations;
+
+  unsigned mPrintKernelCost : 1;
+  unsigned mPrintCodeReport : 1;
+
+  unsigned mStripRSDebug : 1;
+
+  unsigned mOptRemarks : 1;
+
+  // File to write the optimization remarks to, if any
+  std::string mOptRemarksFile;
+
+  // File listing the reflected Java members used by the app
+  std::string mJavaUsageFile;
+
+  unsigned mStripUnusedExports : 1;
+
+  // -Wrs-double
+  unsigned mWarnDouble : 1;
+
+  unsigned mProfileGenerate : 1;
+
+  // Profile to optimize for, if any
+  std::string mProfileUseFile;
+
+  unsigned mInstrument : 1;
+
+  unsigned mLTOOnly : 1;
+
   RSCCOptions() {
     mOutputType = slang::Slang::OT_Bitcode;
-    // Triple/CPU/Features must be hard-coded to our chosen portable ABI.
+    // Triple/CPU/Features default to our chosen portable ABI, which the
+    // bitcode must always use (see ParseArguments()).
     mTriple = "armv7-none-linux-gnueabi";
     mCPU = "";
     slangAssert(mFeatures.empty());
@@ -152,6 +184,19 @@ class RSCCOptions {
     mShowHelp = 0;
     mShowVersion = 0;
     mTargetAPI = RS_VERSION;
+    mPrintKernelCost = 0;
+    mPrintCodeReport = 0;
+#ifdef SLANG_STRIP_RSDEBUG_BY_DEFAULT
+    mStripRSDebug = 1;
+#else
+    mStripRSDebug = 0;
+#endif
+    mOptRemarks = 0;
+    mStripUnusedExports = 0;
+    mWarnDouble = 0;
+    mProfileGenerate = 0;
+    mInstrument = 0;
+    mLTOOnly = 0;
   }
 };
 
@@ -214,6 +259,10 @@ static void ParseArguments(llvm::SmallVectorImpl<const char*> &ArgVector,
           Opts.mOutputType = slang::Slang::OT_Assembly;
           break;
         }
+        case OPT_emit_obj: {
+          Opts.mOutputType = slang::Slang::OT_Object;
+          break;
+        }
         case OPT_emit_llvm: {
           Opts.mOutputType = slang::Slang::OT_LLVMAssembly;
           break;
@@ -239,6 +288,42 @@ static void ParseArguments(llvm::SmallVectorImpl<const char*> &ArgVector,
           << Args->getLastArg(OPT_M_Group)->getAsString(*Args)
           << Args->getLastArg(OPT_Output_Type_Group)->getAsString(*Args);
 
+    // The bitcode is always generated for the portable ABI. Only the code
+    // generated here (for measurements and desktop tools) may be for another
+    // target.
+    if (const Arg *A = Args->getLastArg(OPT_Target_Group)) {
+      if ((Opts.mOutputType != slang::Slang::OT_Assembly) &&
+          (Opts.mOutputType != slang::Slang::OT_Object))
+        DiagEngine.Report(clang::diag::err_drv_argument_only_allowed_with)
+            << A->getAsString(*Args) << "-emit-asm or -emit-obj";
+    }
+
+    // Another target has its own ABI, so it does not get the portable ABI's
+    // features (e.g. +long64). Code for the host uses the host's own ABI
+    // (which, on 64-bit hosts, already has a 64-bit long).
+    if (const Arg *A = Args->getLastArg(OPT_target_triple, OPT_host_target)) {
+      if (A->getOption().matches(OPT_host_target))
+        Opts.mTriple = llvm::sys::getHostTriple();
+      else
+        Opts.mTriple = A->getValue(*Args);
+      Opts.mFeatures.clear();
+    }
+
+    Opts.mCPU = Args->getLastArgValue(OPT_target_cpu, Opts.mCPU);
+
+    std::vector<std::string> Features =
+        Args->getAllArgValues(OPT_target_feature);
+    for (std::vector<std::string>::const_iterator I = Features.begin(),
+             E = Features.end();
+         I != E;
+         I++) {
+      if ((I->size() < 2) || (((*I)[0] != '+') && ((*I)[0] != '-')))
+        DiagEngine.Report(clang::diag::err_drv_invalid_value)
+            << OptParser->getOptionName(OPT_target_feature) << *I;
+      else
+        Opts.mFeatures.push_back(*I);
+    }
+
     Opts.mAllowRSPrefix = Args->hasArg(OPT_allow_rs_prefix);
 
     Opts.mJavaReflectionPathBase =
@@ -262,6 +347,65 @@ static void ParseArguments(llvm::SmallVectorImpl<const char*> &ArgVector,
     Opts.mAdditionalDepTargets =
         Args->getAllArgValues(OPT_additional_dep_target);
 
+    Opts.mSpecializations = Args->getAllArgValues(OPT_specialize);
+    for (std::vector<std::string>::const_iterator
+             I = Opts.mSpecializations.begin(),
+             E = Opts.mSpecializations.end();
+         I != E;
+         I++) {
+      size_t Pos = I->find('=');
+      if ((Pos == 0) || (Pos == std::string::npos) || (Pos + 1 == I->size()))
+        DiagEngine.Report(clang::diag::err_drv_invalid_value)
+            << OptParser->getOptionName(OPT_specialize) << *I;
+    }
+
+    Opts.mPrintKernelCost = Args->hasArg(OPT_print_kernel_cost);
+    Opts.mPrintCodeReport = Args->hasArg(OPT_print_code_report);
+
+    Opts.mStripRSDebug = Args->hasFlag(OPT_strip_rsdebug, OPT_no_strip_rsdebug,
+                                       Opts.mStripRSDebug);
+
+    Opts.mOptRemarks = Args->hasArg(OPT_opt_remarks);
+    Opts.mOptRemarksFile = Args->getLastArgValue(OPT_opt_remarks_file);
+
+    Opts.mJavaUsageFile = Args->getLastArgValue(OPT_java_usage_file);
+    Opts.mStripUnusedExports = Args->hasArg(OPT_strip_unused_exports);
+    if (Opts.mStripUnusedExports && Opts.mJavaUsageFile.empty())
+      DiagEngine.Report(clang::diag::err_drv_argument_only_allowed_with)
+          << Args->getLastArg(OPT_strip_unused_exports)->getAsString(*Args)
+          << OptParser->getOptionName(OPT_java_usage_file);
+
+    Opts.mWarnDouble = Args->hasFlag(OPT_Wrs_double, OPT_Wno_rs_double, false);
+
+    Opts.mProfileGenerate = Args->hasArg(OPT_profile_generate);
+    Opts.mProfileUseFile = Args->getLastArgValue(OPT_profile_use);
+    if (Opts.mProfileGenerate && !Opts.mProfileUseFile.empty())
+      DiagEngine.Report(clang::diag::err_drv_argument_not_allowed_with)
+          << Args->getLastArg(OPT_profile_generate)->getAsString(*Args)
+          << Args->getLastArg(OPT_profile_use)->getAsString(*Args);
+
+    Opts.mInstrument = Args->hasArg(OPT_instrument);
+
+    // The optimization left to llvm-rs-link only happens to bitcode, and
+    // there is none to remark on or to estimate the cost of here
+    Opts.mLTOOnly = Args->hasArg(OPT_lto_only);
+    if (Opts.mLTOOnly) {
+      if ((Opts.mOutputType != slang::Slang::OT_Bitcode) &&
+          (Opts.mOutputType != slang::Slang::OT_Dependency))
+        DiagEngine.Report(clang::diag::err_drv_argument_not_allowed_with)
+            << Args->getLastArg(OPT_lto_only)->getAsString(*Args)
+            << Args->getLastArg(OPT_Output_Type_Group)->getAsString(*Args);
+      if (Opts.mOptRemarks || !Opts.mOptRemarksFile.empty())
+        DiagEngine.Report(clang::diag::err_drv_argument_not_allowed_with)
+            << Args->getLastArg(OPT_lto_only)->getAsString(*Args)
+            << Args->getLastArg(OPT_opt_remarks,
+                                OPT_opt_remarks_file)->getAsString(*Args);
+      if (Opts.mPrintKernelCost)
+        DiagEngine.Report(clang::diag::err_drv_argument_not_allowed_with)
+            << Args->getLastArg(OPT_lto_only)->getAsString(*Args)
+            << Args->getLastArg(OPT_print_kernel_cost)->getAsString(*Args);
+    }
+
     Opts.mShowHelp = Args->hasArg(OPT_help);
     Opts.mShowVersion = Args->hasArg(OPT_version);
 
@@ -446,7 +590,20 @@ int main(int argc, const char **argv) {
                                          Opts.mOutputDep,
                                          Opts.mTargetAPI,
                                          Opts.mJavaReflectionPathBase,
-                                         Opts.mJavaReflectionPackageName);
+                                         Opts.mJavaReflectionPackageName,
+                                         Opts.mSpecializations,
+                                         Opts.mPrintKernelCost,
+                                         Opts.mPrintCodeReport,
+                                         Opts.mStripRSDebug,
+                                         Opts.mOptRemarks,
+                                         Opts.mOptRemarksFile,
+                                         Opts.mJavaUsageFile,
+                                         Opts.mStripUnusedExports,
+                                         Opts.mWarnDouble,
+                                         Opts.mProfileGenerate,
+                                         Opts.mProfileUseFile,
+                                         Opts.mInstrument,
+                                         Opts.mLTOOnly);
   Compiler->reset();
 
   return CompileFailed;
@@ -41,7 +41,9 @@
 
 #include "llvm/Target/TargetData.h"
 
+#include "slang_rs_internalize.h"
 #include "slang_rs_metadata.h"
+#include "slang_rs_passes.h"
 
 using llvm::errs;
 using llvm::LLVMContext;
@@ -64,47 +66,23 @@ static llvm::cl::list<std::string>
                    llvm::cl::desc("Specify additional libraries to link to"),
                    llvm::cl::value_desc("<library bitcode>"));
 
-static bool GetExportSymbolNames(llvm::NamedMDNode *N,
-                                 unsigned NameOpIdx,
-                                 std::vector<const char *> &Names) {
-  if (N == NULL)
-    return true;
-
-  for (unsigned i = 0, e = N->getNumOperands(); i != e; ++i) {
-    llvm::MDNode *V = N->getOperand(i);
-    if (V == NULL)
-      continue;
-
-    if (V->getNumOperands() < (NameOpIdx + 1)) {
-      errs() << "Invalid metadata spec of " << N->getName()
-             << " in Renderscript executable. (#op)\n";
-      return false;
-    }
-
-    llvm::MDString *Name =
-        llvm::dyn_cast<llvm::MDString>(V->getOperand(NameOpIdx));
-    if (Name == NULL) {
-      errs() << "Invalid metadata spec of " << N->getName()
-             << " in Renderscript executable. (#name)\n";
-      return false;
-    }
+// Whether the script in @M was compiled with llvm-rs-cc -lto-only, which
+// leaves all of its optimization to us. If so, also get whether it relaxed its
+// floating-point precision in @RelaxedFP.
+static bool IsOptimizationDeferred(Module *M, bool &RelaxedFP) {
+  llvm::NamedMDNode *N = M->getNamedMetadata(RS_DEFERRED_OPT_MN);
+  if ((N == NULL) || (N->getNumOperands() == 0))
+    return false;
 
-    Names.push_back(Name->getString().data());
-  }
+  RelaxedFP = false;
+  llvm::MDNode *V = N->getOperand(0);
+  if ((V != NULL) && (V->getNumOperands() > 0))
+    if (llvm::MDString *Precision =
+            llvm::dyn_cast<llvm::MDString>(V->getOperand(0)))
+      RelaxedFP = (Precision->getString() != RS_DEFERRED_OPT_FP_FULL);
   return true;
 }
 
-static bool GetExportSymbols(Module *M, std::vector<const char *> &Names) {
-  bool Result = true;
-  // Variables marked as export must be externally visible
-  if (llvm::NamedMDNode *EV = M->getNamedMetadata(RS_EXPORT_VAR_MN))
-    Result |= GetExportSymbolNames(EV, RS_EXPORT_VAR_NAME, Names);
-  // So are those exported functions
-  if (llvm::NamedMDNode *EF = M->getNamedMetadata(RS_EXPORT_FUNC_MN))
-    Result |= GetExportSymbolNames(EF, RS_EXPORT_FUNC_NAME, Names);
-  return Result;
-}
-
 static inline MemoryBuffer *LoadFileIntoMemory(const std::string &F) {
   llvm::OwningPtr<MemoryBuffer> MB;
 
@@ -143,6 +121,8 @@ static inline Module *LoadBitcodeFile(const std::string &F,
 
 extern const char rslib_bc[];
 extern unsigned rslib_bc_size;
+extern const char rslib_vec_bc[];
+extern unsigned rslib_vec_bc_size;
 
 static bool PreloadLibraries(bool NoStdLib,
                              const std::vector<std::string> &AdditionalLibs,
@@ -161,6 +141,16 @@ static bool PreloadLibraries(bool NoStdLib,
     }
 
     LibBitcode.push_back(MB);
+
+    // rslib_vec.bc
+    MB = MemoryBuffer::getMemBuffer(
+        llvm::StringRef(rslib_vec_bc, rslib_vec_bc_size), "rslib_vec.bc");
+    if (MB == NULL) {
+      errs() << "Failed to load (in-memory) `rslib_vec.bc'!\n";
+      return false;
+    }
+
+    LibBitcode.push_back(MB);
   }
 
   // Load additional libraries
@@ -196,6 +186,23 @@ Module *PerformLinking(const std::string &InputFile,
   if (Composite.get() == NULL)
     return NULL;
 
+  // The builtin folding only recognizes the builtins as declarations, so a
+  // script whose optimization was deferred (-lto-only) has its calls folded
+  // before the library definitions are linked in. The ones only made
+  // constant by the optimization are left to the library code.
+  bool RelaxedFP;
+  if (IsOptimizationDeferred(Composite.get(), RelaxedFP)) {
+    llvm::FunctionPassManager FoldPasses(Composite.get());
+    FoldPasses.add(slang::createRSBuiltinFoldPass());
+    FoldPasses.doInitialization();
+    for (Module::iterator F = Composite->begin(), FE = Composite->end();
+         F != FE;
+         F++)
+      if (!F->isDeclaration())
+        FoldPasses.run(*F);
+    FoldPasses.doFinalization();
+  }
+
   for (std::list<MemoryBuffer *>::const_iterator I = LibBitcode.begin(),
           E = LibBitcode.end();
        I != E;
@@ -225,21 +232,34 @@ bool OptimizeModule(Module *M) {
 
   // Some symbols must not be internalized
   std::vector<const char *> ExportList;
-  ExportList.push_back("init");
-  ExportList.push_back("root");
-  ExportList.push_back(".rs.dtor");
-
-  if (!GetExportSymbols(M, ExportList)) {
+  if (!slang::GetRSExternalSymbols(M, ExportList)) {
     return false;
   }
 
   Passes.add(llvm::createInternalizePass(ExportList));
 
-  // TODO(sliao): Do we need to run all LTO passes?
-  llvm::PassManagerBuilder PMBuilder;
-  PMBuilder.populateLTOPassManager(Passes,
-                                   /* Internalize = */false,
-                                   /* RunInliner = */true);
+  bool RelaxedFP;
+  if (IsOptimizationDeferred(M, RelaxedFP)) {
+    // The script has only been cleaned up, so it gets the whole -O3 pipeline
+    // (with the RS passes) llvm-rs-cc would have run, plus inlining. That
+    // covers what the LTO passes do.
+    llvm::PassManagerBuilder PMBuilder;
+    PMBuilder.OptLevel = 3;
+    PMBuilder.Inliner = llvm::createFunctionInliningPass(275);
+    // As in llvm-rs-cc, loops are only unrolled as their #pragma rs hints
+    // say (the stock unroller would also unroll the nounroll ones)
+    PMBuilder.DisableUnrollLoops = true;
+    slang::PopulateRSPassExtensions(PMBuilder, RelaxedFP,
+                                    /* LoopHints = */true);
+    PMBuilder.populateModulePassManager(Passes);
+    M->getNamedMetadata(RS_DEFERRED_OPT_MN)->eraseFromParent();
+  } else {
+    // TODO(sliao): Do we need to run all LTO passes?
+    llvm::PassManagerBuilder PMBuilder;
+    PMBuilder.populateLTOPassManager(Passes,
+                                     /* Internalize = */false,
+                                     /* RunInliner = */true);
+  }
   Passes.run(*M);
 
   return true;
@@ -0,0 +1,598 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// rs-host-bench runs a forEach kernel of a script compiled for the host over
+// host allocations of several sizes, on a pool of threads, and reports how
+// long it takes. See "Running kernels on the host" in README.rst.
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rs_host_runtime.h"
+#include "slang_rs_metadata.h"
+
+using slang::RSHostAllocation;
+
+namespace {
+
+// The parameters a kernel has, as encoded in #rs_export_foreach
+enum {
+  SIG_In      = 0x01,
+  SIG_Out     = 0x02,
+  SIG_UsrData = 0x04,
+  SIG_X       = 0x08,
+  SIG_Y       = 0x10,
+  SIG_All     = 0x1f
+};
+
+// The kernel is called with its parameters (pointers and uint32_t's) packed
+// into the leading argument slots of this one function type. Calling a
+// function through a different type is undefined behaviour in C++; it only
+// works because on x86-64 the first six integer and pointer arguments are
+// all passed in 64-bit registers, whatever their exact types, and a callee
+// ignores the registers it takes no parameter from. Other hosts are rejected
+// in main().
+typedef void (*KernelFunc)(uintptr_t, uintptr_t, uintptr_t, uintptr_t,
+                           uintptr_t);
+
+typedef void (*InitFunc)();
+
+struct Options {
+  std::string Script;
+  std::string Kernel;
+  unsigned Signature;
+  size_t InElementSize;
+  size_t OutElementSize;
+  std::vector<std::pair<uint32_t, uint32_t> > Sizes;
+  std::vector<std::pair<std::string, std::string> > Bindings;
+  unsigned Threads;
+  unsigned Iterations;
+  std::string ProfileFile;
+
+  Options()
+      : Kernel("root"),
+        Signature(SIG_All),
+        InElementSize(4),
+        OutElementSize(4),
+        Threads(0),
+        Iterations(10) {
+    return;
+  }
+};
+
+// One launch of a kernel over all the elements of its allocations. The rows
+// are handed out to the threads one at a time.
+class Launch {
+ private:
+  KernelFunc mKernel;
+  unsigned mSignature;
+  RSHostAllocation *mIn;
+  RSHostAllocation *mOut;
+  uint32_t mDimX;
+  uint32_t mRows;
+  volatile uint32_t mNextRow;
+
+  void runRow(uint32_t Y) {
+    uint8_t *In = NULL;
+    uint8_t *Out = NULL;
+    size_t InStride = 0, OutStride = 0;
+    if (mIn != NULL) {
+      In = static_cast<uint8_t*>(mIn->getElement(0, Y, 0));
+      InStride = mIn->getElementSize();
+    }
+    if (mOut != NULL) {
+      Out = static_cast<uint8_t*>(mOut->getElement(0, Y, 0));
+      OutStride = mOut->getElementSize();
+    }
+
+    for (uint32_t X = 0; X < mDimX; X++) {
+      uintptr_t Args[5] = { 0, 0, 0, 0, 0 };
+      unsigned NumArgs = 0;
+      if (mSignature & SIG_In)
+        Args[NumArgs++] = reinterpret_cast<uintptr_t>(In + X * InStride);
+      if (mSignature & SIG_Out)
+        Args[NumArgs++] = reinterpret_cast<uintptr_t>(Out + X * OutStride);
+      if (mSignature & SIG_UsrData)
+        Args[NumArgs++] = 0;
+      if (mSignature & SIG_X)
+        Args[NumArgs++] = X;
+      if (mSignature & SIG_Y)
+        Args[NumArgs++] = Y;
+      mKernel(Args[0], Args[1], Args[2], Args[3], Args[4]);
+    }
+    return;
+  }
+
+ public:
+  Launch(KernelFunc Kernel,
+         unsigned Signature,
+         RSHostAllocation *In,
+         RSHostAllocation *Out)
+      : mKernel(Kernel),
+        mSignature(Signature),
+        mIn(In),
+        mOut(Out),
+        mNextRow(0) {
+    RSHostAllocation *A = (In != NULL) ? In : Out;
+    mDimX = A->getDimX();
+    mRows = (A->getDimY() > 0) ? A->getDimY() : 1;
+    return;
+  }
+
+  void reset() {
+    mNextRow = 0;
+    return;
+  }
+
+  void runRows() {
+    uint32_t Y;
+    while ((Y = __sync_fetch_and_add(&mNextRow, 1)) < mRows)
+      runRow(Y);
+    return;
+  }
+};
+
+// A fixed set of threads that, together with the calling thread, run each
+// launch they are given
+class ThreadPool {
+ private:
+  pthread_mutex_t mLock;
+  pthread_cond_t mWorkCond;
+  pthread_cond_t mDoneCond;
+  std::vector<pthread_t> mThreads;
+
+  Launch *mLaunch;
+  unsigned mGeneration;
+  unsigned mBusy;
+  bool mExit;
+
+  static void *Worker(void *Arg) {
+    ThreadPool *Pool = static_cast<ThreadPool*>(Arg);
+    unsigned Seen = 0;
+
+    pthread_mutex_lock(&Pool->mLock);
+    while (true) {
+      while (!Pool->mExit && (Pool->mGeneration == Seen))
+        pthread_cond_wait(&Pool->mWorkCond, &Pool->mLock);
+      if (Pool->mExit)
+        break;
+      Seen = Pool->mGeneration;
+      Launch *L = Pool->mLaunch;
+      pthread_mutex_unlock(&Pool->mLock);
+
+      L->runRows();
+
+      pthread_mutex_lock(&Pool->mLock);
+      if (--Pool->mBusy == 0)
+        pthread_cond_signal(&Pool->mDoneCond);
+    }
+    pthread_mutex_unlock(&Pool->mLock);
+    return NULL;
+  }
+
+ public:
+  explicit ThreadPool(unsigned NumThreads)
+      : mLaunch(NULL), mGeneration(0), mBusy(0), mExit(false) {
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mWorkCond, NULL);
+    pthread_cond_init(&mDoneCond, NULL);
+
+    for (unsigned i = 1; i < NumThreads; i++) {
+      pthread_t T;
+      if (pthread_create(&T, NULL, Worker, this) != 0) {
+        fprintf(stderr, "warning: could only start %u threads\n", i);
+        break;
+      }
+      mThreads.push_back(T);
+    }
+    return;
+  }
+
+  ~ThreadPool() {
+    pthread_mutex_lock(&mLock);
+    mExit = true;
+    pthread_cond_broadcast(&mWorkCond);
+    pthread_mutex_unlock(&mLock);
+
+    for (unsigned i = 0, e = mThreads.size(); i != e; i++)
+      pthread_join(mThreads[i], NULL);
+
+    pthread_cond_destroy(&mDoneCond);
+    pthread_cond_destroy(&mWorkCond);
+    pthread_mutex_destroy(&mLock);
+    return;
+  }
+
+  inline unsigned getNumThreads() const { return mThreads.size() + 1; }
+
+  void run(Launch &L) {
+    L.reset();
+
+    pthread_mutex_lock(&mLock);
+    mLaunch = &L;
+    mBusy = mThreads.size();
+    mGeneration++;
+    pthread_cond_broadcast(&mWorkCond);
+    pthread_mutex_unlock(&mLock);
+
+    L.runRows();
+
+    pthread_mutex_lock(&mLock);
+    while (mBusy > 0)
+      pthread_cond_wait(&mDoneCond, &mLock);
+    pthread_mutex_unlock(&mLock);
+    return;
+  }
+};
+
+static double Now() {
+  struct timespec T;
+  clock_gettime(CLOCK_MONOTONIC, &T);
+  return T.tv_sec * 1e3 + T.tv_nsec / 1e6;
+}
+
+// FNV-1a hash of the output, to check that a change to the kernel or the
+// compiler did not change what it computes
+static uint32_t Checksum(const RSHostAllocation *A) {
+  uint32_t Hash = 2166136261u;
+  const uint8_t *Data = A->getData();
+  for (size_t i = 0, e = A->getCount() * A->getElementSize(); i != e; i++) {
+    Hash ^= Data[i];
+    Hash *= 16777619u;
+  }
+  return Hash;
+}
+
+static void PrintUsage(const char *Argv0) {
+  fprintf(stderr,
+          "usage: %s [options] <script.so>\n"
+          "\n"
+          "Runs a forEach kernel of a script compiled with llvm-rs-cc "
+          "-host-target -emit-obj\n"
+          "and linked into <script.so>, and reports its run time.\n"
+          "\n"
+          "  -kernel <name>       Kernel to run (default: root)\n"
+          "  -signature <bits>    Its parameters, as in #rs_export_foreach: "
+          "in 0x1, out 0x2,\n"
+          "                       usrData 0x4, x 0x8, y 0x10 (default: 0x1f)\n"
+          "  -in-element <bytes>  Input element size, 0 for none "
+          "(default: 4)\n"
+          "  -out-element <bytes> Output element size, 0 for none "
+          "(default: 4)\n"
+          "  -size <W>[x<H>]      Allocation size to time, may be repeated\n"
+          "                       (default: 256x256, 1024x1024, 2048x2048)\n"
+          "  -bind <var>=in|out   Set the rs_allocation global <var> to the "
+          "input or\n"
+          "                       output allocation before each size\n"
+          "  -threads <n>         Threads to run the kernel on "
+          "(default: one per CPU)\n"
+          "  -iterations <n>      Timed runs per size (default: 10)\n"
+          "  -profile <file>      Write the counts of a script compiled "
+          "with\n"
+          "                       -profile-generate to <file>, for "
+          "-profile-use\n"
+          "\n"
+          "The kernel is called through a function type other than its "
+          "own, which is\n"
+          "undefined behaviour that only holds up on x86-64 hosts. It is "
+          "a measurement\n"
+          "tool, not a runtime.\n",
+          Argv0);
+  return;
+}
+
+// All options take a value
+static const char *OptionNames[] = {
+  "-kernel", "-signature", "-in-element", "-out-element", "-size", "-bind",
+  "-threads", "-iterations", "-profile"
+};
+
+static bool IsOption(const std::string &Arg) {
+  for (size_t i = 0, e = sizeof(OptionNames) / sizeof(char*); i != e; i++) {
+    if (Arg == OptionNames[i])
+      return true;
+  }
+  return false;
+}
+
+static bool ParseUnsigned(const char *S, unsigned long &Value) {
+  char *End;
+  Value = strtoul(S, &End, 0);
+  return (*S != '\0') && (*End == '\0');
+}
+
+static bool ParseSize(const char *S, uint32_t &W, uint32_t &H) {
+  char *End;
+  W = strtoul(S, &End, 10);
+  H = 0;
+  if ((End == S) || (W == 0))
+    return false;
+  if (*End == '\0')
+    return true;
+  if (*End != 'x')
+    return false;
+  const char *HS = End + 1;
+  H = strtoul(HS, &End, 10);
+  return (End != HS) && (*End == '\0') && (H > 0);
+}
+
+static bool ParseOptions(int argc, char **argv, Options &Opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string Arg = argv[i];
+    if (Arg[0] != '-') {
+      if (!Opts.Script.empty())
+        return false;
+      Opts.Script = Arg;
+      continue;
+    }
+
+    if (!IsOption(Arg)) {
+      fprintf(stderr, "error: unknown option '%s'\n", Arg.c_str());
+      return false;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "error: missing argument to '%s'\n", Arg.c_str());
+      return false;
+    }
+    const char *Value = argv[++i];
+    unsigned long N;
+
+    if (Arg == "-kernel") {
+      Opts.Kernel = Value;
+    } else if (Arg == "-signature") {
+      if (!ParseUnsigned(Value, N) || (N & ~SIG_All) ||
+          !(N & (SIG_In | SIG_Out)))
+        goto invalid;
+      Opts.Signature = N;
+    } else if (Arg == "-in-element") {
+      if (!ParseUnsigned(Value, N))
+        goto invalid;
+      Opts.InElementSize = N;
+    } else if (Arg == "-out-element") {
+      if (!ParseUnsigned(Value, N))
+        goto invalid;
+      Opts.OutElementSize = N;
+    } else if (Arg == "-size") {
+      uint32_t W, H;
+      if (!ParseSize(Value, W, H))
+        goto invalid;
+      Opts.Sizes.push_back(std::make_pair(W, H));
+    } else if (Arg == "-bind") {
+      const char *Eq = strchr(Value, '=');
+      if ((Eq == NULL) || (Eq == Value) ||
+          (strcmp(Eq + 1, "in") && strcmp(Eq + 1, "out")))
+        goto invalid;
+      Opts.Bindings.push_back(
+          std::make_pair(std::string(Value, Eq - Value), std::string(Eq + 1)));
+    } else if (Arg == "-threads") {
+      if (!ParseUnsigned(Value, N) || (N == 0))
+        goto invalid;
+      Opts.Threads = N;
+    } else if (Arg == "-iterations") {
+      if (!ParseUnsigned(Value, N) || (N == 0))
+        goto invalid;
+      Opts.Iterations = N;
+    } else if (Arg == "-profile") {
+      Opts.ProfileFile = Value;
+    }
+    continue;
+
+ invalid:
+    fprintf(stderr, "error: invalid value '%s' for '%s'\n", Value,
+            Arg.c_str());
+    return false;
+  }
+
+  if (Opts.Script.empty())
+    return false;
+
+  if ((Opts.Signature & SIG_In) && (Opts.InElementSize == 0)) {
+    fprintf(stderr, "error: the kernel takes an input but -in-element is 0\n");
+    return false;
+  }
+  if ((Opts.Signature & SIG_Out) && (Opts.OutElementSize == 0)) {
+    fprintf(stderr, "error: the kernel takes an output but -out-element is "
+                    "0\n");
+    return false;
+  }
+  if (!(Opts.Signature & SIG_In))
+    Opts.InElementSize = 0;
+  if (!(Opts.Signature & SIG_Out))
+    Opts.OutElementSize = 0;
+
+  if (Opts.Sizes.empty()) {
+    Opts.Sizes.push_back(std::make_pair(256, 256));
+    Opts.Sizes.push_back(std::make_pair(1024, 1024));
+    Opts.Sizes.push_back(std::make_pair(2048, 2048));
+  }
+
+  if (Opts.Threads == 0) {
+    long CPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    Opts.Threads = (CPUs > 0) ? CPUs : 1;
+  }
+
+  return true;
+}
+
+// Write the counts of a script compiled with -profile-generate to @File, in
+// the format that llvm-rs-cc -profile-use reads (see RSProfile)
+static bool WriteProfile(void *Script, const std::string &File) {
+  const uint64_t *Counters =
+      static_cast<const uint64_t*>(dlsym(Script, RS_PROFILE_COUNTERS_NAME));
+  const char *Layout =
+      static_cast<const char*>(dlsym(Script, RS_PROFILE_LAYOUT_NAME));
+  if ((Counters == NULL) || (Layout == NULL)) {
+    fprintf(stderr, "error: the script was not compiled with "
+                    "-profile-generate\n");
+    return false;
+  }
+
+  FILE *F = fopen(File.c_str(), "w");
+  if (F == NULL) {
+    fprintf(stderr, "error: cannot write profile '%s': %s\n", File.c_str(),
+            strerror(errno));
+    return false;
+  }
+
+  fprintf(F, "# Written by rs-host-bench\n");
+  while (*Layout != '\0') {
+    // function <name> <blocks> <branches>
+    const char *End = strchr(Layout, '\n');
+    if (End == NULL)
+      End = Layout + strlen(Layout);
+    std::string Line(Layout, End - Layout);
+    Layout = (*End != '\0') ? (End + 1) : End;
+
+    unsigned Blocks, Branches;
+    if (sscanf(Line.c_str(), "function %*s %u %u", &Blocks, &Branches) != 2)
+      break;
+
+    fprintf(F, "%s\n", Line.c_str());
+    for (unsigned i = 0, e = Blocks + Branches; i != e; i++)
+      fprintf(F, (i > 0) ? " %llu" : "%llu",
+              static_cast<unsigned long long>(*Counters++));
+    fprintf(F, "\n");
+  }
+
+  if (fclose(F) != 0) {
+    fprintf(stderr, "error: cannot write profile '%s': %s\n", File.c_str(),
+            strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+#if !defined(__x86_64__)
+  // See KernelFunc
+  fprintf(stderr, "error: rs-host-bench only runs kernels on x86-64 hosts\n");
+  return 1;
+#endif
+
+  Options Opts;
+  if (!ParseOptions(argc, argv, Opts)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  // The script resolves the runtime functions against this executable
+  void *Script = dlopen(Opts.Script.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (Script == NULL) {
+    fprintf(stderr, "error: cannot load script: %s\n", dlerror());
+    return 1;
+  }
+
+  KernelFunc Kernel =
+      reinterpret_cast<KernelFunc>(dlsym(Script, Opts.Kernel.c_str()));
+  if (Kernel == NULL) {
+    fprintf(stderr, "error: no kernel '%s' in '%s'\n", Opts.Kernel.c_str(),
+            Opts.Script.c_str());
+    return 1;
+  }
+
+  std::vector<rs_allocation*> Bound;
+  for (unsigned i = 0, e = Opts.Bindings.size(); i != e; i++) {
+    void *Var = dlsym(Script, Opts.Bindings[i].first.c_str());
+    if (Var == NULL) {
+      fprintf(stderr, "error: no global '%s' in '%s'\n",
+              Opts.Bindings[i].first.c_str(), Opts.Script.c_str());
+      return 1;
+    }
+    Bound.push_back(static_cast<rs_allocation*>(Var));
+  }
+
+  if (InitFunc Init = reinterpret_cast<InitFunc>(dlsym(Script, "init")))
+    Init();
+
+  ThreadPool Pool(Opts.Threads);
+  printf("%s: %u threads, %u iterations\n", Opts.Kernel.c_str(),
+         Pool.getNumThreads(), Opts.Iterations);
+
+  for (unsigned s = 0, se = Opts.Sizes.size(); s != se; s++) {
+    uint32_t W = Opts.Sizes[s].first;
+    uint32_t H = Opts.Sizes[s].second;
+
+    RSHostAllocation *In = NULL;
+    RSHostAllocation *Out = NULL;
+    if (Opts.InElementSize > 0) {
+      In = new RSHostAllocation(Opts.InElementSize, W, H, 0);
+      // Something other than zeros, the same on every run
+      uint8_t *Data = In->getData();
+      for (size_t i = 0, e = In->getCount() * Opts.InElementSize; i != e; i++)
+        Data[i] = static_cast<uint8_t>((i * 7 + (i >> 8)) & 0xff);
+    }
+    if (Opts.OutElementSize > 0)
+      Out = new RSHostAllocation(Opts.OutElementSize, W, H, 0);
+
+    for (unsigned i = 0, e = Bound.size(); i != e; i++) {
+      RSHostAllocation *A = (Opts.Bindings[i].second == "in") ? In : Out;
+      if (A == NULL) {
+        fprintf(stderr, "error: no %s allocation to bind '%s' to\n",
+                Opts.Bindings[i].second.c_str(),
+                Opts.Bindings[i].first.c_str());
+        return 1;
+      }
+      *Bound[i] = A->getHandle();
+    }
+
+    Launch L(Kernel, Opts.Signature, In, Out);
+
+    // Once untimed, to warm up the caches
+    Pool.run(L);
+
+    std::vector<double> Times;
+    for (unsigned i = 0; i < Opts.Iterations; i++) {
+      double Start = Now();
+      Pool.run(L);
+      Times.push_back(Now() - Start);
+    }
+    std::sort(Times.begin(), Times.end());
+
+    double Median = Times[Times.size() / 2];
+    double Elements = static_cast<double>(W) * ((H > 0) ? H : 1);
+    if (H > 0)
+      printf("  %ux%u:", W, H);
+    else
+      printf("  %u:", W);
+    printf(" min %.3f ms, median %.3f ms, %.1f Melements/s",
+           Times.front(), Median, Elements / (Median * 1e3));
+    if (Out != NULL)
+      printf(", checksum %08x", Checksum(Out));
+    printf("\n");
+
+    delete In;
+    delete Out;
+  }
+
+  if (!Opts.ProfileFile.empty() && !WriteProfile(Script, Opts.ProfileFile))
+    return 1;
+
+  return 0;
+}
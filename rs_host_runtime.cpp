@@ -0,0 +1,271 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rs_host_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// The subset of the Renderscript runtime API that scripts compiled for the
+// host (llvm-rs-cc -host-target) can call when run by rs-host-bench. These are
+// declared with the same (overloaded, hence C++-mangled) signatures as in the
+// rs_*.rsh headers, and resolved against the rs-host-bench executable when it
+// loads the script. A script calling anything else fails to load, with the
+// dynamic linker naming the missing function.
+//
+// Do not include <math.h> here: it would clash with the float overloads of
+// the math functions below.
+
+namespace slang {
+
+RSHostAllocation::RSHostAllocation(size_t ElementSize,
+                                   uint32_t DimX,
+                                   uint32_t DimY,
+                                   uint32_t DimZ)
+    : mElementSize(ElementSize),
+      mDimX(DimX),
+      mDimY(DimY),
+      mDimZ(DimZ),
+      mData(NULL) {
+  // Kernels commonly load and store whole vectors, so align the data as the
+  // runtime does
+  if (posix_memalign(reinterpret_cast<void**>(&mData), 16,
+                     getCount() * mElementSize + 1) != 0) {
+    fprintf(stderr, "out of memory allocating %ux%ux%u elements of %zu "
+                    "bytes\n", DimX, DimY, DimZ, ElementSize);
+    abort();
+  }
+  memset(mData, 0, getCount() * mElementSize);
+  return;
+}
+
+RSHostAllocation::~RSHostAllocation() {
+  free(mData);
+  return;
+}
+
+size_t RSHostAllocation::getCount() const {
+  size_t Count = mDimX;
+  if (mDimY > 0)
+    Count *= mDimY;
+  if (mDimZ > 0)
+    Count *= mDimZ;
+  return Count;
+}
+
+void *RSHostAllocation::getElement(uint32_t X, uint32_t Y, uint32_t Z) {
+  uint32_t DimY = (mDimY > 0) ? mDimY : 1;
+  uint32_t DimZ = (mDimZ > 0) ? mDimZ : 1;
+  if ((X >= mDimX) || (Y >= DimY) || (Z >= DimZ)) {
+    fprintf(stderr, "element (%u, %u, %u) is out of bounds of a %ux%ux%u "
+                    "allocation\n", X, Y, Z, mDimX, mDimY, mDimZ);
+    abort();
+  }
+  return mData + ((static_cast<size_t>(Z) * DimY + Y) * mDimX + X) *
+                 mElementSize;
+}
+
+rs_allocation RSHostAllocation::getHandle() {
+  rs_allocation A;
+  A.p = reinterpret_cast<const int*>(this);
+  return A;
+}
+
+RSHostAllocation *RSHostAllocation::Get(rs_allocation A) {
+  return reinterpret_cast<RSHostAllocation*>(const_cast<int*>(A.p));
+}
+
+}  // namespace slang
+
+using slang::RSHostAllocation;
+
+static RSHostAllocation *GetAllocation(rs_allocation A, const char *Caller) {
+  RSHostAllocation *Alloc = RSHostAllocation::Get(A);
+  if (Alloc == NULL) {
+    fprintf(stderr, "%s() called with an allocation that is not bound\n",
+            Caller);
+    abort();
+  }
+  return Alloc;
+}
+
+//===----------------------------------------------------------------------===//
+// rs_allocation.rsh
+//===----------------------------------------------------------------------===//
+
+const void *rsGetElementAt(rs_allocation A, uint32_t x) {
+  return GetAllocation(A, "rsGetElementAt")->getElement(x, 0, 0);
+}
+
+const void *rsGetElementAt(rs_allocation A, uint32_t x, uint32_t y) {
+  return GetAllocation(A, "rsGetElementAt")->getElement(x, y, 0);
+}
+
+const void *rsGetElementAt(rs_allocation A,
+                           uint32_t x,
+                           uint32_t y,
+                           uint32_t z) {
+  return GetAllocation(A, "rsGetElementAt")->getElement(x, y, z);
+}
+
+uint32_t rsAllocationGetDimX(rs_allocation A) {
+  return GetAllocation(A, "rsAllocationGetDimX")->getDimX();
+}
+
+uint32_t rsAllocationGetDimY(rs_allocation A) {
+  return GetAllocation(A, "rsAllocationGetDimY")->getDimY();
+}
+
+uint32_t rsAllocationGetDimZ(rs_allocation A) {
+  return GetAllocation(A, "rsAllocationGetDimZ")->getDimZ();
+}
+
+uint32_t rsAllocationGetDimLOD(rs_allocation A) {
+  return 0;
+}
+
+uint32_t rsAllocationGetDimFaces(rs_allocation A) {
+  return 0;
+}
+
+void rsAllocationMarkDirty(rs_allocation A) {
+  return;
+}
+
+//===----------------------------------------------------------------------===//
+// rs_object.rsh
+//===----------------------------------------------------------------------===//
+
+// The allocations belong to rs-host-bench, so there are no reference counts
+// to maintain
+
+void rsSetObject(rs_allocation *Dst, rs_allocation Src) {
+  *Dst = Src;
+  return;
+}
+
+void rsClearObject(rs_allocation *Dst) {
+  Dst->p = NULL;
+  return;
+}
+
+bool rsIsObject(rs_allocation A) {
+  return (A.p != NULL);
+}
+
+//===----------------------------------------------------------------------===//
+// rs_debug.rsh
+//===----------------------------------------------------------------------===//
+
+void rsDebug(const char *S, float F) {
+  printf("%s %f\n", S, F);
+}
+
+void rsDebug(const char *S, double D) {
+  printf("%s %f\n", S, D);
+}
+
+void rsDebug(const char *S, int I) {
+  printf("%s %d\n", S, I);
+}
+
+void rsDebug(const char *S, unsigned int I) {
+  printf("%s %u\n", S, I);
+}
+
+void rsDebug(const char *S, long L) {
+  printf("%s %ld\n", S, L);
+}
+
+void rsDebug(const char *S, unsigned long L) {
+  printf("%s %lu\n", S, L);
+}
+
+void rsDebug(const char *S, const void *P) {
+  printf("%s %p\n", S, P);
+}
+
+//===----------------------------------------------------------------------===//
+// rs_time.rsh
+//===----------------------------------------------------------------------===//
+
+int64_t rsUptimeNanos() {
+  struct timespec T;
+  clock_gettime(CLOCK_MONOTONIC, &T);
+  return static_cast<int64_t>(T.tv_sec) * 1000000000 + T.tv_nsec;
+}
+
+int64_t rsUptimeMillis() {
+  return rsUptimeNanos() / 1000000;
+}
+
+//===----------------------------------------------------------------------===//
+// rs_cl.rsh (the scalar float functions the optimizer leaves as calls)
+//===----------------------------------------------------------------------===//
+
+#define RS_HOST_UNARY_MATH(Name)  \
+  float Name(float V) {           \
+    return __builtin_##Name##f(V);  \
+  }
+
+#define RS_HOST_BINARY_MATH(Name)       \
+  float Name(float V1, float V2) {      \
+    return __builtin_##Name##f(V1, V2);   \
+  }
+
+RS_HOST_UNARY_MATH(acos)
+RS_HOST_UNARY_MATH(asin)
+RS_HOST_UNARY_MATH(atan)
+RS_HOST_UNARY_MATH(ceil)
+RS_HOST_UNARY_MATH(cos)
+RS_HOST_UNARY_MATH(cosh)
+RS_HOST_UNARY_MATH(exp)
+RS_HOST_UNARY_MATH(exp2)
+RS_HOST_UNARY_MATH(fabs)
+RS_HOST_UNARY_MATH(floor)
+RS_HOST_UNARY_MATH(log)
+RS_HOST_UNARY_MATH(log10)
+RS_HOST_UNARY_MATH(log2)
+RS_HOST_UNARY_MATH(round)
+RS_HOST_UNARY_MATH(sin)
+RS_HOST_UNARY_MATH(sinh)
+RS_HOST_UNARY_MATH(sqrt)
+RS_HOST_UNARY_MATH(tan)
+RS_HOST_UNARY_MATH(tanh)
+RS_HOST_UNARY_MATH(trunc)
+
+RS_HOST_BINARY_MATH(atan2)
+RS_HOST_BINARY_MATH(fmax)
+RS_HOST_BINARY_MATH(fmin)
+RS_HOST_BINARY_MATH(fmod)
+RS_HOST_BINARY_MATH(pow)
+
+#undef RS_HOST_UNARY_MATH
+#undef RS_HOST_BINARY_MATH
+
+float rsqrt(float V) {
+  return 1.0f / __builtin_sqrtf(V);
+}
+
+float clamp(float Amount, float Low, float High) {
+  return (Amount < Low) ? Low : ((Amount > High) ? High : Amount);
+}
+
+float mix(float Start, float Stop, float Amount) {
+  return Start + (Stop - Start) * Amount;
+}
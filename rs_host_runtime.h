@@ -0,0 +1,74 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_RS_HOST_RUNTIME_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_RS_HOST_RUNTIME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The handle scripts hold to an allocation. It has the layout and (mangled)
+// name of the one in rs_types.rsh, so the runtime functions below link with
+// scripts compiled by llvm-rs-cc -host-target. Here p points to an
+// RSHostAllocation.
+struct rs_allocation {
+  const int *p;
+};
+
+namespace slang {
+
+// An allocation in host memory, standing in for the runtime's. Like the
+// runtime's, the dimensions that an allocation does not have are 0 (e.g. DimY
+// and DimZ of a 1D allocation).
+class RSHostAllocation {
+ private:
+  size_t mElementSize;
+  uint32_t mDimX;
+  uint32_t mDimY;
+  uint32_t mDimZ;
+  uint8_t *mData;
+
+ public:
+  RSHostAllocation(size_t ElementSize,
+                   uint32_t DimX,
+                   uint32_t DimY,
+                   uint32_t DimZ);
+  ~RSHostAllocation();
+
+  inline size_t getElementSize() const { return mElementSize; }
+  inline uint32_t getDimX() const { return mDimX; }
+  inline uint32_t getDimY() const { return mDimY; }
+  inline uint32_t getDimZ() const { return mDimZ; }
+
+  // The number of elements
+  size_t getCount() const;
+
+  inline uint8_t *getData() { return mData; }
+  inline const uint8_t *getData() const { return mData; }
+
+  // The element at (@X, @Y, @Z). Aborts if it is out of bounds, as the
+  // runtime would only log it and hand out a pointer to whatever is there.
+  void *getElement(uint32_t X, uint32_t Y, uint32_t Z);
+
+  rs_allocation getHandle();
+
+  // The allocation @A is a handle to (NULL for a cleared handle)
+  static RSHostAllocation *Get(rs_allocation A);
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_RS_HOST_RUNTIME_H_  NOLINT
@@ -0,0 +1,816 @@
+; Vectorized implementations of common float2/float3/float4 math builtins from
+; rs_cl.rsh and of rsMatrixMultiply() from rs_matrix.rsh. llvm-rs-link links
+; these into every script, so they replace the per-component versions in the
+; device runtime and get inlined into kernels.
+;
+; The float4 versions do the work; the float2 and float3 versions pad their
+; arguments with 1.0 and call them. exp, log, sin and cos use the Cephes
+; single-precision polynomials; sin, cos and pow fall back to the llvm.*
+; intrinsics (i.e. the device libm) for arguments outside the range in which
+; the polynomials are accurate.
+
+%struct.rs_matrix4x4 = type { [16 x float] }
+%struct.rs_matrix3x3 = type { [9 x float] }
+%struct.rs_matrix2x2 = type { [4 x float] }
+
+declare <4 x float> @llvm.sqrt.v4f32(<4 x float>) nounwind readonly
+declare <4 x float> @llvm.sin.v4f32(<4 x float>) nounwind readonly
+declare <4 x float> @llvm.cos.v4f32(<4 x float>) nounwind readonly
+declare <4 x float> @llvm.pow.v4f32(<4 x float>, <4 x float>) nounwind readonly
+
+; Whether any lane of %m is set
+define internal i1 @__rs_any4(<4 x i1> %m) nounwind readnone alwaysinline {
+  %s = sext <4 x i1> %m to <4 x i32>
+  %s0 = extractelement <4 x i32> %s, i32 0
+  %s1 = extractelement <4 x i32> %s, i32 1
+  %s2 = extractelement <4 x i32> %s, i32 2
+  %s3 = extractelement <4 x i32> %s, i32 3
+  %o01 = or i32 %s0, %s1
+  %o23 = or i32 %s2, %s3
+  %o = or i32 %o01, %o23
+  %any = icmp ne i32 %o, 0
+  ret i1 %any
+}
+
+define internal <4 x float> @__rs_fabs4(<4 x float> %x) nounwind readnone alwaysinline {
+  %b = bitcast <4 x float> %x to <4 x i32>
+  %a = and <4 x i32> %b, <i32 2147483647, i32 2147483647, i32 2147483647, i32 2147483647>
+  %r = bitcast <4 x i32> %a to <4 x float>
+  ret <4 x float> %r
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; exp
+
+define <4 x float> @_Z3expDv4_f(<4 x float> %x) nounwind readnone {
+  ; Keep n = round(x / ln(2)) within [-150, 128]
+  %lo = fcmp olt <4 x float> %x, <float -104.0, float -104.0, float -104.0, float -104.0>
+  %x1 = select <4 x i1> %lo, <4 x float> <float -104.0, float -104.0, float -104.0, float -104.0>, <4 x float> %x
+  %hi = fcmp ogt <4 x float> %x1, <float 89.0, float 89.0, float 89.0, float 89.0>
+  %xc = select <4 x i1> %hi, <4 x float> <float 89.0, float 89.0, float 89.0, float 89.0>, <4 x float> %x1
+
+  ; n = floor(x * log2(e) + 0.5)
+  %t0 = fmul <4 x float> %xc, <float 0x3FF7154760000000, float 0x3FF7154760000000, float 0x3FF7154760000000, float 0x3FF7154760000000>
+  %t1 = fadd <4 x float> %t0, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %ti = fptosi <4 x float> %t1 to <4 x i32>
+  %tf = sitofp <4 x i32> %ti to <4 x float>
+  %up = fcmp ogt <4 x float> %tf, %t1
+  %adj = sext <4 x i1> %up to <4 x i32>
+  %n = add <4 x i32> %ti, %adj
+  %nf = sitofp <4 x i32> %n to <4 x float>
+
+  ; r = x - n * ln(2), with ln(2) split in two parts
+  %c1 = fmul <4 x float> %nf, <float 0.693359375, float 0.693359375, float 0.693359375, float 0.693359375>
+  %r0 = fsub <4 x float> %xc, %c1
+  %c2 = fmul <4 x float> %nf, <float 0xBF2BD01060000000, float 0xBF2BD01060000000, float 0xBF2BD01060000000, float 0xBF2BD01060000000>
+  %r = fsub <4 x float> %r0, %c2
+
+  ; exp(r) = 1 + r + r^2 * P(r)
+  %z = fmul <4 x float> %r, %r
+  %p0 = fmul <4 x float> %r, <float 0x3F2A0D2CE0000000, float 0x3F2A0D2CE0000000, float 0x3F2A0D2CE0000000, float 0x3F2A0D2CE0000000>
+  %p1 = fadd <4 x float> %p0, <float 0x3F56E879C0000000, float 0x3F56E879C0000000, float 0x3F56E879C0000000, float 0x3F56E879C0000000>
+  %p2 = fmul <4 x float> %p1, %r
+  %p3 = fadd <4 x float> %p2, <float 0x3F81112100000000, float 0x3F81112100000000, float 0x3F81112100000000, float 0x3F81112100000000>
+  %p4 = fmul <4 x float> %p3, %r
+  %p5 = fadd <4 x float> %p4, <float 0x3FA5553820000000, float 0x3FA5553820000000, float 0x3FA5553820000000, float 0x3FA5553820000000>
+  %p6 = fmul <4 x float> %p5, %r
+  %p7 = fadd <4 x float> %p6, <float 0x3FC5555540000000, float 0x3FC5555540000000, float 0x3FC5555540000000, float 0x3FC5555540000000>
+  %p8 = fmul <4 x float> %p7, %r
+  %p9 = fadd <4 x float> %p8, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %p10 = fmul <4 x float> %p9, %z
+  %p11 = fadd <4 x float> %p10, %r
+  %y = fadd <4 x float> %p11, <float 1.0, float 1.0, float 1.0, float 1.0>
+
+  ; y * 2^n, scaled in two steps so that both factors are normal numbers
+  %nh = ashr <4 x i32> %n, <i32 1, i32 1, i32 1, i32 1>
+  %nl = sub <4 x i32> %n, %nh
+  %eh0 = add <4 x i32> %nh, <i32 127, i32 127, i32 127, i32 127>
+  %eh = shl <4 x i32> %eh0, <i32 23, i32 23, i32 23, i32 23>
+  %sh = bitcast <4 x i32> %eh to <4 x float>
+  %el0 = add <4 x i32> %nl, <i32 127, i32 127, i32 127, i32 127>
+  %el = shl <4 x i32> %el0, <i32 23, i32 23, i32 23, i32 23>
+  %sl = bitcast <4 x i32> %el to <4 x float>
+  %y1 = fmul <4 x float> %y, %sh
+  %y2 = fmul <4 x float> %y1, %sl
+
+  ; Overflow, underflow and NaN
+  %of = fcmp ogt <4 x float> %x, <float 0x40562E4300000000, float 0x40562E4300000000, float 0x40562E4300000000, float 0x40562E4300000000>
+  %y3 = select <4 x i1> %of, <4 x float> <float 0x7FF0000000000000, float 0x7FF0000000000000, float 0x7FF0000000000000, float 0x7FF0000000000000>, <4 x float> %y2
+  %uf = fcmp olt <4 x float> %x, <float 0xC059FE3680000000, float 0xC059FE3680000000, float 0xC059FE3680000000, float 0xC059FE3680000000>
+  %y4 = select <4 x i1> %uf, <4 x float> zeroinitializer, <4 x float> %y3
+  %nan = fcmp uno <4 x float> %x, %x
+  %res = select <4 x i1> %nan, <4 x float> %x, <4 x float> %y4
+  ret <4 x float> %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; log
+
+define <4 x float> @_Z3logDv4_f(<4 x float> %x) nounwind readnone {
+  ; Scale denormals into the normal range
+  %den = fcmp olt <4 x float> %x, <float 0x3810000000000000, float 0x3810000000000000, float 0x3810000000000000, float 0x3810000000000000>
+  %xs = fmul <4 x float> %x, <float 8388608.0, float 8388608.0, float 8388608.0, float 8388608.0>
+  %xn = select <4 x i1> %den, <4 x float> %xs, <4 x float> %x
+  %eadj = select <4 x i1> %den, <4 x float> <float -23.0, float -23.0, float -23.0, float -23.0>, <4 x float> zeroinitializer
+
+  ; x = m * 2^e with m in [0.5, 1)
+  %bits = bitcast <4 x float> %xn to <4 x i32>
+  %eb = lshr <4 x i32> %bits, <i32 23, i32 23, i32 23, i32 23>
+  %ei = sub <4 x i32> %eb, <i32 126, i32 126, i32 126, i32 126>
+  %mb0 = and <4 x i32> %bits, <i32 -2139095041, i32 -2139095041, i32 -2139095041, i32 -2139095041>
+  %mb = or <4 x i32> %mb0, <i32 1056964608, i32 1056964608, i32 1056964608, i32 1056964608>
+  %m = bitcast <4 x i32> %mb to <4 x float>
+  %ef0 = sitofp <4 x i32> %ei to <4 x float>
+  %ef = fadd <4 x float> %ef0, %eadj
+
+  ; f = 2m - 1 and e = e - 1 if m < sqrt(1/2), f = m - 1 otherwise
+  %small = fcmp olt <4 x float> %m, <float 0x3FE6A09E60000000, float 0x3FE6A09E60000000, float 0x3FE6A09E60000000, float 0x3FE6A09E60000000>
+  %smalli = sext <4 x i1> %small to <4 x i32>
+  %smallf = sitofp <4 x i32> %smalli to <4 x float>
+  %e = fadd <4 x float> %ef, %smallf
+  %mi = bitcast <4 x float> %m to <4 x i32>
+  %maddi = and <4 x i32> %mi, %smalli
+  %madd = bitcast <4 x i32> %maddi to <4 x float>
+  %m1 = fsub <4 x float> %m, <float 1.0, float 1.0, float 1.0, float 1.0>
+  %f = fadd <4 x float> %m1, %madd
+
+  ; log(1 + f) = f - f^2 / 2 + f^3 * P(f)
+  %z = fmul <4 x float> %f, %f
+  %q0 = fmul <4 x float> %f, <float 0x3FB2043760000000, float 0x3FB2043760000000, float 0x3FB2043760000000, float 0x3FB2043760000000>
+  %q1 = fadd <4 x float> %q0, <float 0xBFBD7A3700000000, float 0xBFBD7A3700000000, float 0xBFBD7A3700000000, float 0xBFBD7A3700000000>
+  %q2 = fmul <4 x float> %q1, %f
+  %q3 = fadd <4 x float> %q2, <float 0x3FBDE4A340000000, float 0x3FBDE4A340000000, float 0x3FBDE4A340000000, float 0x3FBDE4A340000000>
+  %q4 = fmul <4 x float> %q3, %f
+  %q5 = fadd <4 x float> %q4, <float 0xBFBFCBA9E0000000, float 0xBFBFCBA9E0000000, float 0xBFBFCBA9E0000000, float 0xBFBFCBA9E0000000>
+  %q6 = fmul <4 x float> %q5, %f
+  %q7 = fadd <4 x float> %q6, <float 0x3FC23D37E0000000, float 0x3FC23D37E0000000, float 0x3FC23D37E0000000, float 0x3FC23D37E0000000>
+  %q8 = fmul <4 x float> %q7, %f
+  %q9 = fadd <4 x float> %q8, <float 0xBFC555CA00000000, float 0xBFC555CA00000000, float 0xBFC555CA00000000, float 0xBFC555CA00000000>
+  %q10 = fmul <4 x float> %q9, %f
+  %q11 = fadd <4 x float> %q10, <float 0x3FC999D580000000, float 0x3FC999D580000000, float 0x3FC999D580000000, float 0x3FC999D580000000>
+  %q12 = fmul <4 x float> %q11, %f
+  %q13 = fadd <4 x float> %q12, <float 0xBFCFFFFF80000000, float 0xBFCFFFFF80000000, float 0xBFCFFFFF80000000, float 0xBFCFFFFF80000000>
+  %q14 = fmul <4 x float> %q13, %f
+  %q15 = fadd <4 x float> %q14, <float 0x3FD5555540000000, float 0x3FD5555540000000, float 0x3FD5555540000000, float 0x3FD5555540000000>
+  %y0 = fmul <4 x float> %q15, %f
+  %y1 = fmul <4 x float> %y0, %z
+  %t0 = fmul <4 x float> %e, <float 0xBF2BD01060000000, float 0xBF2BD01060000000, float 0xBF2BD01060000000, float 0xBF2BD01060000000>
+  %y2 = fadd <4 x float> %y1, %t0
+  %hz = fmul <4 x float> %z, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %y3 = fsub <4 x float> %y2, %hz
+  %r0 = fadd <4 x float> %f, %y3
+  %t1 = fmul <4 x float> %e, <float 0.693359375, float 0.693359375, float 0.693359375, float 0.693359375>
+  %r1 = fadd <4 x float> %r0, %t1
+
+  ; Negative numbers, zero, infinity and NaN
+  %neg = fcmp olt <4 x float> %x, zeroinitializer
+  %r2 = select <4 x i1> %neg, <4 x float> <float 0x7FF8000000000000, float 0x7FF8000000000000, float 0x7FF8000000000000, float 0x7FF8000000000000>, <4 x float> %r1
+  %zero = fcmp oeq <4 x float> %x, zeroinitializer
+  %r3 = select <4 x i1> %zero, <4 x float> <float 0xFFF0000000000000, float 0xFFF0000000000000, float 0xFFF0000000000000, float 0xFFF0000000000000>, <4 x float> %r2
+  %inf = fcmp oeq <4 x float> %x, <float 0x7FF0000000000000, float 0x7FF0000000000000, float 0x7FF0000000000000, float 0x7FF0000000000000>
+  %r4 = select <4 x i1> %inf, <4 x float> <float 0x7FF0000000000000, float 0x7FF0000000000000, float 0x7FF0000000000000, float 0x7FF0000000000000>, <4 x float> %r3
+  %isnan = fcmp uno <4 x float> %x, %x
+  %res = select <4 x i1> %isnan, <4 x float> %x, <4 x float> %r4
+  ret <4 x float> %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; sin and cos
+
+; sin(r) for the lanes set in %sin and cos(r) for the others, |r| <= pi/4
+define internal <4 x float> @__rs_sincos_poly4(<4 x float> %r, <4 x i1> %sin) nounwind readnone alwaysinline {
+  %z = fmul <4 x float> %r, %r
+
+  ; cos(r) = 1 - z / 2 + z^2 * C(z)
+  %c0 = fmul <4 x float> %z, <float 0x3EF99EB9C0000000, float 0x3EF99EB9C0000000, float 0x3EF99EB9C0000000, float 0x3EF99EB9C0000000>
+  %c1 = fadd <4 x float> %c0, <float 0xBF56C0C340000000, float 0xBF56C0C340000000, float 0xBF56C0C340000000, float 0xBF56C0C340000000>
+  %c2 = fmul <4 x float> %c1, %z
+  %c3 = fadd <4 x float> %c2, <float 0x3FA55554A0000000, float 0x3FA55554A0000000, float 0x3FA55554A0000000, float 0x3FA55554A0000000>
+  %c4 = fmul <4 x float> %c3, %z
+  %c5 = fmul <4 x float> %c4, %z
+  %hz = fmul <4 x float> %z, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %c6 = fsub <4 x float> %c5, %hz
+  %cosr = fadd <4 x float> %c6, <float 1.0, float 1.0, float 1.0, float 1.0>
+
+  ; sin(r) = r + r * z * S(z)
+  %s0 = fmul <4 x float> %z, <float 0xBF29943F20000000, float 0xBF29943F20000000, float 0xBF29943F20000000, float 0xBF29943F20000000>
+  %s1 = fadd <4 x float> %s0, <float 0x3F811073C0000000, float 0x3F811073C0000000, float 0x3F811073C0000000, float 0x3F811073C0000000>
+  %s2 = fmul <4 x float> %s1, %z
+  %s3 = fadd <4 x float> %s2, <float 0xBFC5555460000000, float 0xBFC5555460000000, float 0xBFC5555460000000, float 0xBFC5555460000000>
+  %s4 = fmul <4 x float> %s3, %z
+  %s5 = fmul <4 x float> %s4, %r
+  %sinr = fadd <4 x float> %s5, %r
+
+  %res = select <4 x i1> %sin, <4 x float> %sinr, <4 x float> %cosr
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z3sinDv4_f(<4 x float> %x) nounwind readnone {
+entry:
+  %ax = call <4 x float> @__rs_fabs4(<4 x float> %x)
+  ; The argument reduction below loses accuracy for large arguments
+  %big = fcmp ugt <4 x float> %ax, <float 8192.0, float 8192.0, float 8192.0, float 8192.0>
+  %anybig = call i1 @__rs_any4(<4 x i1> %big)
+  br i1 %anybig, label %slow, label %fast
+
+slow:
+  %slowres = call <4 x float> @llvm.sin.v4f32(<4 x float> %x)
+  ret <4 x float> %slowres
+
+fast:
+  ; j = |x| / (pi / 4), rounded up to an even number
+  %y0 = fmul <4 x float> %ax, <float 0x3FF45F3060000000, float 0x3FF45F3060000000, float 0x3FF45F3060000000, float 0x3FF45F3060000000>
+  %j0 = fptosi <4 x float> %y0 to <4 x i32>
+  %j1 = add <4 x i32> %j0, <i32 1, i32 1, i32 1, i32 1>
+  %j = and <4 x i32> %j1, <i32 -2, i32 -2, i32 -2, i32 -2>
+  %yf = sitofp <4 x i32> %j to <4 x float>
+
+  ; Octants 4-7 flip the sign; octants 2-3 and 6-7 use the cos polynomial
+  %xb = bitcast <4 x float> %x to <4 x i32>
+  %sign0 = and <4 x i32> %xb, <i32 -2147483648, i32 -2147483648, i32 -2147483648, i32 -2147483648>
+  %j4 = and <4 x i32> %j, <i32 4, i32 4, i32 4, i32 4>
+  %swap = shl <4 x i32> %j4, <i32 29, i32 29, i32 29, i32 29>
+  %sign = xor <4 x i32> %sign0, %swap
+  %j2 = and <4 x i32> %j, <i32 2, i32 2, i32 2, i32 2>
+  %usesin = icmp eq <4 x i32> %j2, zeroinitializer
+
+  ; r = |x| - j * pi / 4, with pi / 4 split in three parts
+  %d1 = fmul <4 x float> %yf, <float -0.78515625, float -0.78515625, float -0.78515625, float -0.78515625>
+  %r0 = fadd <4 x float> %ax, %d1
+  %d2 = fmul <4 x float> %yf, <float 0xBF2FB40000000000, float 0xBF2FB40000000000, float 0xBF2FB40000000000, float 0xBF2FB40000000000>
+  %r1 = fadd <4 x float> %r0, %d2
+  %d3 = fmul <4 x float> %yf, <float 0xBE64442D20000000, float 0xBE64442D20000000, float 0xBE64442D20000000, float 0xBE64442D20000000>
+  %r = fadd <4 x float> %r1, %d3
+
+  %p = call <4 x float> @__rs_sincos_poly4(<4 x float> %r, <4 x i1> %usesin)
+  %pb = bitcast <4 x float> %p to <4 x i32>
+  %resb = xor <4 x i32> %pb, %sign
+  %res = bitcast <4 x i32> %resb to <4 x float>
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z3cosDv4_f(<4 x float> %x) nounwind readnone {
+entry:
+  %ax = call <4 x float> @__rs_fabs4(<4 x float> %x)
+  ; The argument reduction below loses accuracy for large arguments
+  %big = fcmp ugt <4 x float> %ax, <float 8192.0, float 8192.0, float 8192.0, float 8192.0>
+  %anybig = call i1 @__rs_any4(<4 x i1> %big)
+  br i1 %anybig, label %slow, label %fast
+
+slow:
+  %slowres = call <4 x float> @llvm.cos.v4f32(<4 x float> %x)
+  ret <4 x float> %slowres
+
+fast:
+  ; j = |x| / (pi / 4), rounded up to an even number
+  %y0 = fmul <4 x float> %ax, <float 0x3FF45F3060000000, float 0x3FF45F3060000000, float 0x3FF45F3060000000, float 0x3FF45F3060000000>
+  %j0 = fptosi <4 x float> %y0 to <4 x i32>
+  %j1 = add <4 x i32> %j0, <i32 1, i32 1, i32 1, i32 1>
+  %j = and <4 x i32> %j1, <i32 -2, i32 -2, i32 -2, i32 -2>
+  %yf = sitofp <4 x i32> %j to <4 x float>
+
+  ; cos(x) = sin(x + pi / 2), i.e. shift by two octants
+  %jc = sub <4 x i32> %j, <i32 2, i32 2, i32 2, i32 2>
+  %njc = xor <4 x i32> %jc, <i32 -1, i32 -1, i32 -1, i32 -1>
+  %j4 = and <4 x i32> %njc, <i32 4, i32 4, i32 4, i32 4>
+  %sign = shl <4 x i32> %j4, <i32 29, i32 29, i32 29, i32 29>
+  %j2 = and <4 x i32> %jc, <i32 2, i32 2, i32 2, i32 2>
+  %usesin = icmp eq <4 x i32> %j2, zeroinitializer
+
+  ; r = |x| - j * pi / 4, with pi / 4 split in three parts
+  %d1 = fmul <4 x float> %yf, <float -0.78515625, float -0.78515625, float -0.78515625, float -0.78515625>
+  %r0 = fadd <4 x float> %ax, %d1
+  %d2 = fmul <4 x float> %yf, <float 0xBF2FB40000000000, float 0xBF2FB40000000000, float 0xBF2FB40000000000, float 0xBF2FB40000000000>
+  %r1 = fadd <4 x float> %r0, %d2
+  %d3 = fmul <4 x float> %yf, <float 0xBE64442D20000000, float 0xBE64442D20000000, float 0xBE64442D20000000, float 0xBE64442D20000000>
+  %r = fadd <4 x float> %r1, %d3
+
+  %p = call <4 x float> @__rs_sincos_poly4(<4 x float> %r, <4 x i1> %usesin)
+  %pb = bitcast <4 x float> %p to <4 x i32>
+  %resb = xor <4 x i32> %pb, %sign
+  %res = bitcast <4 x i32> %resb to <4 x float>
+  ret <4 x float> %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; pow, sqrt and rsqrt
+
+define <4 x float> @_Z3powDv4_fS_(<4 x float> %x, <4 x float> %y) nounwind readnone {
+entry:
+  %l = call <4 x float> @_Z3logDv4_f(<4 x float> %x)
+  %t = fmul <4 x float> %y, %l
+  ; exp(y * log(x)) is only accurate for positive x and moderate y * log(x)
+  ; (this also catches infinities and NaNs)
+  %at = call <4 x float> @__rs_fabs4(<4 x float> %t)
+  %bad0 = fcmp ole <4 x float> %x, zeroinitializer
+  %bad1 = fcmp ugt <4 x float> %at, <float 8.0, float 8.0, float 8.0, float 8.0>
+  %bad = or <4 x i1> %bad0, %bad1
+  %anybad = call i1 @__rs_any4(<4 x i1> %bad)
+  br i1 %anybad, label %slow, label %fast
+
+slow:
+  %slowres = call <4 x float> @llvm.pow.v4f32(<4 x float> %x, <4 x float> %y)
+  ret <4 x float> %slowres
+
+fast:
+  %res = call <4 x float> @_Z3expDv4_f(<4 x float> %t)
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z4sqrtDv4_f(<4 x float> %x) nounwind readnone {
+  %res = call <4 x float> @llvm.sqrt.v4f32(<4 x float> %x)
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z5rsqrtDv4_f(<4 x float> %x) nounwind readnone {
+  %s = call <4 x float> @llvm.sqrt.v4f32(<4 x float> %x)
+  %res = fdiv <4 x float> <float 1.0, float 1.0, float 1.0, float 1.0>, %s
+  ret <4 x float> %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; clamp, mix and dot
+
+define <4 x float> @_Z5clampDv4_fS_S_(<4 x float> %amount, <4 x float> %low, <4 x float> %high) nounwind readnone {
+  %lt = fcmp olt <4 x float> %amount, %low
+  %r0 = select <4 x i1> %lt, <4 x float> %low, <4 x float> %amount
+  %gt = fcmp ogt <4 x float> %r0, %high
+  %res = select <4 x i1> %gt, <4 x float> %high, <4 x float> %r0
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z3mixDv4_fS_S_(<4 x float> %start, <4 x float> %stop, <4 x float> %amount) nounwind readnone {
+  %d = fsub <4 x float> %stop, %start
+  %m = fmul <4 x float> %d, %amount
+  %res = fadd <4 x float> %start, %m
+  ret <4 x float> %res
+}
+
+define float @_Z3dotDv4_fS_(<4 x float> %lhs, <4 x float> %rhs) nounwind readnone {
+  %m = fmul <4 x float> %lhs, %rhs
+  %m0 = extractelement <4 x float> %m, i32 0
+  %m1 = extractelement <4 x float> %m, i32 1
+  %m2 = extractelement <4 x float> %m, i32 2
+  %m3 = extractelement <4 x float> %m, i32 3
+  %s1 = fadd float %m0, %m1
+  %s2 = fadd float %s1, %m2
+  %res = fadd float %s2, %m3
+  ret float %res
+}
+
+define float @_Z3dotDv3_fS_(<3 x float> %lhs, <3 x float> %rhs) nounwind readnone {
+  %m = fmul <3 x float> %lhs, %rhs
+  %m0 = extractelement <3 x float> %m, i32 0
+  %m1 = extractelement <3 x float> %m, i32 1
+  %m2 = extractelement <3 x float> %m, i32 2
+  %s1 = fadd float %m0, %m1
+  %res = fadd float %s1, %m2
+  ret float %res
+}
+
+define float @_Z3dotDv2_fS_(<2 x float> %lhs, <2 x float> %rhs) nounwind readnone {
+  %m = fmul <2 x float> %lhs, %rhs
+  %m0 = extractelement <2 x float> %m, i32 0
+  %m1 = extractelement <2 x float> %m, i32 1
+  %res = fadd float %m0, %m1
+  ret float %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; rsMatrixMultiply (matrices are stored column-major)
+
+define <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv4_f(%struct.rs_matrix4x4* %m, <4 x float> %in) nounwind readonly {
+  %cols = bitcast %struct.rs_matrix4x4* %m to <4 x float>*
+  %c0p = getelementptr <4 x float>* %cols, i32 0
+  %c0 = load <4 x float>* %c0p, align 4
+  %c1p = getelementptr <4 x float>* %cols, i32 1
+  %c1 = load <4 x float>* %c1p, align 4
+  %c2p = getelementptr <4 x float>* %cols, i32 2
+  %c2 = load <4 x float>* %c2p, align 4
+  %c3p = getelementptr <4 x float>* %cols, i32 3
+  %c3 = load <4 x float>* %c3p, align 4
+  %x = shufflevector <4 x float> %in, <4 x float> undef, <4 x i32> <i32 0, i32 0, i32 0, i32 0>
+  %y = shufflevector <4 x float> %in, <4 x float> undef, <4 x i32> <i32 1, i32 1, i32 1, i32 1>
+  %z = shufflevector <4 x float> %in, <4 x float> undef, <4 x i32> <i32 2, i32 2, i32 2, i32 2>
+  %w = shufflevector <4 x float> %in, <4 x float> undef, <4 x i32> <i32 3, i32 3, i32 3, i32 3>
+  %t0 = fmul <4 x float> %c0, %x
+  %t1 = fmul <4 x float> %c1, %y
+  %s1 = fadd <4 x float> %t0, %t1
+  %t2 = fmul <4 x float> %c2, %z
+  %s2 = fadd <4 x float> %s1, %t2
+  %t3 = fmul <4 x float> %c3, %w
+  %res = fadd <4 x float> %s2, %t3
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv3_f(%struct.rs_matrix4x4* %m, <3 x float> %in) nounwind readonly {
+  %in4 = shufflevector <3 x float> %in, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %res = call <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv4_f(%struct.rs_matrix4x4* %m, <4 x float> %in4)
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv2_f(%struct.rs_matrix4x4* %m, <2 x float> %in) nounwind readonly {
+  %in4 = shufflevector <2 x float> %in, <2 x float> <float 0.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %res = call <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv4_f(%struct.rs_matrix4x4* %m, <4 x float> %in4)
+  ret <4 x float> %res
+}
+
+define <3 x float> @_Z16rsMatrixMultiplyPK12rs_matrix3x3Dv3_f(%struct.rs_matrix3x3* %m, <3 x float> %in) nounwind readonly {
+  %m00p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 0
+  %m00 = load float* %m00p, align 4
+  %m01p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 1
+  %m01 = load float* %m01p, align 4
+  %m02p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 2
+  %m02 = load float* %m02p, align 4
+  %c0_0 = insertelement <3 x float> undef, float %m00, i32 0
+  %c0_1 = insertelement <3 x float> %c0_0, float %m01, i32 1
+  %c0 = insertelement <3 x float> %c0_1, float %m02, i32 2
+  %m10p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 3
+  %m10 = load float* %m10p, align 4
+  %m11p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 4
+  %m11 = load float* %m11p, align 4
+  %m12p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 5
+  %m12 = load float* %m12p, align 4
+  %c1_0 = insertelement <3 x float> undef, float %m10, i32 0
+  %c1_1 = insertelement <3 x float> %c1_0, float %m11, i32 1
+  %c1 = insertelement <3 x float> %c1_1, float %m12, i32 2
+  %m20p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 6
+  %m20 = load float* %m20p, align 4
+  %m21p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 7
+  %m21 = load float* %m21p, align 4
+  %m22p = getelementptr %struct.rs_matrix3x3* %m, i32 0, i32 0, i32 8
+  %m22 = load float* %m22p, align 4
+  %c2_0 = insertelement <3 x float> undef, float %m20, i32 0
+  %c2_1 = insertelement <3 x float> %c2_0, float %m21, i32 1
+  %c2 = insertelement <3 x float> %c2_1, float %m22, i32 2
+  %x = shufflevector <3 x float> %in, <3 x float> undef, <3 x i32> <i32 0, i32 0, i32 0>
+  %y = shufflevector <3 x float> %in, <3 x float> undef, <3 x i32> <i32 1, i32 1, i32 1>
+  %z = shufflevector <3 x float> %in, <3 x float> undef, <3 x i32> <i32 2, i32 2, i32 2>
+  %t0 = fmul <3 x float> %c0, %x
+  %t1 = fmul <3 x float> %c1, %y
+  %s1 = fadd <3 x float> %t0, %t1
+  %t2 = fmul <3 x float> %c2, %z
+  %res = fadd <3 x float> %s1, %t2
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z16rsMatrixMultiplyPK12rs_matrix3x3Dv2_f(%struct.rs_matrix3x3* %m, <2 x float> %in) nounwind readonly {
+  %in3 = shufflevector <2 x float> %in, <2 x float> <float 1.0, float 1.0>, <3 x i32> <i32 0, i32 1, i32 2>
+  %res = call <3 x float> @_Z16rsMatrixMultiplyPK12rs_matrix3x3Dv3_f(%struct.rs_matrix3x3* %m, <3 x float> %in3)
+  ret <3 x float> %res
+}
+
+define <2 x float> @_Z16rsMatrixMultiplyPK12rs_matrix2x2Dv2_f(%struct.rs_matrix2x2* %m, <2 x float> %in) nounwind readonly {
+  %mp = bitcast %struct.rs_matrix2x2* %m to <4 x float>*
+  %mv = load <4 x float>* %mp, align 4
+  %c0 = shufflevector <4 x float> %mv, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  %c1 = shufflevector <4 x float> %mv, <4 x float> undef, <2 x i32> <i32 2, i32 3>
+  %x = shufflevector <2 x float> %in, <2 x float> undef, <2 x i32> <i32 0, i32 0>
+  %y = shufflevector <2 x float> %in, <2 x float> undef, <2 x i32> <i32 1, i32 1>
+  %t0 = fmul <2 x float> %c0, %x
+  %t1 = fmul <2 x float> %c1, %y
+  %res = fadd <2 x float> %t0, %t1
+  ret <2 x float> %res
+}
+
+; Variants taking a non-const matrix
+
+define <4 x float> @_Z16rsMatrixMultiplyP12rs_matrix4x4Dv4_f(%struct.rs_matrix4x4* %m, <4 x float> %in) nounwind readonly {
+  %res = call <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv4_f(%struct.rs_matrix4x4* %m, <4 x float> %in)
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z16rsMatrixMultiplyP12rs_matrix4x4Dv3_f(%struct.rs_matrix4x4* %m, <3 x float> %in) nounwind readonly {
+  %res = call <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv3_f(%struct.rs_matrix4x4* %m, <3 x float> %in)
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z16rsMatrixMultiplyP12rs_matrix4x4Dv2_f(%struct.rs_matrix4x4* %m, <2 x float> %in) nounwind readonly {
+  %res = call <4 x float> @_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv2_f(%struct.rs_matrix4x4* %m, <2 x float> %in)
+  ret <4 x float> %res
+}
+
+define <3 x float> @_Z16rsMatrixMultiplyP12rs_matrix3x3Dv3_f(%struct.rs_matrix3x3* %m, <3 x float> %in) nounwind readonly {
+  %res = call <3 x float> @_Z16rsMatrixMultiplyPK12rs_matrix3x3Dv3_f(%struct.rs_matrix3x3* %m, <3 x float> %in)
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z16rsMatrixMultiplyP12rs_matrix3x3Dv2_f(%struct.rs_matrix3x3* %m, <2 x float> %in) nounwind readonly {
+  %res = call <3 x float> @_Z16rsMatrixMultiplyPK12rs_matrix3x3Dv2_f(%struct.rs_matrix3x3* %m, <2 x float> %in)
+  ret <3 x float> %res
+}
+
+define <2 x float> @_Z16rsMatrixMultiplyP12rs_matrix2x2Dv2_f(%struct.rs_matrix2x2* %m, <2 x float> %in) nounwind readonly {
+  %res = call <2 x float> @_Z16rsMatrixMultiplyPK12rs_matrix2x2Dv2_f(%struct.rs_matrix2x2* %m, <2 x float> %in)
+  ret <2 x float> %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; float2 and float3 variants
+
+define <3 x float> @_Z3expDv3_f(<3 x float> %x) nounwind readnone {
+  %x4 = shufflevector <3 x float> %x, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3expDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z3logDv3_f(<3 x float> %x) nounwind readnone {
+  %x4 = shufflevector <3 x float> %x, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3logDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z3sinDv3_f(<3 x float> %x) nounwind readnone {
+  %x4 = shufflevector <3 x float> %x, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3sinDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z3cosDv3_f(<3 x float> %x) nounwind readnone {
+  %x4 = shufflevector <3 x float> %x, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3cosDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z4sqrtDv3_f(<3 x float> %x) nounwind readnone {
+  %x4 = shufflevector <3 x float> %x, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z4sqrtDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z5rsqrtDv3_f(<3 x float> %x) nounwind readnone {
+  %x4 = shufflevector <3 x float> %x, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z5rsqrtDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z3powDv3_fS_(<3 x float> %a0, <3 x float> %a1) nounwind readnone {
+  %a0.4 = shufflevector <3 x float> %a0, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a1.4 = shufflevector <3 x float> %a1, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3powDv4_fS_(<4 x float> %a0.4, <4 x float> %a1.4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z5clampDv3_fS_S_(<3 x float> %a0, <3 x float> %a1, <3 x float> %a2) nounwind readnone {
+  %a0.4 = shufflevector <3 x float> %a0, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a1.4 = shufflevector <3 x float> %a1, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a2.4 = shufflevector <3 x float> %a2, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z5clampDv4_fS_S_(<4 x float> %a0.4, <4 x float> %a1.4, <4 x float> %a2.4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z3mixDv3_fS_S_(<3 x float> %a0, <3 x float> %a1, <3 x float> %a2) nounwind readnone {
+  %a0.4 = shufflevector <3 x float> %a0, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a1.4 = shufflevector <3 x float> %a1, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a2.4 = shufflevector <3 x float> %a2, <3 x float> <float 1.0, float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3mixDv4_fS_S_(<4 x float> %a0.4, <4 x float> %a1.4, <4 x float> %a2.4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <3 x i32> <i32 0, i32 1, i32 2>
+  ret <3 x float> %res
+}
+
+define <2 x float> @_Z3expDv2_f(<2 x float> %x) nounwind readnone {
+  %x4 = shufflevector <2 x float> %x, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3expDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z3logDv2_f(<2 x float> %x) nounwind readnone {
+  %x4 = shufflevector <2 x float> %x, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3logDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z3sinDv2_f(<2 x float> %x) nounwind readnone {
+  %x4 = shufflevector <2 x float> %x, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3sinDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z3cosDv2_f(<2 x float> %x) nounwind readnone {
+  %x4 = shufflevector <2 x float> %x, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3cosDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z4sqrtDv2_f(<2 x float> %x) nounwind readnone {
+  %x4 = shufflevector <2 x float> %x, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z4sqrtDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z5rsqrtDv2_f(<2 x float> %x) nounwind readnone {
+  %x4 = shufflevector <2 x float> %x, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z5rsqrtDv4_f(<4 x float> %x4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z3powDv2_fS_(<2 x float> %a0, <2 x float> %a1) nounwind readnone {
+  %a0.4 = shufflevector <2 x float> %a0, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a1.4 = shufflevector <2 x float> %a1, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3powDv4_fS_(<4 x float> %a0.4, <4 x float> %a1.4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z5clampDv2_fS_S_(<2 x float> %a0, <2 x float> %a1, <2 x float> %a2) nounwind readnone {
+  %a0.4 = shufflevector <2 x float> %a0, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a1.4 = shufflevector <2 x float> %a1, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a2.4 = shufflevector <2 x float> %a2, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z5clampDv4_fS_S_(<4 x float> %a0.4, <4 x float> %a1.4, <4 x float> %a2.4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z3mixDv2_fS_S_(<2 x float> %a0, <2 x float> %a1, <2 x float> %a2) nounwind readnone {
+  %a0.4 = shufflevector <2 x float> %a0, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a1.4 = shufflevector <2 x float> %a1, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %a2.4 = shufflevector <2 x float> %a2, <2 x float> <float 1.0, float 1.0>, <4 x i32> <i32 0, i32 1, i32 2, i32 3>
+  %r4 = call <4 x float> @_Z3mixDv4_fS_S_(<4 x float> %a0.4, <4 x float> %a1.4, <4 x float> %a2.4)
+  %res = shufflevector <4 x float> %r4, <4 x float> undef, <2 x i32> <i32 0, i32 1>
+  ret <2 x float> %res
+}
+
+; Overloads taking scalar parameters
+
+define <4 x float> @_Z5clampDv4_fff(<4 x float> %amount, float %low, float %high) nounwind readnone {
+  %lowv.i = insertelement <4 x float> undef, float %low, i32 0
+  %lowv = shufflevector <4 x float> %lowv.i, <4 x float> undef, <4 x i32> zeroinitializer
+  %highv.i = insertelement <4 x float> undef, float %high, i32 0
+  %highv = shufflevector <4 x float> %highv.i, <4 x float> undef, <4 x i32> zeroinitializer
+  %res = call <4 x float> @_Z5clampDv4_fS_S_(<4 x float> %amount, <4 x float> %lowv, <4 x float> %highv)
+  ret <4 x float> %res
+}
+
+define <4 x float> @_Z3mixDv4_fS_f(<4 x float> %start, <4 x float> %stop, float %amount) nounwind readnone {
+  %amountv.i = insertelement <4 x float> undef, float %amount, i32 0
+  %amountv = shufflevector <4 x float> %amountv.i, <4 x float> undef, <4 x i32> zeroinitializer
+  %res = call <4 x float> @_Z3mixDv4_fS_S_(<4 x float> %start, <4 x float> %stop, <4 x float> %amountv)
+  ret <4 x float> %res
+}
+
+define <3 x float> @_Z5clampDv3_fff(<3 x float> %amount, float %low, float %high) nounwind readnone {
+  %lowv.i = insertelement <3 x float> undef, float %low, i32 0
+  %lowv = shufflevector <3 x float> %lowv.i, <3 x float> undef, <3 x i32> zeroinitializer
+  %highv.i = insertelement <3 x float> undef, float %high, i32 0
+  %highv = shufflevector <3 x float> %highv.i, <3 x float> undef, <3 x i32> zeroinitializer
+  %res = call <3 x float> @_Z5clampDv3_fS_S_(<3 x float> %amount, <3 x float> %lowv, <3 x float> %highv)
+  ret <3 x float> %res
+}
+
+define <3 x float> @_Z3mixDv3_fS_f(<3 x float> %start, <3 x float> %stop, float %amount) nounwind readnone {
+  %amountv.i = insertelement <3 x float> undef, float %amount, i32 0
+  %amountv = shufflevector <3 x float> %amountv.i, <3 x float> undef, <3 x i32> zeroinitializer
+  %res = call <3 x float> @_Z3mixDv3_fS_S_(<3 x float> %start, <3 x float> %stop, <3 x float> %amountv)
+  ret <3 x float> %res
+}
+
+define <2 x float> @_Z5clampDv2_fff(<2 x float> %amount, float %low, float %high) nounwind readnone {
+  %lowv.i = insertelement <2 x float> undef, float %low, i32 0
+  %lowv = shufflevector <2 x float> %lowv.i, <2 x float> undef, <2 x i32> zeroinitializer
+  %highv.i = insertelement <2 x float> undef, float %high, i32 0
+  %highv = shufflevector <2 x float> %highv.i, <2 x float> undef, <2 x i32> zeroinitializer
+  %res = call <2 x float> @_Z5clampDv2_fS_S_(<2 x float> %amount, <2 x float> %lowv, <2 x float> %highv)
+  ret <2 x float> %res
+}
+
+define <2 x float> @_Z3mixDv2_fS_f(<2 x float> %start, <2 x float> %stop, float %amount) nounwind readnone {
+  %amountv.i = insertelement <2 x float> undef, float %amount, i32 0
+  %amountv = shufflevector <2 x float> %amountv.i, <2 x float> undef, <2 x i32> zeroinitializer
+  %res = call <2 x float> @_Z3mixDv2_fS_S_(<2 x float> %start, <2 x float> %stop, <2 x float> %amountv)
+  ret <2 x float> %res
+}
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Pixel format conversions
+;
+; Each channel is shifted into place in its own lane and the lanes are then
+; combined. Unpacking widens a channel to 8 bits by replicating its top bits,
+; so 0 maps to 0 and the channel maximum to 255.
+
+define internal i16 @__rs_or_lanes4(<4 x i16> %v) nounwind readnone alwaysinline {
+  %v0 = extractelement <4 x i16> %v, i32 0
+  %v1 = extractelement <4 x i16> %v, i32 1
+  %v2 = extractelement <4 x i16> %v, i32 2
+  %v3 = extractelement <4 x i16> %v, i32 3
+  %o01 = or i16 %v0, %v1
+  %o23 = or i16 %v2, %v3
+  %o = or i16 %o01, %o23
+  ret i16 %o
+}
+
+define internal <4 x i16> @__rs_splat_i16(i16 %p) nounwind readnone alwaysinline {
+  %v0 = insertelement <4 x i16> undef, i16 %p, i32 0
+  %v = shufflevector <4 x i16> %v0, <4 x i16> undef, <4 x i32> zeroinitializer
+  ret <4 x i16> %v
+}
+
+define zeroext i16 @_Z16rsPackColorTo565Dv4_h(<4 x i8> %c) nounwind readnone {
+  %w = zext <4 x i8> %c to <4 x i16>
+  %t = lshr <4 x i16> %w, <i16 3, i16 2, i16 3, i16 8>
+  %p = shl <4 x i16> %t, <i16 11, i16 5, i16 0, i16 0>
+  %res = call i16 @__rs_or_lanes4(<4 x i16> %p)
+  ret i16 %res
+}
+
+define <4 x i8> @_Z16rsUnpackColor565t(i16 zeroext %p) nounwind readnone {
+  %v = call <4 x i16> @__rs_splat_i16(i16 %p)
+  %s = lshr <4 x i16> %v, <i16 11, i16 5, i16 0, i16 0>
+  %f = and <4 x i16> %s, <i16 31, i16 63, i16 31, i16 0>
+  %hi = shl <4 x i16> %f, <i16 3, i16 2, i16 3, i16 0>
+  %lo = lshr <4 x i16> %f, <i16 2, i16 4, i16 2, i16 0>
+  %e = or <4 x i16> %hi, %lo
+  %a = or <4 x i16> %e, <i16 0, i16 0, i16 0, i16 255>
+  %res = trunc <4 x i16> %a to <4 x i8>
+  ret <4 x i8> %res
+}
+
+define zeroext i16 @_Z17rsPackColorTo5551Dv4_h(<4 x i8> %c) nounwind readnone {
+  %w = zext <4 x i8> %c to <4 x i16>
+  %t = lshr <4 x i16> %w, <i16 3, i16 3, i16 3, i16 7>
+  %p = shl <4 x i16> %t, <i16 11, i16 6, i16 1, i16 0>
+  %res = call i16 @__rs_or_lanes4(<4 x i16> %p)
+  ret i16 %res
+}
+
+define <4 x i8> @_Z17rsUnpackColor5551t(i16 zeroext %p) nounwind readnone {
+  %v = call <4 x i16> @__rs_splat_i16(i16 %p)
+  %s = lshr <4 x i16> %v, <i16 11, i16 6, i16 1, i16 0>
+  %f = and <4 x i16> %s, <i16 31, i16 31, i16 31, i16 1>
+  %hi = shl <4 x i16> %f, <i16 3, i16 3, i16 3, i16 0>
+  %lo = lshr <4 x i16> %f, <i16 2, i16 2, i16 2, i16 0>
+  %e = or <4 x i16> %hi, %lo
+  %a = mul <4 x i16> %e, <i16 1, i16 1, i16 1, i16 255>
+  %res = trunc <4 x i16> %a to <4 x i8>
+  ret <4 x i8> %res
+}
+
+define zeroext i16 @_Z17rsPackColorTo4444Dv4_h(<4 x i8> %c) nounwind readnone {
+  %w = zext <4 x i8> %c to <4 x i16>
+  %t = lshr <4 x i16> %w, <i16 4, i16 4, i16 4, i16 4>
+  %p = shl <4 x i16> %t, <i16 12, i16 8, i16 4, i16 0>
+  %res = call i16 @__rs_or_lanes4(<4 x i16> %p)
+  ret i16 %res
+}
+
+define <4 x i8> @_Z17rsUnpackColor4444t(i16 zeroext %p) nounwind readnone {
+  %v = call <4 x i16> @__rs_splat_i16(i16 %p)
+  %s = lshr <4 x i16> %v, <i16 12, i16 8, i16 4, i16 0>
+  %f = and <4 x i16> %s, <i16 15, i16 15, i16 15, i16 15>
+  %e = mul <4 x i16> %f, <i16 17, i16 17, i16 17, i16 17>
+  %res = trunc <4 x i16> %e to <4 x i8>
+  ret <4 x i8> %res
+}
+
+; uchar4 to float4 in [0, 1] and back (clamping and rounding to nearest)
+define <4 x float> @_Z16rsNormalizeColorDv4_h(<4 x i8> %c) nounwind readnone {
+  %f = uitofp <4 x i8> %c to <4 x float>
+  %res = fmul <4 x float> %f, <float 0x3F70101020000000, float 0x3F70101020000000, float 0x3F70101020000000, float 0x3F70101020000000>
+  ret <4 x float> %res
+}
+
+define <4 x i8> @_Z18rsDenormalizeColorDv4_f(<4 x float> %c) nounwind readnone {
+  ; NaN clamps to 0
+  %pos = fcmp ogt <4 x float> %c, zeroinitializer
+  %c0 = select <4 x i1> %pos, <4 x float> %c, <4 x float> zeroinitializer
+  %gt = fcmp ogt <4 x float> %c0, <float 1.0, float 1.0, float 1.0, float 1.0>
+  %c1 = select <4 x i1> %gt, <4 x float> <float 1.0, float 1.0, float 1.0, float 1.0>, <4 x float> %c0
+  %s = fmul <4 x float> %c1, <float 255.0, float 255.0, float 255.0, float 255.0>
+  %r = fadd <4 x float> %s, <float 0.5, float 0.5, float 0.5, float 0.5>
+  %res = fptoui <4 x float> %r to <4 x i8>
+  ret <4 x i8> %res
+}
+
+; Luminance with the Rec. 601 weights in 8.8 fixed point; alpha is ignored
+define zeroext i8 @_Z14rsPackColorToLDv4_h(<4 x i8> %c) nounwind readnone {
+  %w = zext <4 x i8> %c to <4 x i16>
+  %m = mul <4 x i16> %w, <i16 77, i16 150, i16 29, i16 0>
+  %m0 = extractelement <4 x i16> %m, i32 0
+  %m1 = extractelement <4 x i16> %m, i32 1
+  %m2 = extractelement <4 x i16> %m, i32 2
+  %s01 = add i16 %m0, %m1
+  %s = add i16 %s01, %m2
+  %sr = add i16 %s, 128
+  %l = lshr i16 %sr, 8
+  %res = trunc i16 %l to i8
+  ret i8 %res
+}
+
+define <4 x i8> @_Z14rsUnpackColorLh(i8 zeroext %l) nounwind readnone {
+  %v = insertelement <4 x i8> undef, i8 %l, i32 0
+  %res = shufflevector <4 x i8> %v, <4 x i8> <i8 undef, i8 undef, i8 undef, i8 -1>, <4 x i32> <i32 0, i32 0, i32 0, i32 7>
+  ret <4 x i8> %res
+}
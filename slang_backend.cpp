@@ -34,6 +34,8 @@
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 
+#include "llvm/ADT/Triple.h"
+
 #include "llvm/Assembly/PrintModulePass.h"
 
 #include "llvm/Bitcode/ReaderWriter.h"
@@ -45,16 +47,20 @@
 #include "llvm/Module.h"
 #include "llvm/Metadata.h"
 
+#include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 
 #include "llvm/Target/TargetData.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "llvm/MC/SubtargetFeature.h"
 
 #include "slang_assert.h"
+#include "slang_code_report.h"
 #include "BitWriter_2_9/ReaderWriter_2_9.h"
 
 namespace slang {
@@ -93,6 +99,7 @@ void Backend::CreateModulePasses() {
     }
 
     PMBuilder.DisableSimplifyLibCalls = false;
+    PopulateModulePasses(PMBuilder);
     PMBuilder.populateModulePassManager(*mPerModulePasses);
   }
   return;
@@ -133,14 +140,33 @@ bool Backend::CreateCodeGenPasses() {
   llvm::FloatABIType = llvm::FloatABI::Hard;
   llvm::UseSoftFloat = false;
 
+  // Relax floating-point semantics if the input allows us to
+  FPPrecision Precision = getFPPrecision();
+  llvm::UnsafeFPMath = (Precision != FP_Full);
+  llvm::LessPreciseFPMADOption = (Precision != FP_Full);
+  llvm::NoInfsFPMath = (Precision == FP_Imprecise);
+  llvm::NoNaNsFPMath = (Precision == FP_Imprecise);
+
   // BCC needs all unknown symbols resolved at compilation time. So we don't
   // need any relocation model.
   llvm::Reloc::Model RM = llvm::Reloc::Static;
 
   // This is set for the linker (specify how large of the virtual addresses we
   // can access for all unknown symbols.)
+  //
+  // Code for the host (-host-target) is linked into a shared library for
+  // rs-host-bench to load, like any other host code. The triples are compared
+  // by their parts, since spellings of the same host differ (e.g. in the
+  // vendor, "x86_64-pc-linux-gnu" vs. "x86_64-unknown-linux-gnu").
+  llvm::Triple TargetTriple(Triple);
+  llvm::Triple HostTriple(llvm::sys::getHostTriple());
   llvm::CodeModel::Model CM;
-  if (mpModule->getPointerSize() == llvm::Module::Pointer32) {
+  if ((TargetTriple.getArch() == HostTriple.getArch()) &&
+      (TargetTriple.getOS() == HostTriple.getOS()) &&
+      (TargetTriple.getEnvironment() == HostTriple.getEnvironment())) {
+    RM = llvm::Reloc::PIC_;
+    CM = llvm::CodeModel::Default;
+  } else if (mpModule->getPointerSize() == llvm::Module::Pointer32) {
     CM = llvm::CodeModel::Small;
   } else {
     // The target may have pointer size greater than 32 (e.g. x86_64
@@ -194,6 +220,9 @@ bool Backend::CreateCodeGenPasses() {
     return false;
   }
 
+  if (getPrintCodeReport())
+    mCodeGenPasses->add(CreateCodeReportPass(llvm::outs()));
+
   return true;
 }
 
@@ -299,6 +328,19 @@ void Backend::HandleTranslationUnit(clang::ASTContext &Ctx) {
 
   // Create passes for optimization and code emission
 
+  // Drop the functions and variables nothing refers to (e.g. most of the
+  // static inline functions from the headers) before optimizing, so that the
+  // per-function passes only process reachable code. Internalizing first lets
+  // this drop the unused non-static functions too.
+  if (mCodeGenOpts.OptimizationLevel > 0) {
+    llvm::PassManager DeadCodePM;
+    std::vector<const char *> ExternalSymbols;
+    if (!getLTOOnly() && GetExternalSymbols(mpModule, ExternalSymbols))
+      DeadCodePM.add(llvm::createInternalizePass(ExternalSymbols));
+    DeadCodePM.add(llvm::createGlobalDCEPass());
+    DeadCodePM.run(*mpModule);
+  }
+
   // Create and run per-function passes
   CreateFunctionPasses();
   if (mPerFunctionPasses) {
@@ -314,9 +356,15 @@ void Backend::HandleTranslationUnit(clang::ASTContext &Ctx) {
   }
 
   // Create and run module passes
-  CreateModulePasses();
-  if (mPerModulePasses)
-    mPerModulePasses->run(*mpModule);
+  if (!getLTOOnly()) {
+    CreateModulePasses();
+    if (mPerModulePasses)
+      mPerModulePasses->run(*mpModule);
+  }
+
+  HandleTranslationUnitLateOpt(mpModule);
+
+  HandleTranslationUnitPostOpt(mpModule);
 
   switch (mOT) {
     case Slang::OT_Assembly:
@@ -333,6 +381,8 @@ void Backend::HandleTranslationUnit(clang::ASTContext &Ctx) {
           mCodeGenPasses->run(*I);
 
       mCodeGenPasses->doFinalization();
+      if (getPrintCodeReport())
+        llvm::outs().flush();
       break;
     }
     case Slang::OT_LLVMAssembly: {
@@ -353,6 +403,11 @@ void Backend::HandleTranslationUnit(clang::ASTContext &Ctx) {
       }
 
       BCEmitPM->run(*mpModule);
+      if (getPrintCodeReport()) {
+        PrintBitcodeReport(mpModule, Bitcode.str(), llvm::outs());
+        // Ahead of the "Generating ..." lines, which go through std::cout
+        llvm::outs().flush();
+      }
       WrapBitcode(Bitcode);
       break;
     }
@@ -17,6 +17,8 @@
 #ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_BACKEND_H_  // NOLINT
 #define _FRAMEWORKS_COMPILE_SLANG_SLANG_BACKEND_H_
 
+#include <vector>
+
 #include "clang/AST/ASTConsumer.h"
 
 #include "llvm/PassManager.h"
@@ -33,6 +35,7 @@ namespace llvm {
   class NamedMDNode;
   class Module;
   class PassManager;
+  class PassManagerBuilder;
   class FunctionPassManager;
 }
 
@@ -83,10 +86,42 @@ class Backend : public clang::ASTConsumer {
 
   PragmaList *mPragmas;
 
+  // Floating-point precision required by the input. Anything other than
+  // FP_Full lets code generation trade accuracy (e.g. by contracting
+  // multiply-adds or dividing via reciprocals) for speed.
+  enum FPPrecision {
+    FP_Full,
+    FP_Relaxed,     // No strict IEEE-754 rounding / denormal guarantees
+    FP_Imprecise    // Additionally assume no NaNs and infinities
+  };
+
   virtual unsigned int getTargetAPI() const {
     return SLANG_MAXIMUM_TARGET_API;
   }
 
+  virtual FPPrecision getFPPrecision() const {
+    return FP_Full;
+  }
+
+  // Whether to leave the optimization of the module to the linker, running
+  // only the per-function passes (which clean up the code generated by Clang)
+  virtual bool getLTOOnly() const {
+    return false;
+  }
+
+  // Whether to print the stack frame, spills and code size of each function
+  // as it is compiled (see slang_code_report.h)
+  virtual bool getPrintCodeReport() const {
+    return false;
+  }
+
+  // This handler will be invoked before the per-module passes are populated
+  // from @PMBuilder. Subclasses may use it to register extensions (see
+  // llvm::PassManagerBuilder::addExtension()) to the optimization pipeline.
+  virtual void PopulateModulePasses(llvm::PassManagerBuilder &PMBuilder) {
+    return;
+  }
+
   // This handler will be invoked before Clang translates @Ctx to LLVM IR. This
   // give you an opportunity to modified the IR in AST level (scope information,
   // unoptimized IR, etc.). After the return from this method, slang will start
@@ -100,6 +135,26 @@ class Backend : public clang::ASTConsumer {
   // method, slang will start doing optimization and code generation for @M.
   virtual void HandleTranslationUnitPost(llvm::Module *M) { return; }
 
+  // This handler will be invoked before the optimization passes run on @M
+  // (unless getLTOOnly()). To have every symbol that code outside @M does not
+  // refer to made internal (so that the optimizer may inline, specialize or
+  // delete it), add the names of the others to @Names and return true.
+  virtual bool GetExternalSymbols(llvm::Module *M,
+                                  std::vector<const char *> &Names) {
+    return false;
+  }
+
+  // This handler will be invoked after the optimization passes have run on
+  // @M (or have been skipped, with getLTOOnly()), before
+  // HandleTranslationUnitPostOpt(). It is the place for the transformations
+  // the optimization passes would not have preserved.
+  virtual void HandleTranslationUnitLateOpt(llvm::Module *M) { return; }
+
+  // This handler will be invoked after the optimization passes have run on
+  // @M, right before code generation (or writing out the bitcode). It may
+  // analyze the final IR and attach metadata, but should not transform it.
+  virtual void HandleTranslationUnitPostOpt(llvm::Module *M) { return; }
+
  public:
   Backend(clang::DiagnosticsEngine *DiagEngine,
           const clang::CodeGenOptions &CodeGenOpts,
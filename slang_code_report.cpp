@@ -0,0 +1,255 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_code_report.h"
+
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
+
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/CodeGen/MachineMemOperand.h"
+
+#include "llvm/Function.h"
+#include "llvm/Module.h"
+
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace slang {
+
+namespace {
+
+// Runs after the asm printer, which leaves the machine code of the function
+// in place until the last pass using it is done
+class CodeReportPass : public llvm::MachineFunctionPass {
+ private:
+  llvm::raw_ostream &mOS;
+
+ public:
+  static char ID;
+
+  explicit CodeReportPass(llvm::raw_ostream &OS)
+      : llvm::MachineFunctionPass(ID), mOS(OS) {
+    return;
+  }
+
+  virtual const char *getPassName() const {
+    return "Slang Code Report";
+  }
+
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+    llvm::MachineFunctionPass::getAnalysisUsage(AU);
+    return;
+  }
+
+  virtual bool runOnMachineFunction(llvm::MachineFunction &MF);
+};
+
+char CodeReportPass::ID = 0;
+
+bool CodeReportPass::runOnMachineFunction(llvm::MachineFunction &MF) {
+  const llvm::TargetInstrInfo *TII = MF.getTarget().getInstrInfo();
+  const llvm::MachineFrameInfo *MFI = MF.getFrameInfo();
+
+  unsigned Spills = 0;
+  unsigned Reloads = 0;
+  unsigned Instructions = 0;
+  uint64_t CodeBytes = 0;
+  bool HasUnsizedInstructions = false;
+
+  for (llvm::MachineFunction::const_iterator BB = MF.begin(), BE = MF.end();
+       BB != BE;
+       BB++) {
+    for (llvm::MachineBasicBlock::const_iterator I = BB->begin(),
+            IE = BB->end();
+         I != IE;
+         I++) {
+      const llvm::MachineInstr *MI = I;
+      // These emit no code
+      if (MI->isDebugValue() || MI->isLabel() || MI->isImplicitDef() ||
+          MI->isKill())
+        continue;
+
+      Instructions++;
+      if (unsigned Size = MI->getDesc().getSize())
+        CodeBytes += Size;
+      else
+        HasUnsizedInstructions = true;
+
+      // The frame indices have been replaced by now, so look at what the
+      // instruction accesses, as the asm printer does for its "Spill" and
+      // "Reload" comments
+      int FI;
+      const llvm::MachineMemOperand *MMO;
+      if (TII->isLoadFromStackSlotPostFE(MI, FI) ||
+          TII->hasLoadFromStackSlot(MI, MMO, FI)) {
+        if (MFI->isSpillSlotObjectIndex(FI))
+          Reloads++;
+      } else if (TII->isStoreToStackSlotPostFE(MI, FI) ||
+                 TII->hasStoreToStackSlot(MI, MMO, FI)) {
+        if (MFI->isSpillSlotObjectIndex(FI))
+          Spills++;
+      }
+    }
+  }
+
+  mOS << "Function " << MF.getFunction()->getName() << ":"
+      << " frame=" << MFI->getStackSize()
+      << (MFI->hasVarSizedObjects() ? "+dynamic" : "")
+      << " spills=" << Spills
+      << " reloads=" << Reloads
+      << " instructions=" << Instructions
+      << " code=";
+  if (!HasUnsizedInstructions)
+    mOS << CodeBytes;
+  else if (CodeBytes > 0)
+    mOS << CodeBytes << "+";
+  else
+    mOS << "?";
+  mOS << "\n";
+
+  return false;
+}
+
+// Get the size in bytes of each function block in @Bitcode, in the order they
+// were written (which is the order of the function definitions in the
+// module). Return false if @Bitcode cannot be read.
+static bool GetFunctionBlockSizes(llvm::StringRef Bitcode,
+                                  std::vector<uint64_t> &Sizes) {
+  const unsigned char *Start =
+      reinterpret_cast<const unsigned char*>(Bitcode.data());
+  llvm::BitstreamReader Reader(Start, Start + Bitcode.size());
+  llvm::BitstreamCursor Stream(Reader);
+
+  if ((Bitcode.size() < 4) ||
+      (Stream.Read(8) != 'B') ||
+      (Stream.Read(8) != 'C') ||
+      (Stream.Read(4) != 0x0) ||
+      (Stream.Read(4) != 0xC) ||
+      (Stream.Read(4) != 0xE) ||
+      (Stream.Read(4) != 0xD))
+    return false;
+
+  while (!Stream.AtEndOfStream()) {
+    if (Stream.ReadCode() != llvm::bitc::ENTER_SUBBLOCK)
+      return false;
+
+    if (Stream.ReadSubBlockID() != llvm::bitc::MODULE_BLOCK_ID) {
+      if (Stream.SkipBlock())
+        return false;
+      continue;
+    }
+
+    if (Stream.EnterSubBlock(llvm::bitc::MODULE_BLOCK_ID))
+      return false;
+
+    // Walk the records and sub-blocks of the module, measuring the function
+    // blocks by skipping over them
+    while (!Stream.AtEndOfStream()) {
+      unsigned Code = Stream.ReadCode();
+      if (Code == llvm::bitc::END_BLOCK)
+        return !Stream.ReadBlockEnd();
+
+      if (Code == llvm::bitc::ENTER_SUBBLOCK) {
+        uint64_t Begin = Stream.GetCurrentBitNo();
+        unsigned BlockID = Stream.ReadSubBlockID();
+        if (Stream.SkipBlock())
+          return false;
+        if (BlockID == llvm::bitc::FUNCTION_BLOCK_ID)
+          Sizes.push_back((Stream.GetCurrentBitNo() - Begin + 7) / 8);
+      } else if (Code == llvm::bitc::DEFINE_ABBREV) {
+        Stream.ReadAbbrevRecord();
+      } else {
+        llvm::SmallVector<uint64_t, 64> Record;
+        Stream.ReadRecord(Code, Record);
+      }
+    }
+    return false;
+  }
+
+  return false;
+}
+
+}  // namespace
+
+llvm::FunctionPass *CreateCodeReportPass(llvm::raw_ostream &OS) {
+  return new CodeReportPass(OS);
+}
+
+void PrintBitcodeReport(const llvm::Module *M,
+                        llvm::StringRef Bitcode,
+                        llvm::raw_ostream &OS) {
+  unsigned NumDefinitions = 0;
+  for (llvm::Module::const_iterator F = M->begin(), FE = M->end();
+       F != FE;
+       F++)
+    if (!F->isDeclaration())
+      NumDefinitions++;
+
+  // Without a size for every function, sizes cannot be matched to functions
+  std::vector<uint64_t> Sizes;
+  if (!GetFunctionBlockSizes(Bitcode, Sizes) ||
+      (Sizes.size() != NumDefinitions))
+    Sizes.clear();
+
+  uint64_t FunctionBytes = 0;
+  unsigned i = 0;
+  for (llvm::Module::const_iterator F = M->begin(), FE = M->end();
+       F != FE;
+       F++) {
+    if (F->isDeclaration())
+      continue;
+
+    unsigned Instructions = 0;
+    for (llvm::Function::const_iterator BB = F->begin(), BE = F->end();
+         BB != BE;
+         BB++)
+      Instructions += BB->size();
+
+    OS << "Function " << F->getName() << ": bitcode=";
+    if (Sizes.empty()) {
+      OS << "?";
+    } else {
+      OS << Sizes[i];
+      FunctionBytes += Sizes[i];
+    }
+    OS << " instructions=" << Instructions
+       << " blocks=" << F->size() << "\n";
+    i++;
+  }
+
+  OS << "Module: bitcode=" << Bitcode.size() << " functions=";
+  if (Sizes.empty() && (NumDefinitions > 0))
+    OS << "?";
+  else
+    OS << FunctionBytes;
+  OS << "\n";
+
+  return;
+}
+
+}  // namespace slang
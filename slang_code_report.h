@@ -0,0 +1,58 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_CODE_REPORT_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_CODE_REPORT_H_
+
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+  class FunctionPass;
+  class Module;
+  class raw_ostream;
+}  // namespace llvm
+
+namespace slang {
+
+// Reports of what each function costs in the output (-print-code-report).
+//
+// For native code, a pass to run after the code generator's own passes
+// prints one line per function:
+//
+//   Function <name>: frame=<bytes> spills=<n> reloads=<n> instructions=<n>
+//                    code=<bytes>
+//
+// "frame" is the size of the stack frame (with "+dynamic" if it also has
+// variable-sized objects), "spills" and "reloads" count the stores to and
+// loads from the register allocator's spill slots, and "instructions" and
+// "code" are the number and size of the machine instructions. Targets that do
+// not give instructions a fixed size report the code size as "?", or as
+// "<bytes>+" when only some of them have one.
+llvm::FunctionPass *CreateCodeReportPass(llvm::raw_ostream &OS);
+
+// For bitcode, print the size of each function defined in @M in @Bitcode
+// (the bitcode @M was written to), with its number of IR instructions and
+// basic blocks, followed by the size of the whole module:
+//
+//   Function <name>: bitcode=<bytes> instructions=<n> blocks=<n>
+//   Module: bitcode=<bytes> functions=<bytes>
+void PrintBitcodeReport(const llvm::Module *M,
+                        llvm::StringRef Bitcode,
+                        llvm::raw_ostream &OS);
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_CODE_REPORT_H_  NOLINT
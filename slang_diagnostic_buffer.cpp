@@ -16,6 +16,7 @@
 
 #include "slang_diagnostic_buffer.h"
 
+#include "clang/Basic/DiagnosticIDs.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 
@@ -76,6 +77,23 @@ void DiagnosticBuffer::HandleDiagnostic(
 
   Info.FormatDiagnostic(Buf);
   (*mSOS) << Buf.str() << '\n';
+
+  // Only slang's own (custom) diagnostics show their fix-its, so that the
+  // output of Clang's diagnostics stays as it was
+  if (Info.getID() < clang::diag::DIAG_UPPER_LIMIT)
+    return;
+
+  for (unsigned i = 0, e = Info.getNumFixItHints(); i != e; i++) {
+    const clang::FixItHint &Hint = Info.getFixItHint(i);
+    const clang::SourceLocation &Begin = Hint.RemoveRange.getBegin();
+    if (Begin.isInvalid())
+      continue;
+    Begin.print(*mSOS, Info.getSourceManager());
+    if (Begin == Hint.RemoveRange.getEnd())
+      (*mSOS) << ": fix-it: insert \"" << Hint.CodeToInsert << "\"\n";
+    else
+      (*mSOS) << ": fix-it: replace with \"" << Hint.CodeToInsert << "\"\n";
+  }
 }
 
 clang::DiagnosticConsumer *
@@ -29,12 +29,18 @@
 
 #include "clang/Sema/SemaDiagnostic.h"
 
+#include "llvm/ADT/OwningPtr.h"
+
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
 
 #include "os_sep.h"
 #include "slang_rs_backend.h"
 #include "slang_rs_context.h"
 #include "slang_rs_export_type.h"
+#include "slang_rs_instrumentation.h"
 
 namespace slang {
 
@@ -189,6 +195,21 @@ void SlangRS::initDiagnostic() {
       "type '%0' in different translation unit (%1 v.s. %2) "
       "has incompatible type definition");
 
+  mDiagErrorJavaUsageFile =
+    DiagEngine.getCustomDiagID(
+      clang::DiagnosticsEngine::Error,
+      "cannot read Java usage file '%0': %1");
+
+  mDiagErrorOptRemarksFile =
+    DiagEngine.getCustomDiagID(
+      clang::DiagnosticsEngine::Error,
+      "cannot write optimization remarks file '%0': %1");
+
+  mDiagErrorProfileFile =
+    DiagEngine.getCustomDiagID(
+      clang::DiagnosticsEngine::Error,
+      "cannot read profile '%0': %1");
+
   mDiagErrorTargetAPIRange =
     DiagEngine.getCustomDiagID(
       clang::DiagnosticsEngine::Error,
@@ -201,6 +222,42 @@ void SlangRS::initPreprocessor() {
   std::stringstream RSH;
   RSH << "#define RS_VERSION " << mTargetAPI << std::endl;
   RSH << "#include \"rs_core." RS_HEADER_SUFFIX "\"" << std::endl;
+
+  // Pixel format conversions (implemented in rslib_vec.ll)
+  static const char *PixelConversions[] = {
+    "ushort rsPackColorTo565(uchar4 c)",
+    "uchar4 rsUnpackColor565(ushort p)",
+    "ushort rsPackColorTo5551(uchar4 c)",
+    "uchar4 rsUnpackColor5551(ushort p)",
+    "ushort rsPackColorTo4444(uchar4 c)",
+    "uchar4 rsUnpackColor4444(ushort p)",
+    "float4 rsNormalizeColor(uchar4 c)",
+    "uchar4 rsDenormalizeColor(float4 c)",
+    "uchar rsPackColorToL(uchar4 c)",
+    "uchar4 rsUnpackColorL(uchar l)",
+  };
+  for (unsigned i = 0,
+           e = sizeof(PixelConversions) / sizeof(PixelConversions[0]);
+       i != e;
+       i++)
+    RSH << "extern __attribute__((const, overloadable)) "
+        << PixelConversions[i] << ";" << std::endl;
+
+  // Regions counted by -instrument, which otherwise leaves the code as it is
+  if (mInstrument) {
+    RSH << "extern void " RS_REGION_BEGIN_FUNC "(const char *name);"
+        << std::endl;
+    RSH << "extern void " RS_REGION_END_FUNC "(const char *name);"
+        << std::endl;
+    RSH << "#define RS_REGION_BEGIN(name) " RS_REGION_BEGIN_FUNC "(#name)"
+        << std::endl;
+    RSH << "#define RS_REGION_END(name) " RS_REGION_END_FUNC "(#name)"
+        << std::endl;
+  } else {
+    RSH << "#define RS_REGION_BEGIN(name) ((void) 0)" << std::endl;
+    RSH << "#define RS_REGION_END(name) ((void) 0)" << std::endl;
+  }
+
   PP.setPredefines(RSH.str());
 }
 
@@ -211,21 +268,77 @@ void SlangRS::initASTContext() {
                              &mPragmas,
                              mTargetAPI,
                              &mGeneratedFileNames);
+
+  for (std::vector<std::string>::const_iterator
+           I = mSpecializations.begin(), E = mSpecializations.end();
+       I != E;
+       I++) {
+    // Checked for the '=' by the driver
+    size_t Pos = I->find('=');
+    mRSContext->addOptionSpecialization(I->substr(0, Pos),
+                                        I->substr(Pos + 1));
+  }
+
+  if (mHasJavaUsage)
+    mRSContext->setJavaUsage(&mJavaUsage, mStripUnusedExports);
+}
+
+bool SlangRS::loadJavaUsage(const std::string &JavaUsageFile) {
+  llvm::OwningPtr<llvm::MemoryBuffer> MB;
+  if (llvm::error_code EC =
+          llvm::MemoryBuffer::getFile(JavaUsageFile, MB)) {
+    getDiagnostics().Report(mDiagErrorJavaUsageFile) << JavaUsageFile
+                                                     << EC.message();
+    return false;
+  }
+
+  // One member name per line; '#' starts a comment
+  llvm::StringRef Buffer = MB->getBuffer();
+  while (!Buffer.empty()) {
+    std::pair<llvm::StringRef, llvm::StringRef> Line = Buffer.split('\n');
+    llvm::StringRef Name = Line.first.split('#').first;
+    size_t Begin = Name.find_first_not_of(" \t\r");
+    if (Begin != llvm::StringRef::npos) {
+      size_t End = Name.find_first_of(" \t\r", Begin);
+      mJavaUsage.insert(Name.substr(Begin, End - Begin));
+    }
+    Buffer = Line.second;
+  }
+
+  return true;
 }
 
 clang::ASTConsumer
 *SlangRS::createBackend(const clang::CodeGenOptions& CodeGenOpts,
                         llvm::raw_ostream *OS,
                         Slang::OutputType OT) {
+    // The remarks locate call sites and loops by their debug info, which the
+    // backend strips again after optimization
+    bool OptRemarks = mOptRemarks || !mOptRemarksFile.empty();
+    if (OptRemarks) {
+      mRemarksCodeGenOpts = CodeGenOpts;
+      mRemarksCodeGenOpts.DebugInfo = 1;
+    }
+
     return new RSBackend(mRSContext,
                          &getDiagnostics(),
-                         CodeGenOpts,
+                         OptRemarks ? mRemarksCodeGenOpts : CodeGenOpts,
                          getTargetOptions(),
                          &mPragmas,
                          OS,
                          OT,
                          getSourceManager(),
-                         mAllowRSPrefix);
+                         mAllowRSPrefix,
+                         mPrintKernelCost,
+                         mPrintCodeReport,
+                         mStripRSDebug,
+                         mOptRemarks,
+                         mOptRemarksFile,
+                         mWarnDouble,
+                         mProfileGenerate,
+                         mHasProfile ? &mProfile : NULL,
+                         mInstrument,
+                         mLTOOnly);
 }
 
 bool SlangRS::IsRSHeaderFile(const char *File) {
@@ -251,7 +364,12 @@ bool SlangRS::IsFunctionInRSHeaderFile(const clang::FunctionDecl *FD,
 }
 
 SlangRS::SlangRS()
-  : Slang(), mRSContext(NULL), mAllowRSPrefix(false), mTargetAPI(0) {
+  : Slang(), mRSContext(NULL), mAllowRSPrefix(false), mTargetAPI(0),
+    mPrintKernelCost(false), mPrintCodeReport(false),
+    mStripRSDebug(false), mOptRemarks(false), mHasJavaUsage(false),
+    mStripUnusedExports(false), mWarnDouble(false),
+    mProfileGenerate(false), mHasProfile(false), mInstrument(false),
+    mLTOOnly(false) {
 }
 
 bool SlangRS::compile(
@@ -263,7 +381,20 @@ bool SlangRS::compile(
     bool AllowRSPrefix, bool OutputDep,
     unsigned int TargetAPI,
     const std::string &JavaReflectionPathBase,
-    const std::string &JavaReflectionPackageName) {
+    const std::string &JavaReflectionPackageName,
+    const std::vector<std::string> &Specializations,
+    bool PrintKernelCost,
+    bool PrintCodeReport,
+    bool StripRSDebug,
+    bool OptRemarks,
+    const std::string &OptRemarksFile,
+    const std::string &JavaUsageFile,
+    bool StripUnusedExports,
+    bool WarnDouble,
+    bool ProfileGenerate,
+    const std::string &ProfileUseFile,
+    bool Instrument,
+    bool LTOOnly) {
   if (IOFiles.empty())
     return true;
 
@@ -285,6 +416,46 @@ bool SlangRS::compile(
   }
 
   mAllowRSPrefix = AllowRSPrefix;
+  mSpecializations = Specializations;
+  mPrintKernelCost = PrintKernelCost;
+  mPrintCodeReport = PrintCodeReport;
+  mStripRSDebug = StripRSDebug;
+
+  // The backend appends the remarks of each input file
+  mOptRemarks = OptRemarks;
+  mOptRemarksFile = OptRemarksFile;
+  if (!mOptRemarksFile.empty()) {
+    std::string ErrorInfo;
+    llvm::raw_fd_ostream OS(mOptRemarksFile.c_str(), ErrorInfo);
+    if (!ErrorInfo.empty()) {
+      getDiagnostics().Report(mDiagErrorOptRemarksFile) << mOptRemarksFile
+                                                        << ErrorInfo;
+      return false;
+    }
+    OS << "# export\tpass\tdecision\tfile\tline\tcolumn\tfunction\tcallee\n";
+  }
+  mWarnDouble = WarnDouble;
+
+  mInstrument = Instrument;
+  mLTOOnly = LTOOnly;
+
+  mProfileGenerate = ProfileGenerate;
+  mProfile = RSProfile();
+  mHasProfile = !ProfileUseFile.empty();
+  if (mHasProfile) {
+    std::string Error;
+    if (!mProfile.load(ProfileUseFile, Error)) {
+      getDiagnostics().Report(mDiagErrorProfileFile) << ProfileUseFile
+                                                     << Error;
+      return false;
+    }
+  }
+
+  mJavaUsage.clear();
+  mHasJavaUsage = !JavaUsageFile.empty();
+  mStripUnusedExports = StripUnusedExports && mHasJavaUsage;
+  if (mHasJavaUsage && !loadJavaUsage(JavaUsageFile))
+    return false;
 
   mTargetAPI = TargetAPI;
   if (mTargetAPI < SLANG_MINIMUM_TARGET_API ||
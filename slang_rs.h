@@ -24,8 +24,12 @@
 #include <utility>
 #include <vector>
 
+#include "clang/Frontend/CodeGenOptions.h"
+
 #include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 
+#include "slang_rs_profile.h"
 #include "slang_rs_reflect_utils.h"
 #include "slang_version.h"
 
@@ -46,10 +50,43 @@ class SlangRS : public Slang {
 
   unsigned int mTargetAPI;
 
+  // "var=value" pairs given with -specialize
+  std::vector<std::string> mSpecializations;
+
+  bool mPrintKernelCost;
+  bool mPrintCodeReport;
+
+  bool mStripRSDebug;
+
+  bool mOptRemarks;
+  std::string mOptRemarksFile;
+  // The code generation options with debug info turned on, which the
+  // optimization remarks need to locate call sites and loops
+  clang::CodeGenOptions mRemarksCodeGenOpts;
+
+  // Reflected Java members used by the app, read from -java-usage-file
+  llvm::StringSet<> mJavaUsage;
+  bool mHasJavaUsage;
+  bool mStripUnusedExports;
+
+  bool mWarnDouble;
+
+  // -profile-generate, and the profile read from -profile-use
+  bool mProfileGenerate;
+  RSProfile mProfile;
+  bool mHasProfile;
+
+  bool mInstrument;
+
+  bool mLTOOnly;
+
   // Custom diagnostic identifiers
   unsigned mDiagErrorInvalidOutputDepParameter;
   unsigned mDiagErrorODR;
   unsigned mDiagErrorTargetAPIRange;
+  unsigned mDiagErrorJavaUsageFile;
+  unsigned mDiagErrorOptRemarksFile;
+  unsigned mDiagErrorProfileFile;
 
   // Collect generated filenames (without the .java) for dependency generation
   std::vector<std::string> mGeneratedFileNames;
@@ -76,6 +113,8 @@ class SlangRS : public Slang {
   // and is valid before compile() ends.
   bool checkODR(const char *CurInputFile);
 
+  bool loadJavaUsage(const std::string &JavaUsageFile);
+
  protected:
   virtual void initDiagnostic();
   virtual void initPreprocessor();
@@ -124,6 +163,44 @@ class SlangRS : public Slang {
   //                              line. This may override the package name
   //                              specified in the .rs using #pragma.
   //
+  // @Specializations - "var=value" pairs given by user in command line. These
+  //                    override the ones given by #pragma rs specialize.
+  //
+  // @PrintKernelCost - true to print the estimated cost of each kernel.
+  //
+  // @PrintCodeReport - true to print the stack frame, spills and code size
+  //                    of each function (or its size in the bitcode).
+  //
+  // @StripRSDebug - true to remove the rsDebug() calls.
+  //
+  // @OptRemarks - true to print the inlining, unrolling and builtin folding
+  //               decisions made for each kernel and invokable.
+  //
+  // @OptRemarksFile - File to write these decisions to as tab-separated
+  //                   values, if not empty.
+  //
+  // @JavaUsageFile - File listing the reflected Java members (set_foo,
+  //                  invoke_bar, ...) the app uses, one per line. If given,
+  //                  unused exports are reported.
+  //
+  // @StripUnusedExports - true to stop exporting the unused variables and
+  //                       invokables (requires @JavaUsageFile).
+  //
+  // @WarnDouble - true to warn about implicit double-precision arithmetic in
+  //               kernels and invokables (-Wrs-double).
+  //
+  // @ProfileGenerate - true to make the script count how often its blocks
+  //                    run and its branches are taken.
+  //
+  // @ProfileUseFile - Profile (as written by a run of a script compiled with
+  //                   @ProfileGenerate) to optimize for, if not empty.
+  //
+  // @Instrument - true to build in the -instrument counters, and make
+  //               RS_REGION_BEGIN()/RS_REGION_END() mark counted regions.
+  //
+  // @LTOOnly - true to only clean up the code, leaving its optimization to
+  //            llvm-rs-link.
+  //
   bool compile(const std::list<std::pair<const char*, const char*> > &IOFiles,
                const std::list<std::pair<const char*, const char*> > &DepFiles,
                const std::vector<std::string> &IncludePaths,
@@ -132,7 +209,20 @@ class SlangRS : public Slang {
                bool AllowRSPrefix, bool OutputDep,
                unsigned int TargetAPI,
                const std::string &JavaReflectionPathBase,
-               const std::string &JavaReflectionPackageName);
+               const std::string &JavaReflectionPackageName,
+               const std::vector<std::string> &Specializations,
+               bool PrintKernelCost,
+               bool PrintCodeReport,
+               bool StripRSDebug,
+               bool OptRemarks,
+               const std::string &OptRemarksFile,
+               const std::string &JavaUsageFile,
+               bool StripUnusedExports,
+               bool WarnDouble,
+               bool ProfileGenerate,
+               const std::string &ProfileUseFile,
+               bool Instrument,
+               bool LTOOnly);
 
   virtual void reset();
 
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_access_pattern.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "llvm/Analysis/ValueTracking.h"
+
+#include "llvm/Constants.h"
+#include "llvm/Function.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/Instructions.h"
+
+#include "llvm/Support/InstIterator.h"
+
+#include "slang_rs_passes.h"
+
+namespace slang {
+
+namespace {
+
+// Nesting limit for the expressions an index is computed with
+static const unsigned MaxDepth = 8;
+
+// CX * x + CY * y + (something that does not vary across the launch)
+struct Affine {
+  bool Known;
+  int64_t CX;
+  int64_t CY;
+
+  Affine() : Known(false), CX(0), CY(0) {
+    return;
+  }
+
+  Affine(int64_t X, int64_t Y) : Known(true), CX(X), CY(Y) {
+    return;
+  }
+
+  inline bool isInvariant() const { return Known && (CX == 0) && (CY == 0); }
+};
+
+class IndexEvaluator {
+ private:
+  llvm::Value *mX;
+  llvm::Value *mY;
+  std::map<const llvm::Value*, Affine> mCache;
+
+  Affine evaluateInstruction(llvm::Instruction *I, unsigned Depth) {
+    switch (I->getOpcode()) {
+      case llvm::Instruction::ZExt:
+      case llvm::Instruction::SExt:
+      case llvm::Instruction::Trunc:
+      case llvm::Instruction::BitCast: {
+        return evaluate(I->getOperand(0), Depth + 1);
+      }
+      case llvm::Instruction::Add:
+      case llvm::Instruction::Sub: {
+        Affine L = evaluate(I->getOperand(0), Depth + 1);
+        Affine R = evaluate(I->getOperand(1), Depth + 1);
+        if (!L.Known || !R.Known)
+          return Affine();
+        if (I->getOpcode() == llvm::Instruction::Add)
+          return Affine(L.CX + R.CX, L.CY + R.CY);
+        return Affine(L.CX - R.CX, L.CY - R.CY);
+      }
+      case llvm::Instruction::Mul:
+      case llvm::Instruction::Shl: {
+        Affine L = evaluate(I->getOperand(0), Depth + 1);
+        Affine R = evaluate(I->getOperand(1), Depth + 1);
+        if (L.isInvariant() && R.isInvariant())
+          return Affine(0, 0);
+
+        // Scaling by a constant keeps the index affine
+        llvm::ConstantInt *C =
+            llvm::dyn_cast<llvm::ConstantInt>(I->getOperand(1));
+        Affine A = L;
+        if ((C == NULL) && (I->getOpcode() == llvm::Instruction::Mul)) {
+          C = llvm::dyn_cast<llvm::ConstantInt>(I->getOperand(0));
+          A = R;
+        }
+        if (!A.Known || (C == NULL) || (C->getBitWidth() > 64))
+          return Affine();
+
+        int64_t Factor = C->getSExtValue();
+        if (I->getOpcode() == llvm::Instruction::Shl) {
+          if ((Factor < 0) || (Factor > 30))
+            return Affine();
+          Factor = static_cast<int64_t>(1) << Factor;
+        }
+        return Affine(A.CX * Factor, A.CY * Factor);
+      }
+      case llvm::Instruction::Load: {
+        // Loads from script globals (e.g. a width set from Java) are the same
+        // for every element
+        llvm::Value *Base = llvm::GetUnderlyingObject(
+            llvm::cast<llvm::LoadInst>(I)->getPointerOperand());
+        if (llvm::isa<llvm::GlobalVariable>(Base))
+          return Affine(0, 0);
+        return Affine();
+      }
+      case llvm::Instruction::Call: {
+        // Runtime queries such as rsAllocationGetDimX() of invariant
+        // arguments
+        llvm::CallInst *CI = llvm::cast<llvm::CallInst>(I);
+        llvm::Function *Callee = CI->getCalledFunction();
+        if ((Callee == NULL) || !Callee->isDeclaration() ||
+            !GetRSBuiltinName(Callee).startswith("rsAllocationGetDim"))
+          return Affine();
+        return Affine(0, 0);
+      }
+      default: {
+        // Other arithmetic is invariant if its operands are
+        for (unsigned i = 0, e = I->getNumOperands(); i != e; i++) {
+          if (!evaluate(I->getOperand(i), Depth + 1).isInvariant())
+            return Affine();
+        }
+        if (llvm::isa<llvm::BinaryOperator>(I) || llvm::isa<llvm::CastInst>(I))
+          return Affine(0, 0);
+        return Affine();
+      }
+    }
+  }
+
+ public:
+  IndexEvaluator(llvm::Value *X, llvm::Value *Y) : mX(X), mY(Y) {
+    return;
+  }
+
+  Affine evaluate(llvm::Value *V, unsigned Depth) {
+    if ((mX != NULL) && (V == mX))
+      return Affine(1, 0);
+    if ((mY != NULL) && (V == mY))
+      return Affine(0, 1);
+    if (llvm::isa<llvm::Constant>(V) || llvm::isa<llvm::Argument>(V))
+      return Affine(0, 0);
+
+    llvm::Instruction *I = llvm::dyn_cast<llvm::Instruction>(V);
+    if ((I == NULL) || (Depth > MaxDepth))
+      return Affine();
+
+    std::map<const llvm::Value*, Affine>::const_iterator C = mCache.find(V);
+    if (C != mCache.end())
+      return C->second;
+
+    Affine A = evaluateInstruction(I, Depth);
+    mCache[V] = A;
+    return A;
+  }
+};
+
+}  // namespace
+
+RSAccessPattern RSAccessPattern::Analyze(llvm::Function *F,
+                                         llvm::Value *X,
+                                         llvm::Value *Y) {
+  RSAccessPattern Pattern;
+  IndexEvaluator Evaluator(X, Y);
+
+  for (llvm::inst_iterator I = llvm::inst_begin(F), E = llvm::inst_end(F);
+       I != E;
+       I++) {
+    llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+    if (CI == NULL)
+      continue;
+    llvm::StringRef Name = GetRSBuiltinName(CI->getCalledFunction());
+    if ((Name != "rsGetElementAt") && (Name != "rsSetElementAt"))
+      continue;
+
+    // The indices are the integer arguments following the allocation (and,
+    // for rsSetElementAt(), the element pointer)
+    std::vector<Affine> Indices;
+    for (unsigned i = 1, e = CI->getNumArgOperands(); i != e; i++) {
+      llvm::Value *Arg = CI->getArgOperand(i);
+      if (Arg->getType()->isIntegerTy())
+        Indices.push_back(Evaluator.evaluate(Arg, 0));
+    }
+
+    Access A;
+    A.Call = CI;
+    A.C = AP_Invariant;
+    A.XStride = 0;
+    for (unsigned i = 0, e = Indices.size(); i != e; i++) {
+      if (!Indices[i].Known) {
+        A.C = AP_Gather;
+        break;
+      }
+      if (Indices[i].CX == 0)
+        continue;
+      if ((i == 0) && ((Indices[i].CX == 1) || (Indices[i].CX == -1))) {
+        if (A.C == AP_Invariant)
+          A.C = AP_Contiguous;
+      } else {
+        A.C = AP_Strided;
+        if (i == 0)
+          A.XStride = Indices[i].CX;
+      }
+    }
+
+    Pattern.mAccesses.push_back(A);
+    Pattern.mCount[A.C]++;
+  }
+
+  return Pattern;
+}
+
+std::string RSAccessPattern::getEncoding() const {
+  std::string Encoding;
+  for (unsigned i = 0; i < AP_NumClasses; i++) {
+    if (i > 0)
+      Encoding.append(",");
+    Encoding.append(llvm::utostr_32(mCount[i]));
+  }
+  return Encoding;
+}
+
+}  // namespace slang
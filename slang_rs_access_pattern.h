@@ -0,0 +1,97 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_ACCESS_PATTERN_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_ACCESS_PATTERN_H_
+
+#include <string>
+#include <vector>
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+  class CallInst;
+  class Function;
+  class Value;
+}  // namespace llvm
+
+namespace slang {
+
+// Classification of the rsGetElementAt() and rsSetElementAt() calls in a
+// forEach kernel (after inlining) by how their indices move as the kernel's
+// x parameter, the innermost dimension of the launch, advances:
+//
+//   AP_Contiguous - the x index is x + c and the other indices do not depend
+//                   on x, so neighboring threads touch neighboring elements
+//   AP_Invariant  - no index depends on x
+//   AP_Strided    - the indices are affine in x, but either the x index moves
+//                   by more than one element per x, or another index (e.g. y
+//                   in rsGetElementAt(a, y, x)) depends on x
+//   AP_Gather     - some index is not an affine function of x and y, e.g. it
+//                   comes from data loaded from an allocation
+class RSAccessPattern {
+ public:
+  enum Class {
+    AP_Contiguous,
+    AP_Invariant,
+    AP_Strided,
+    AP_Gather,
+    AP_NumClasses
+  };
+
+  struct Access {
+    llvm::CallInst *Call;
+    Class C;
+    // For AP_Strided: the number of elements the x index moves per x (0 if
+    // it is another index that depends on x)
+    int64_t XStride;
+  };
+
+ private:
+  std::vector<Access> mAccesses;
+  unsigned mCount[AP_NumClasses];
+
+ public:
+  RSAccessPattern() {
+    for (unsigned i = 0; i < AP_NumClasses; i++)
+      mCount[i] = 0;
+    return;
+  }
+
+  // Classify the accesses in @F, whose x and y parameters are @X and @Y (NULL
+  // if the kernel does not take them)
+  static RSAccessPattern Analyze(llvm::Function *F,
+                                 llvm::Value *X,
+                                 llvm::Value *Y);
+
+  inline unsigned get(Class C) const { return mCount[C]; }
+
+  typedef std::vector<Access>::const_iterator const_access_iterator;
+  inline const_access_iterator accesses_begin() const {
+    return mAccesses.begin();
+  }
+  inline const_access_iterator accesses_end() const {
+    return mAccesses.end();
+  }
+
+  // "<contiguous>,<invariant>,<strided>,<gather>", as recorded in
+  // RS_EXPORT_FOREACH_ACCESS_MN
+  std::string getEncoding() const;
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_ACCESS_PATTERN_H_  NOLINT
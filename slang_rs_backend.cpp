@@ -16,29 +16,53 @@
 
 #include "slang_rs_backend.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/Stmt.h"
+
 #include "llvm/ADT/Twine.h"
 #include "llvm/ADT/StringExtras.h"
 
+#include "llvm/Analysis/ValueTracking.h"
+
 #include "llvm/Constant.h"
 #include "llvm/Constants.h"
 #include "llvm/DerivedTypes.h"
 #include "llvm/Function.h"
+#include "llvm/Instructions.h"
 #include "llvm/Metadata.h"
 #include "llvm/Module.h"
 
 #include "llvm/Support/IRBuilder.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "llvm/Target/TargetData.h"
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #include "slang_assert.h"
 #include "slang_rs.h"
+#include "slang_rs_access_pattern.h"
 #include "slang_rs_context.h"
 #include "slang_rs_export_foreach.h"
 #include "slang_rs_export_func.h"
 #include "slang_rs_export_type.h"
 #include "slang_rs_export_var.h"
+#include "slang_rs_instrumentation.h"
+#include "slang_rs_internalize.h"
+#include "slang_rs_kernel_cost.h"
 #include "slang_rs_metadata.h"
+#include "slang_rs_passes.h"
+#include "slang_rs_side_effects.h"
 
 namespace slang {
 
@@ -50,19 +74,63 @@ RSBackend::RSBackend(RSContext *Context,
                      llvm::raw_ostream *OS,
                      Slang::OutputType OT,
                      clang::SourceManager &SourceMgr,
-                     bool AllowRSPrefix)
+                     bool AllowRSPrefix,
+                     bool PrintKernelCost,
+                     bool PrintCodeReport,
+                     bool StripRSDebug,
+                     bool PrintOptRemarks,
+                     const std::string &OptRemarksFile,
+                     bool WarnDouble,
+                     bool ProfileGenerate,
+                     const RSProfile *Profile,
+                     bool Instrument,
+                     bool LTOOnly)
   : Backend(DiagEngine, CodeGenOpts, TargetOpts, Pragmas, OS, OT),
     mContext(Context),
     mSourceMgr(SourceMgr),
     mAllowRSPrefix(AllowRSPrefix),
+    mPrintKernelCost(PrintKernelCost),
+    mPrintCodeReport(PrintCodeReport),
+    mWarnDouble(WarnDouble),
+    mStripRSDebug(StripRSDebug),
+    mPrintOptRemarks(PrintOptRemarks),
+    mOptRemarksFile(OptRemarksFile),
+    mInstrument(Instrument),
+    mProfileGenerate(ProfileGenerate),
+    mProfile(Profile),
+    mLTOOnly(LTOOnly),
     mExportVarMetadata(NULL),
     mExportFuncMetadata(NULL),
     mExportForEachMetadata(NULL),
+    mExportForEachNameMetadata(NULL),
     mExportTypeMetadata(NULL),
     mRSObjectSlotsMetadata(NULL),
     mRefCount(mContext->getASTContext()) {
 }
 
+Backend::FPPrecision RSBackend::getFPPrecision() const {
+  if (mContext->isFPImprecise())
+    return FP_Imprecise;
+  else if (mContext->isFPRelaxed())
+    return FP_Relaxed;
+  return FP_Full;
+}
+
+void RSBackend::PopulateModulePasses(llvm::PassManagerBuilder &PMBuilder) {
+  PopulateRSPassExtensions(PMBuilder,
+                           getFPPrecision() != FP_Full,
+                           mContext->getLoopHints().hasUnrollHint());
+  return;
+}
+
+bool RSBackend::GetExternalSymbols(llvm::Module *M,
+                                   std::vector<const char *> &Names) {
+  // The export metadata has been written by now (in HandleTranslationUnitPost)
+  bool Valid = GetRSExternalSymbols(M, Names);
+  slangAssert(Valid && "Malformed export metadata");
+  return Valid;
+}
+
 // 1) Add zero initialization of local RS object types
 void RSBackend::AnnotateFunction(clang::FunctionDecl *FD) {
   if (FD &&
@@ -103,12 +171,513 @@ void RSBackend::HandleTopLevelDecl(clang::DeclGroupRef D) {
     }
   }
 
+  // Collect the functions the script defines for -Wrs-double
+  if (mWarnDouble) {
+    for (clang::DeclGroupRef::iterator I = D.begin(), E = D.end();
+         I != E; I++) {
+      clang::FunctionDecl *FD = llvm::dyn_cast<clang::FunctionDecl>(*I);
+      if (FD && FD->doesThisDeclarationHaveABody() &&
+          !SlangRS::IsFunctionInRSHeaderFile(FD, mSourceMgr))
+        mDoubleLint.addFunction(FD);
+    }
+  }
+
   Backend::HandleTopLevelDecl(D);
   return;
 }
 
 namespace {
 
+// Call one stage of a fused kernel, passing x and y only if the stage takes
+// them (as given by its metadata encoding).
+static void CallFusedStage(llvm::IRBuilder<> &IB,
+                           llvm::Function *F,
+                           const RSExportForEach *Stage,
+                           llvm::Value *In,
+                           llvm::Value *Out,
+                           llvm::Value *X,
+                           llvm::Value *Y) {
+  llvm::FunctionType *FT = F->getFunctionType();
+  llvm::SmallVector<llvm::Value*, 4> Args;
+
+  Args.push_back(IB.CreatePointerCast(In, FT->getParamType(0)));
+  Args.push_back(IB.CreatePointerCast(Out, FT->getParamType(1)));
+  if (Stage->getMetadataEncoding() & RSExportForEach::ME_X)
+    Args.push_back(X);
+  if (Stage->getMetadataEncoding() & RSExportForEach::ME_Y)
+    Args.push_back(Y);
+
+  llvm::CallInst *CI = IB.CreateCall(F, Args);
+  CI->setCallingConv(F->getCallingConv());
+  return;
+}
+
+// Return true if @AI is written exactly once (by @SI) and only read
+// otherwise, as is the case for the parameter copies made by clang codegen.
+static bool IsSingleStoreAlloca(llvm::AllocaInst *AI, llvm::StoreInst *SI) {
+  for (llvm::Value::use_iterator UI = AI->use_begin(), UE = AI->use_end();
+       UI != UE;
+       UI++) {
+    if (*UI != SI && !llvm::isa<llvm::LoadInst>(*UI))
+      return false;
+  }
+  return true;
+}
+
+// Raise the alignment of the loads and stores through @Ptr, which is known to
+// be aligned to @Align bytes. Copies of @Ptr spilled to a local variable are
+// followed as well, since this runs before mem2reg.
+static void RaiseAccessAlignment(llvm::Value *Ptr,
+                                 unsigned Align,
+                                 const llvm::TargetData *TD) {
+  for (llvm::Value::use_iterator UI = Ptr->use_begin(), UE = Ptr->use_end();
+       UI != UE;
+       UI++) {
+    llvm::User *U = *UI;
+    if (llvm::LoadInst *LI = llvm::dyn_cast<llvm::LoadInst>(U)) {
+      unsigned Cur = LI->getAlignment();
+      if (Cur == 0)
+        Cur = TD->getABITypeAlignment(LI->getType());
+      if (Cur < Align)
+        LI->setAlignment(Align);
+    } else if (llvm::StoreInst *SI = llvm::dyn_cast<llvm::StoreInst>(U)) {
+      if (SI->getPointerOperand() == Ptr) {
+        unsigned Cur = SI->getAlignment();
+        if (Cur == 0)
+          Cur = TD->getABITypeAlignment(SI->getValueOperand()->getType());
+        if (Cur < Align)
+          SI->setAlignment(Align);
+      } else if (llvm::AllocaInst *AI =
+                     llvm::dyn_cast<llvm::AllocaInst>(SI->getPointerOperand())) {
+        if (!IsSingleStoreAlloca(AI, SI))
+          continue;
+        for (llvm::Value::use_iterator AUI = AI->use_begin(),
+                 AUE = AI->use_end();
+             AUI != AUE;
+             AUI++) {
+          if (llvm::isa<llvm::LoadInst>(*AUI))
+            RaiseAccessAlignment(*AUI, Align, TD);
+        }
+      }
+    } else if (llvm::isa<llvm::BitCastInst>(U)) {
+      RaiseAccessAlignment(U, Align, TD);
+    } else if (llvm::GetElementPtrInst *GEP =
+                   llvm::dyn_cast<llvm::GetElementPtrInst>(U)) {
+      if (GEP->getPointerOperand() != Ptr || !GEP->hasAllConstantIndices())
+        continue;
+      llvm::SmallVector<llvm::Value*, 4> Indices(GEP->idx_begin(),
+                                                 GEP->idx_end());
+      uint64_t Offset = TD->getIndexedOffset(Ptr->getType(), Indices);
+      RaiseAccessAlignment(GEP, llvm::MinAlign(Align, Offset), TD);
+    }
+  }
+  return;
+}
+
+// Return the alignment the runtime guarantees for the elements pointed to by
+// a forEach in/out parameter of type @ET, i.e. the element size rounded down
+// to a power of two (but at most 16 bytes).
+static unsigned GetElementAlignment(const RSExportType *ET) {
+  if (ET == NULL || ET->getClass() != RSExportType::ExportClassPointer)
+    return 0;
+
+  const RSExportType *PointeeET =
+      static_cast<const RSExportPointerType*>(ET)->getPointeeType();
+  size_t Size = RSExportType::GetTypeAllocSize(PointeeET);
+  if (Size == 0)
+    return 0;
+  return static_cast<unsigned>(llvm::MinAlign(Size, 16));
+}
+
+// Add the functions that use @V (through constant expressions as well) to
+// @Funcs.
+static void CollectUserFunctions(llvm::Value *V,
+                                 std::vector<llvm::Function*> &Funcs) {
+  for (llvm::Value::use_iterator UI = V->use_begin(), UE = V->use_end();
+       UI != UE;
+       UI++) {
+    if (llvm::Instruction *I = llvm::dyn_cast<llvm::Instruction>(*UI))
+      Funcs.push_back(I->getParent()->getParent());
+    else if (llvm::isa<llvm::ConstantExpr>(*UI))
+      CollectUserFunctions(*UI, Funcs);
+  }
+  return;
+}
+
+// Compute the functions that read one of @GVs, directly or through a call.
+static void CollectReadingFunctions(
+    const std::vector<llvm::GlobalVariable*> &GVs,
+    std::set<llvm::Function*> &Readers) {
+  std::vector<llvm::Function*> Worklist;
+  for (unsigned i = 0, e = GVs.size(); i != e; i++)
+    CollectUserFunctions(GVs[i], Worklist);
+
+  while (!Worklist.empty()) {
+    llvm::Function *F = Worklist.back();
+    Worklist.pop_back();
+    if (Readers.insert(F).second)
+      CollectUserFunctions(F, Worklist);
+  }
+  return;
+}
+
+// Return true if @F is one of @Targets or calls one, directly or through other
+// functions defined in the module.
+static bool CallsAnyOf(const llvm::Function *F,
+                       const std::set<const llvm::Function*> &Targets,
+                       std::set<const llvm::Function*> &Visited) {
+  if (Targets.count(F))
+    return true;
+  if (!Visited.insert(F).second)
+    return false;
+
+  for (llvm::const_inst_iterator I = llvm::inst_begin(F), E = llvm::inst_end(F);
+       I != E;
+       I++) {
+    const llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+    if (CI == NULL)
+      continue;
+    const llvm::Function *Callee = CI->getCalledFunction();
+    if (Callee && !Callee->isDeclaration() &&
+        CallsAnyOf(Callee, Targets, Visited))
+      return true;
+  }
+  return false;
+}
+
+// Return the constant of type @Ty for the normalized specialization @Value.
+static llvm::Constant *GetSpecializedValue(llvm::Type *Ty,
+                                           const std::string &Value) {
+  if (llvm::IntegerType *ITy = llvm::dyn_cast<llvm::IntegerType>(Ty))
+    return llvm::ConstantInt::get(ITy, Value, 10);
+  if (Ty->isFloatingPointTy())
+    return llvm::ConstantFP::get(Ty, Value);
+  return NULL;
+}
+
+}  // namespace
+
+// The runtime passes distinct allocations to in, out and usrData (unless the
+// kernel is declared in-place with #pragma rs inplace), and aligns elements
+// to their size. Tell LLVM so it can reorder and widen memory accesses.
+void RSBackend::AnnotateForEachParams(llvm::Module *M,
+                                      const RSExportForEach *EFE) {
+  llvm::Function *F = M->getFunction(EFE->getName());
+  slangAssert(F && "Function marked as forEach disappeared in Bitcode");
+
+  unsigned int Encoding = EFE->getMetadataEncoding();
+  // Specialized kernels are in-place if their generic kernel is
+  const RSExportForEach *Generic =
+      EFE->isSpecialized() ? EFE->getSpecializedFrom() : EFE;
+  bool InPlace = mContext->isInPlaceKernel(Generic->getName());
+  const llvm::TargetData *TD = mContext->getTargetData();
+  llvm::Function::arg_iterator AI = F->arg_begin();
+  // Parameter attribute indices start at 1 (0 is the return value)
+  unsigned int Idx = 1;
+
+  if (Encoding & RSExportForEach::ME_In) {
+    if (!InPlace)
+      F->setDoesNotAlias(Idx);
+    if (unsigned Align = GetElementAlignment(EFE->getInType()))
+      RaiseAccessAlignment(AI, Align, TD);
+    AI++;
+    Idx++;
+  }
+
+  if (Encoding & RSExportForEach::ME_Out) {
+    if (!InPlace)
+      F->setDoesNotAlias(Idx);
+    if (unsigned Align = GetElementAlignment(EFE->getOutType()))
+      RaiseAccessAlignment(AI, Align, TD);
+    AI++;
+    Idx++;
+  }
+
+  if (Encoding & RSExportForEach::ME_UsrData) {
+    F->setDoesNotAlias(Idx);
+  }
+
+  return;
+}
+
+// Synthesize the body of a fused kernel: both stages run back to back on
+// each element, with the intermediate value kept in a stack slot instead of
+// a temporary allocation.
+void RSBackend::CreateFusedKernel(llvm::Module *M,
+                                  const RSExportForEach *EFE) {
+  const RSExportForEach *First = EFE->getFusedFirst();
+  const RSExportForEach *Second = EFE->getFusedSecond();
+  llvm::Function *FirstF = M->getFunction(First->getName());
+  llvm::Function *SecondF = M->getFunction(Second->getName());
+  slangAssert(FirstF && SecondF &&
+              "Function marked as fused disappeared in Bitcode");
+
+  llvm::Type *Int32Ty = llvm::Type::getInt32Ty(mLLVMContext);
+  llvm::PointerType *TmpPtrTy = llvm::cast<llvm::PointerType>(
+      FirstF->getFunctionType()->getParamType(1));
+
+  std::vector<llvm::Type*> Params;
+  Params.push_back(FirstF->getFunctionType()->getParamType(0));
+  Params.push_back(SecondF->getFunctionType()->getParamType(1));
+  if (EFE->getMetadataEncoding() & RSExportForEach::ME_X)
+    Params.push_back(Int32Ty);
+  if (EFE->getMetadataEncoding() & RSExportForEach::ME_Y)
+    Params.push_back(Int32Ty);
+
+  llvm::FunctionType *FT =
+      llvm::FunctionType::get(llvm::Type::getVoidTy(mLLVMContext),
+                              Params,
+                              /* IsVarArgs = */false);
+  llvm::Function *F =
+      llvm::Function::Create(FT,
+                             llvm::GlobalValue::ExternalLinkage,
+                             EFE->getName(),
+                             M);
+
+  llvm::Function::arg_iterator AI = F->arg_begin();
+  llvm::Value *In = AI++;
+  llvm::Value *Out = AI++;
+  llvm::Value *X = NULL;
+  llvm::Value *Y = NULL;
+  if (EFE->getMetadataEncoding() & RSExportForEach::ME_X)
+    X = AI++;
+  if (EFE->getMetadataEncoding() & RSExportForEach::ME_Y)
+    Y = AI++;
+
+  llvm::BasicBlock *BB = llvm::BasicBlock::Create(mLLVMContext, "entry", F);
+  llvm::IRBuilder<> IB(BB);
+  llvm::Value *Tmp =
+      IB.CreateAlloca(TmpPtrTy->getElementType(), 0, "fuse.tmp");
+
+  CallFusedStage(IB, FirstF, First, In, Tmp, X, Y);
+  CallFusedStage(IB, SecondF, Second, Tmp, Out, X, Y);
+  IB.CreateRetVoid();
+
+  return;
+}
+
+// Clone the generic kernel and bake the values given by #pragma rs specialize
+// into the clone. Helpers reading a specialized global are inlined first, so
+// the optimizer can fold the constants through the whole kernel.
+void RSBackend::CreateSpecializedKernel(llvm::Module *M,
+                                        const RSExportForEach *EFE) {
+  const RSExportForEach *Base = EFE->getSpecializedFrom();
+  llvm::Function *BaseF = M->getFunction(Base->getName());
+  slangAssert(BaseF && "Function marked as specialized disappeared in Bitcode");
+
+  llvm::ValueToValueMapTy VMap;
+  llvm::Function *F = llvm::CloneFunction(BaseF, VMap,
+                                          /* ModuleLevelChanges = */false);
+  F->setName(EFE->getName());
+  M->getFunctionList().push_back(F);
+
+  std::vector<llvm::GlobalVariable*> GVs;
+  std::vector<llvm::Constant*> Values;
+  for (RSContext::const_specialization_iterator
+           I = mContext->specializations_begin(),
+           E = mContext->specializations_end();
+       I != E;
+       I++) {
+    llvm::GlobalVariable *GV = M->getGlobalVariable(I->first, true);
+    if (GV == NULL)
+      continue;  // Never referenced
+    llvm::Constant *C = GetSpecializedValue(GV->getType()->getElementType(),
+                                            I->second);
+    slangAssert(C && "Specialized variable has no primitive type");
+    GVs.push_back(GV);
+    Values.push_back(C);
+  }
+
+  std::set<llvm::Function*> Readers;
+  CollectReadingFunctions(GVs, Readers);
+
+  // Bound the inlining, since helpers may be recursive
+  static const int MaxInlineRounds = 8;
+  for (int Round = 0; Round < MaxInlineRounds; Round++) {
+    std::vector<llvm::CallInst*> Calls;
+    for (llvm::inst_iterator I = llvm::inst_begin(F), E = llvm::inst_end(F);
+         I != E;
+         I++) {
+      llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+      if (CI == NULL)
+        continue;
+      llvm::Function *Callee = CI->getCalledFunction();
+      if (Callee && !Callee->isDeclaration() && Readers.count(Callee))
+        Calls.push_back(CI);
+    }
+    if (Calls.empty())
+      break;
+
+    for (unsigned i = 0, e = Calls.size(); i != e; i++) {
+      llvm::InlineFunctionInfo IFI(NULL, mContext->getTargetData());
+      llvm::InlineFunction(Calls[i], IFI);
+    }
+  }
+
+  for (unsigned i = 0, e = GVs.size(); i != e; i++) {
+    // The value may only be baked in if nothing the kernel runs can write the
+    // variable: not the kernel itself, nor any function it still calls
+    // (e.g. a helper that only writes it, and so was not inlined above)
+    std::set<const llvm::Function*> Writers;
+    std::set<const llvm::Function*> Visited;
+    if (!RSSideEffects::GetWriters(GVs[i], Writers) ||
+        CallsAnyOf(F, Writers, Visited)) {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "kernel '%0' may write '%1' (directly or through the functions it "
+          "calls), so '%2' is not specialized on it"))
+          << Base->getName() << GVs[i]->getName() << EFE->getName();
+      continue;
+    }
+
+    std::vector<llvm::LoadInst*> Loads;
+    for (llvm::inst_iterator I = llvm::inst_begin(F), E = llvm::inst_end(F);
+         I != E;
+         I++) {
+      if (llvm::LoadInst *LI = llvm::dyn_cast<llvm::LoadInst>(&*I)) {
+        if (LI->getPointerOperand() == GVs[i] && !LI->isVolatile())
+          Loads.push_back(LI);
+      }
+    }
+
+    for (unsigned j = 0, je = Loads.size(); j != je; j++) {
+      Loads[j]->replaceAllUsesWith(Values[i]);
+      Loads[j]->eraseFromParent();
+    }
+  }
+
+  return;
+}
+
+// Remove the calls to rsDebug() (all overloads), reporting each with a note.
+// What was computed only to be printed is then removed by the optimizer.
+void RSBackend::StripRSDebugCalls(llvm::Module *M) {
+  static const char RSDebugPrefix[] = "_Z7rsDebug";
+
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    // The overloads the headers define in terms of the others
+    if (F->getName().startswith(RSDebugPrefix))
+      continue;
+
+    std::vector<llvm::CallInst*> Calls;
+    for (llvm::inst_iterator I = llvm::inst_begin(F), IE = llvm::inst_end(F);
+         I != IE;
+         I++) {
+      llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+      if ((CI != NULL) && (CI->getCalledFunction() != NULL) &&
+          CI->getCalledFunction()->getName().startswith(RSDebugPrefix))
+        Calls.push_back(CI);
+    }
+
+    // The calls are in the order of the ones found in the AST, unless Clang
+    // generated no code for some of those; the notes then go without a
+    // location
+    const std::vector<clang::SourceLocation> *Locs = NULL;
+    llvm::StringMap<std::vector<clang::SourceLocation> >::const_iterator L =
+        mRSDebugCalls.find(F->getName());
+    if ((L != mRSDebugCalls.end()) && (L->getValue().size() == Calls.size()))
+      Locs = &L->getValue();
+
+    for (unsigned i = 0, e = Calls.size(); i != e; i++) {
+      llvm::CallInst *CI = Calls[i];
+      clang::FullSourceLoc Loc;
+      if (Locs != NULL)
+        Loc = clang::FullSourceLoc((*Locs)[i], mSourceMgr);
+
+      std::string Message;
+      if ((CI->getNumArgOperands() > 0) &&
+          llvm::GetConstantStringInfo(CI->getArgOperand(0), Message))
+        mDiagEngine.Report(Loc, mDiagEngine.getCustomDiagID(
+            clang::DiagnosticsEngine::Note,
+            "removed rsDebug(\"%0\", ...) from '%1'"))
+            << Message << F->getName();
+      else
+        mDiagEngine.Report(Loc, mDiagEngine.getCustomDiagID(
+            clang::DiagnosticsEngine::Note,
+            "removed a call to rsDebug() from '%0'"))
+            << F->getName();
+
+      if (!CI->use_empty())
+        CI->replaceAllUsesWith(llvm::UndefValue::get(CI->getType()));
+      CI->eraseFromParent();
+    }
+  }
+
+  return;
+}
+
+// Report the exported variables that the script never reads and the
+// invokables that the app never calls (as given by -java-usage-file), and
+// stop exporting the ones that are not used at all if asked to.
+void RSBackend::CheckUnusedExports(llvm::Module *M) {
+  bool Strip = mContext->shouldStripUnusedExports();
+  std::vector<const RSExportVar*> UnusedVars;
+  std::vector<const RSExportFunc*> UnusedFuncs;
+
+  for (RSContext::const_export_var_iterator I = mContext->export_vars_begin(),
+          E = mContext->export_vars_end();
+       I != E;
+       I++) {
+    const RSExportVar *EV = *I;
+    if (EV->isFoldedConst())
+      continue;
+
+    llvm::GlobalVariable *GV = M->getGlobalVariable(EV->getName(), true);
+    if (GV && RSSideEffects::IsRead(GV))
+      continue;
+
+    const std::string &Name = EV->getName();
+    bool UsedFromJava = mContext->isUsedFromJava("set_" + Name) ||
+                        mContext->isUsedFromJava("get_" + Name) ||
+                        mContext->isUsedFromJava("bind_" + Name);
+    if (Strip && !UsedFromJava) {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "exported variable '%0' is used by neither the script nor the app, "
+          "and is not exported"))
+          << Name;
+      UnusedVars.push_back(EV);
+    } else {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "exported variable '%0' is never read by the script"))
+          << Name;
+    }
+  }
+
+  for (RSContext::const_export_func_iterator
+          I = mContext->export_funcs_begin(),
+          E = mContext->export_funcs_end();
+       I != E;
+       I++) {
+    const RSExportFunc *EF = *I;
+    if (mContext->isUsedFromJava("invoke_" + EF->getName()))
+      continue;
+
+    if (Strip) {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "invokable '%0' is never called from Java, and is not exported"))
+          << EF->getName();
+      UnusedFuncs.push_back(EF);
+    } else {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "invokable '%0' is never called from Java"))
+          << EF->getName();
+    }
+  }
+
+  for (unsigned i = 0, e = UnusedVars.size(); i != e; i++)
+    mContext->removeExportVar(UnusedVars[i]);
+  for (unsigned i = 0, e = UnusedFuncs.size(); i != e; i++)
+    mContext->removeExportFunc(UnusedFuncs[i]);
+
+  return;
+}
+
+namespace {
+
 static bool ValidateVarDecl(clang::VarDecl *VD) {
   if (!VD) {
     return true;
@@ -145,6 +714,36 @@ static bool ValidateASTContext(clang::ASTContext &C) {
   return valid;
 }
 
+// Collect the locations of the calls to rsDebug() in @S, in the order Clang
+// generates their code
+static void CollectRSDebugCalls(clang::Stmt *S,
+                                std::vector<clang::SourceLocation> &Calls) {
+  // The increment of a for loop is generated after its body
+  if (clang::ForStmt *FS = llvm::dyn_cast<clang::ForStmt>(S)) {
+    clang::Stmt *Parts[] = {
+      FS->getInit(), FS->getCond(), FS->getBody(), FS->getInc()
+    };
+    for (unsigned i = 0; i < 4; i++)
+      if (Parts[i] != NULL)
+        CollectRSDebugCalls(Parts[i], Calls);
+    return;
+  }
+
+  if (clang::CallExpr *CE = llvm::dyn_cast<clang::CallExpr>(S)) {
+    clang::FunctionDecl *Callee = CE->getDirectCallee();
+    if ((Callee != NULL) && (Callee->getName() == "rsDebug"))
+      Calls.push_back(CE->getExprLoc());
+  }
+
+  for (clang::Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+       I != E;
+       I++) {
+    if (clang::Stmt *Child = *I)
+      CollectRSDebugCalls(Child, Calls);
+  }
+  return;
+}
+
 }  // namespace
 
 void RSBackend::HandleTranslationUnitPre(clang::ASTContext &C) {
@@ -185,6 +784,24 @@ void RSBackend::HandleTranslationUnitPre(clang::ASTContext &C) {
     }
   }
 
+  if (mWarnDouble)
+    mDoubleLint.check(C, mDiagEngine);
+
+  // Locate the rsDebug() calls that StripRSDebugCalls() will report
+  if (mStripRSDebug) {
+    for (clang::DeclContext::decl_iterator I = TUDecl->decls_begin(),
+            E = TUDecl->decls_end(); I != E; I++) {
+      clang::FunctionDecl *FD = llvm::dyn_cast<clang::FunctionDecl>(*I);
+      if (FD && FD->doesThisDeclarationHaveABody() &&
+          !SlangRS::IsFunctionInRSHeaderFile(FD, mSourceMgr))
+        CollectRSDebugCalls(FD->getBody(), mRSDebugCalls[FD->getName()]);
+    }
+  }
+
+  // Find the loops that #pragma rs unroll/nounroll/vectorize refer to
+  if (!mContext->getLoopHints().empty())
+    mContext->getLoopHints().resolve(C, mDiagEngine);
+
   return;
 }
 
@@ -194,13 +811,54 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
     return;
   }
 
+  // Attach the loop hints to the loops they refer to
+  if (!mContext->getLoopHints().empty())
+    mContext->getLoopHints().apply(M, mDiagEngine);
+
+  if (mStripRSDebug)
+    StripRSDebugCalls(M);
+
+  // Turn the const exported variables into internal constants, so that their
+  // values are propagated into the code and the variables go away
+  for (RSContext::const_export_var_iterator I = mContext->export_vars_begin(),
+          E = mContext->export_vars_end();
+       I != E;
+       I++) {
+    const RSExportVar *EV = *I;
+    if (!EV->isFoldedConst())
+      continue;
+
+    llvm::GlobalVariable *GV = M->getGlobalVariable(EV->getName(), true);
+    if (GV && GV->hasInitializer()) {
+      GV->setConstant(true);
+      GV->setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
+  }
+
+  if (mContext->hasJavaUsage())
+    CheckUnusedExports(M);
+
+  // Build the fused and specialized kernels first, so that the writers of
+  // the exported variables below include them
+  for (RSContext::const_export_foreach_iterator
+          I = mContext->export_foreach_begin(),
+          E = mContext->export_foreach_end();
+       I != E;
+       I++) {
+    const RSExportForEach *EFE = *I;
+    if (EFE->isFused())
+      CreateFusedKernel(M, EFE);
+    else if (EFE->isSpecialized())
+      CreateSpecializedKernel(M, EFE);
+  }
+
   // Dump export variable info
   if (mContext->hasExportVar()) {
     int slotCount = 0;
     if (mExportVarMetadata == NULL)
       mExportVarMetadata = M->getOrInsertNamedMetadata(RS_EXPORT_VAR_MN);
 
-    llvm::SmallVector<llvm::Value*, 2> ExportVarInfo;
+    llvm::SmallVector<llvm::Value*, 3> ExportVarInfo;
 
     // We emit slot information (#rs_object_slots) for any reference counted
     // RS type or pointer (which can also be bound).
@@ -213,6 +871,38 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
       const RSExportType *ET = EV->getType();
       bool countsAsRSObject = false;
 
+      // Folded into the code, without a slot
+      if (EV->isFoldedConst())
+        continue;
+
+      // The runtime need not synchronize a variable that the script never
+      // writes. Variables that forEach kernels write are pointed out, since
+      // they must be synchronized around every launch.
+      bool ReadOnly = true;
+      if (llvm::GlobalVariable *GV =
+              M->getGlobalVariable(EV->getName(), true)) {
+        std::set<const llvm::Function*> Writers;
+        ReadOnly = RSSideEffects::GetWriters(GV, Writers) && Writers.empty();
+
+        for (RSContext::const_export_foreach_iterator
+                FI = mContext->export_foreach_begin(),
+                FE = mContext->export_foreach_end();
+             !Writers.empty() && !EV->isConst() && (FI != FE);
+             FI++) {
+          const llvm::Function *KernelF = M->getFunction((*FI)->getName());
+          std::set<const llvm::Function*> Visited;
+          if (KernelF && CallsAnyOf(KernelF, Writers, Visited)) {
+            mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+                clang::DiagnosticsEngine::Note,
+                "exported variable '%0' is written by forEach kernel '%1', "
+                "so it must be synchronized with the Java side around every "
+                "launch"))
+                << EV->getName() << (*FI)->getName();
+            break;
+          }
+        }
+      }
+
       // Variable name
       ExportVarInfo.push_back(
           llvm::MDString::get(mLLVMContext, EV->getName().c_str()));
@@ -255,6 +945,10 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
         }
       }
 
+      // Read-only
+      ExportVarInfo.push_back(
+          llvm::MDString::get(mLLVMContext, ReadOnly ? "1" : "0"));
+
       mExportVarMetadata->addOperand(
           llvm::MDNode::get(mLLVMContext, ExportVarInfo));
       ExportVarInfo.clear();
@@ -408,7 +1102,12 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
       mExportForEachMetadata =
           M->getOrInsertNamedMetadata(RS_EXPORT_FOREACH_MN);
 
+    if (mExportForEachNameMetadata == NULL)
+      mExportForEachNameMetadata =
+          M->getOrInsertNamedMetadata(RS_EXPORT_FOREACH_NAME_MN);
+
     llvm::SmallVector<llvm::Value*, 1> ExportForEachInfo;
+    llvm::SmallVector<llvm::Value*, 1> ExportForEachName;
 
     for (RSContext::const_export_foreach_iterator
             I = mContext->export_foreach_begin(),
@@ -417,6 +1116,8 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
          I++) {
       const RSExportForEach *EFE = *I;
 
+      AnnotateForEachParams(M, EFE);
+
       ExportForEachInfo.push_back(
           llvm::MDString::get(mLLVMContext,
                               llvm::utostr_32(EFE->getMetadataEncoding())));
@@ -424,6 +1125,13 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
       mExportForEachMetadata->addOperand(
           llvm::MDNode::get(mLLVMContext, ExportForEachInfo));
       ExportForEachInfo.clear();
+
+      ExportForEachName.push_back(
+          llvm::MDString::get(mLLVMContext, EFE->getName().c_str()));
+
+      mExportForEachNameMetadata->addOperand(
+          llvm::MDNode::get(mLLVMContext, ExportForEachName));
+      ExportForEachName.clear();
     }
   }
 
@@ -508,6 +1216,285 @@ void RSBackend::HandleTranslationUnitPost(llvm::Module *M) {
     }
   }
 
+  if (mInstrument)
+    InstrumentExports(M);
+
+  // The profile counts the blocks and branches of the code as it is here,
+  // before any optimization
+  if (mProfileGenerate)
+    RSProfile::Instrument(M);
+  else if (mProfile != NULL)
+    ApplyProfile(M);
+
+  if (mPrintOptRemarks || !mOptRemarksFile.empty())
+    RecordOptRemarks(M);
+
+  // Have llvm-rs-link run the optimization skipped here, with the same FP
+  // precision
+  if (mLTOOnly) {
+    const char *Precision = RS_DEFERRED_OPT_FP_FULL;
+    if (getFPPrecision() == FP_Imprecise)
+      Precision = RS_DEFERRED_OPT_FP_IMPRECISE;
+    else if (getFPPrecision() == FP_Relaxed)
+      Precision = RS_DEFERRED_OPT_FP_RELAXED;
+
+    llvm::NamedMDNode *DeferredOptMetadata =
+        M->getOrInsertNamedMetadata(RS_DEFERRED_OPT_MN);
+    DeferredOptMetadata->addOperand(
+        llvm::MDNode::get(mLLVMContext,
+                          llvm::MDString::get(mLLVMContext, Precision)));
+  }
+
+  return;
+}
+
+// Add the -instrument counters to the kernels, the invokables and the regions
+// marked in them.
+void RSBackend::InstrumentExports(llvm::Module *M) {
+  RSInstrumentation Instrumentation;
+
+  for (RSContext::const_export_foreach_iterator
+          I = mContext->export_foreach_begin(),
+          E = mContext->export_foreach_end();
+       I != E;
+       I++) {
+    if (llvm::Function *F = M->getFunction((*I)->getName()))
+      Instrumentation.addKernel(F);
+  }
+
+  for (RSContext::const_export_func_iterator
+          I = mContext->export_funcs_begin(),
+          E = mContext->export_funcs_end();
+       I != E;
+       I++) {
+    if (llvm::Function *F = M->getFunction((*I)->getName()))
+      Instrumentation.addInvokable(F);
+  }
+
+  Instrumentation.instrument(M, mDiagEngine);
+  return;
+}
+
+// Annotate @M with the branch weights and inlining hints of the profile
+// given with -profile-use.
+void RSBackend::ApplyProfile(llvm::Module *M) {
+  std::vector<std::string> Mismatched;
+  mProfile->apply(M, Mismatched);
+
+  for (unsigned i = 0, e = Mismatched.size(); i != e; i++)
+    mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+        clang::DiagnosticsEngine::Warning,
+        "profile of '%0' does not match its code (was the profile taken with "
+        "another version of the script?); ignored"))
+        << Mismatched[i];
+
+  return;
+}
+
+// Classify the rsGetElementAt()/rsSetElementAt() calls in the (optimized)
+// kernel @F of @EFE, and warn about the ones that do not move through memory
+// along with x, the innermost dimension of the launch.
+RSAccessPattern RSBackend::AnalyzeAccessPattern(llvm::Function *F,
+                                                const RSExportForEach *EFE) {
+  // The kernel's parameters are (in, out, usrData, x, y), minus the ones it
+  // does not take
+  unsigned Encoding = EFE->getMetadataEncoding();
+  unsigned XIndex = 0;
+  for (unsigned Bit = RSExportForEach::ME_In; Bit < RSExportForEach::ME_X;
+       Bit <<= 1)
+    if (Encoding & Bit)
+      XIndex++;
+
+  llvm::Value *X = NULL;
+  llvm::Value *Y = NULL;
+  llvm::Function::arg_iterator AI = F->arg_begin();
+  for (unsigned i = 0; (i < XIndex) && (AI != F->arg_end()); i++)
+    AI++;
+  if ((Encoding & RSExportForEach::ME_X) && (AI != F->arg_end()))
+    X = AI++;
+  if ((Encoding & RSExportForEach::ME_Y) && (AI != F->arg_end()))
+    Y = AI;
+
+  RSAccessPattern Pattern = RSAccessPattern::Analyze(F, X, Y);
+
+  for (RSAccessPattern::const_access_iterator
+          I = Pattern.accesses_begin(),
+          E = Pattern.accesses_end();
+       I != E;
+       I++) {
+    if (I->C != RSAccessPattern::AP_Strided)
+      continue;
+
+    llvm::StringRef Name = GetRSBuiltinName(I->Call->getCalledFunction());
+    if (I->XStride != 0) {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "%0() in kernel '%1' moves %2 elements per x; consecutive x should "
+          "access consecutive elements"))
+          << Name << EFE->getName() << llvm::itostr(I->XStride);
+    } else {
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Warning,
+          "%0() in kernel '%1' walks the allocation in column-major order; "
+          "consecutive x should access consecutive elements"))
+          << Name << EFE->getName();
+    }
+  }
+
+  return Pattern;
+}
+
+// Record the call sites and loops of the exported kernels and invokables in
+// the unoptimized module, for EmitOptRemarks().
+void RSBackend::RecordOptRemarks(llvm::Module *M) {
+  for (RSContext::const_export_foreach_iterator
+          I = mContext->export_foreach_begin(),
+          E = mContext->export_foreach_end();
+       I != E;
+       I++) {
+    if (llvm::Function *F = M->getFunction((*I)->getName()))
+      mOptRemarks.recordUnoptimized(F, true);
+  }
+
+  for (RSContext::const_export_func_iterator
+          I = mContext->export_funcs_begin(),
+          E = mContext->export_funcs_end();
+       I != E;
+       I++) {
+    if (llvm::Function *F = M->getFunction((*I)->getName()))
+      mOptRemarks.recordUnoptimized(F, false);
+  }
+
+  return;
+}
+
+// Report what the optimizer did to the recorded call sites and loops, then
+// strip the debug info that was only generated for locating them.
+void RSBackend::EmitOptRemarks(llvm::Module *M) {
+  mOptRemarks.resolve(M);
+
+  // Keep the remarks ahead of the messages printed through std::cout
+  if (mPrintOptRemarks) {
+    mOptRemarks.print(llvm::outs());
+    llvm::outs().flush();
+  }
+
+  if (!mOptRemarksFile.empty()) {
+    std::string ErrorInfo;
+    llvm::raw_fd_ostream OS(mOptRemarksFile.c_str(), ErrorInfo,
+                            llvm::raw_fd_ostream::F_Append);
+    if (ErrorInfo.empty())
+      mOptRemarks.printTable(OS);
+    else
+      mDiagEngine.Report(mDiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Error,
+          "cannot write optimization remarks file '%0': %1"))
+          << mOptRemarksFile << ErrorInfo;
+  }
+
+  llvm::PassManager PM;
+  PM.add(llvm::createStripSymbolsPass(/* OnlyDebugInfo */ true));
+  PM.run(*M);
+  return;
+}
+
+void RSBackend::HandleTranslationUnitLateOpt(llvm::Module *M) {
+  if (mPrintOptRemarks || !mOptRemarksFile.empty())
+    EmitOptRemarks(M);
+
+  if (mProfile != NULL)
+    RSProfile::LayoutColdBlocks(M);
+
+  return;
+}
+
+// Analyze the kernels and invokables in their final form, so that the
+// runtime can pick a launch strategy for them.
+void RSBackend::HandleTranslationUnitPostOpt(llvm::Module *M) {
+  if (!mContext->hasExportForEach() && !mContext->hasExportFunc())
+    return;
+
+  // With -lto-only the code has only been cleaned up, and llvm-rs-link does
+  // the optimization the analyses below are meant to see. Recording them for
+  // the unoptimized code would mislead the runtime, so the script goes
+  // without (as one from an older llvm-rs-cc would).
+  if (mLTOOnly)
+    return;
+
+  RSSideEffects SideEffects(M);
+
+  if (mContext->hasExportFunc()) {
+    llvm::NamedMDNode *ExportFuncSideEffectsMetadata =
+        M->getOrInsertNamedMetadata(RS_EXPORT_FUNC_SIDE_EFFECTS_MN);
+
+    for (RSContext::const_export_func_iterator
+            I = mContext->export_funcs_begin(),
+            E = mContext->export_funcs_end();
+         I != E;
+         I++) {
+      llvm::Function *F = M->getFunction((*I)->getName());
+      slangAssert(F && "Function marked as exported disappeared in Bitcode");
+
+      ExportFuncSideEffectsMetadata->addOperand(
+          llvm::MDNode::get(mLLVMContext,
+                            llvm::MDString::get(mLLVMContext,
+                                llvm::utostr_32(SideEffects.get(F)))));
+    }
+  }
+
+  if (!mContext->hasExportForEach())
+    return;
+
+  llvm::NamedMDNode *ExportForEachCostMetadata =
+      M->getOrInsertNamedMetadata(RS_EXPORT_FOREACH_COST_MN);
+  llvm::NamedMDNode *ExportForEachSideEffectsMetadata =
+      M->getOrInsertNamedMetadata(RS_EXPORT_FOREACH_SIDE_EFFECTS_MN);
+  llvm::NamedMDNode *ExportForEachAccessMetadata =
+      M->getOrInsertNamedMetadata(RS_EXPORT_FOREACH_ACCESS_MN);
+
+  for (RSContext::const_export_foreach_iterator
+          I = mContext->export_foreach_begin(),
+          E = mContext->export_foreach_end();
+       I != E;
+       I++) {
+    const RSExportForEach *EFE = *I;
+    llvm::Function *F = M->getFunction(EFE->getName());
+    slangAssert(F && "Function marked as forEach disappeared in Bitcode");
+
+    RSKernelCost Cost;
+    if (!F->isDeclaration())
+      Cost = RSKernelCost::Estimate(F);
+
+    ExportForEachCostMetadata->addOperand(
+        llvm::MDNode::get(mLLVMContext,
+                          llvm::MDString::get(mLLVMContext,
+                                              Cost.getEncoding())));
+    ExportForEachSideEffectsMetadata->addOperand(
+        llvm::MDNode::get(mLLVMContext,
+                          llvm::MDString::get(mLLVMContext,
+                              llvm::utostr_32(SideEffects.get(F)))));
+
+    RSAccessPattern Access;
+    if (!F->isDeclaration())
+      Access = AnalyzeAccessPattern(F, EFE);
+    ExportForEachAccessMetadata->addOperand(
+        llvm::MDNode::get(mLLVMContext,
+                          llvm::MDString::get(mLLVMContext,
+                                              Access.getEncoding())));
+
+    if (mPrintKernelCost) {
+      llvm::raw_ostream &OS = llvm::outs();
+      OS << "Kernel " << EFE->getName() << ":";
+      for (unsigned i = 0; i < RSKernelCost::KC_NumClasses; i++) {
+        RSKernelCost::Class C = static_cast<RSKernelCost::Class>(i);
+        OS << " " << RSKernelCost::getClassName(C) << "=" << Cost.get(C);
+      }
+      // Ahead of the "Generating ..." lines, which go through std::cout
+      OS << "\n";
+      OS.flush();
+    }
+  }
+
   return;
 }
 
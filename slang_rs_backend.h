@@ -17,11 +17,23 @@
 #ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_BACKEND_H_  // NOLINT
 #define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_BACKEND_H_
 
+#include <vector>
+
+#include "clang/Basic/SourceLocation.h"
+
+#include "llvm/ADT/StringMap.h"
+
 #include "slang_backend.h"
 #include "slang_pragma_recorder.h"
+#include "slang_rs_access_pattern.h"
+#include "slang_rs_double_lint.h"
 #include "slang_rs_object_ref_count.h"
+#include "slang_rs_opt_remarks.h"
+#include "slang_rs_profile.h"
 
 namespace llvm {
+  class Function;
+  class Module;
   class NamedMDNode;
 }
 
@@ -38,6 +50,7 @@ namespace clang {
 namespace slang {
 
 class RSContext;
+class RSExportForEach;
 
 class RSBackend : public Backend {
  private:
@@ -46,10 +59,35 @@ class RSBackend : public Backend {
   clang::SourceManager &mSourceMgr;
 
   bool mAllowRSPrefix;
+  bool mPrintKernelCost;
+  bool mPrintCodeReport;
+  bool mWarnDouble;
+  bool mStripRSDebug;
+
+  // The calls to rsDebug() in each function the script defines, in the order
+  // Clang generates their code, for the notes of -strip-rsdebug
+  llvm::StringMap<std::vector<clang::SourceLocation> > mRSDebugCalls;
+
+  // -opt-remarks and -opt-remarks-file
+  bool mPrintOptRemarks;
+  std::string mOptRemarksFile;
+  RSOptRemarks mOptRemarks;
+
+  // The functions checked by -Wrs-double
+  RSDoubleLint mDoubleLint;
+
+  bool mInstrument;
+
+  // -profile-generate, and the profile to optimize for (if any)
+  bool mProfileGenerate;
+  const RSProfile *mProfile;
+
+  bool mLTOOnly;
 
   llvm::NamedMDNode *mExportVarMetadata;
   llvm::NamedMDNode *mExportFuncMetadata;
   llvm::NamedMDNode *mExportForEachMetadata;
+  llvm::NamedMDNode *mExportForEachNameMetadata;
   llvm::NamedMDNode *mExportTypeMetadata;
   llvm::NamedMDNode *mExportElementMetadata;
   llvm::NamedMDNode *mRSObjectSlotsMetadata;
@@ -58,17 +96,56 @@ class RSBackend : public Backend {
 
   void AnnotateFunction(clang::FunctionDecl *FD);
 
+  void CreateFusedKernel(llvm::Module *M, const RSExportForEach *EFE);
+
+  void CreateSpecializedKernel(llvm::Module *M, const RSExportForEach *EFE);
+
+  void AnnotateForEachParams(llvm::Module *M, const RSExportForEach *EFE);
+
+  void CheckUnusedExports(llvm::Module *M);
+
+  void StripRSDebugCalls(llvm::Module *M);
+
+  void InstrumentExports(llvm::Module *M);
+
+  void ApplyProfile(llvm::Module *M);
+
+  void RecordOptRemarks(llvm::Module *M);
+  void EmitOptRemarks(llvm::Module *M);
+
+  RSAccessPattern AnalyzeAccessPattern(llvm::Function *F,
+                                       const RSExportForEach *EFE);
+
  protected:
   virtual unsigned int getTargetAPI() const {
     return mContext->getTargetAPI();
   }
 
+  virtual FPPrecision getFPPrecision() const;
+
+  virtual bool getPrintCodeReport() const {
+    return mPrintCodeReport;
+  }
+
+  virtual bool getLTOOnly() const {
+    return mLTOOnly;
+  }
+
+  virtual void PopulateModulePasses(llvm::PassManagerBuilder &PMBuilder);
+
+  virtual bool GetExternalSymbols(llvm::Module *M,
+                                  std::vector<const char *> &Names);
+
   virtual void HandleTopLevelDecl(clang::DeclGroupRef D);
 
   virtual void HandleTranslationUnitPre(clang::ASTContext &C);
 
   virtual void HandleTranslationUnitPost(llvm::Module *M);
 
+  virtual void HandleTranslationUnitLateOpt(llvm::Module *M);
+
+  virtual void HandleTranslationUnitPostOpt(llvm::Module *M);
+
  public:
   RSBackend(RSContext *Context,
             clang::DiagnosticsEngine *DiagEngine,
@@ -78,7 +155,17 @@ class RSBackend : public Backend {
             llvm::raw_ostream *OS,
             Slang::OutputType OT,
             clang::SourceManager &SourceMgr,
-            bool AllowRSPrefix);
+            bool AllowRSPrefix,
+            bool PrintKernelCost,
+            bool PrintCodeReport,
+            bool StripRSDebug,
+            bool PrintOptRemarks,
+            const std::string &OptRemarksFile,
+            bool WarnDouble,
+            bool ProfileGenerate,
+            const RSProfile *Profile,
+            bool Instrument,
+            bool LTOOnly);
 
   virtual ~RSBackend();
 };
@@ -16,6 +16,8 @@
 
 #include "slang_rs_context.h"
 
+#include <cfloat>
+#include <cstdlib>
 #include <string>
 
 #include "clang/AST/ASTContext.h"
@@ -29,6 +31,8 @@
 
 #include "clang/Index/ASTLocation.h"
 
+#include "llvm/ADT/StringExtras.h"
+
 #include "llvm/LLVMContext.h"
 
 #include "llvm/Target/TargetData.h"
@@ -42,6 +46,7 @@
 #include "slang_rs_exportable.h"
 #include "slang_rs_pragma_handler.h"
 #include "slang_rs_reflection.h"
+#include "slang_version.h"
 
 namespace slang {
 
@@ -59,6 +64,10 @@ RSContext::RSContext(clang::Preprocessor &PP,
       mGeneratedFileNames(GeneratedFileNames),
       mTargetData(NULL),
       mLLVMContext(llvm::getGlobalContext()),
+      mFPRelaxed(false),
+      mFPImprecise(false),
+      mJavaUsage(NULL),
+      mStripUnusedExports(false),
       mLicenseNote(NULL),
       version(0),
       mMangleCtx(Ctx.createMangleContext()) {
@@ -76,6 +85,32 @@ RSContext::RSContext(clang::Preprocessor &PP,
   PP.AddPragmaHandler(
       "rs", RSPragmaHandler::CreatePragmaReflectLicenseHandler(this));
 
+  // For #pragma rs fuse
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaFuseHandler(this));
+
+  // For #pragma rs inplace
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaInPlaceHandler(this));
+
+  // For #pragma rs fp_relaxed and #pragma rs fp_imprecise
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaFPRelaxedHandler(this));
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaFPImpreciseHandler(this));
+
+  // For #pragma rs unroll, #pragma rs nounroll and #pragma rs vectorize
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaUnrollHandler(this));
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaNoUnrollHandler(this));
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaVectorizeHandler(this));
+
+  // For #pragma rs specialize
+  PP.AddPragmaHandler(
+      "rs", RSPragmaHandler::CreatePragmaSpecializeHandler(this));
+
   // For #pragma version
   PP.AddPragmaHandler(RSPragmaHandler::CreatePragmaVersionHandler(this));
 
@@ -130,6 +165,10 @@ bool RSContext::processExportFunc(const clang::FunctionDecl *FD) {
       return false;
     }
     return true;
+  } else if (isFusedKernel(FD->getName())) {
+    // Kernels named in #pragma rs fuse are validated (and exported) as part
+    // of the fused kernel rather than as invokable functions.
+    return true;
   }
 
   RSExportFunc *EF = RSExportFunc::Create(this, FD);
@@ -186,6 +225,283 @@ bool RSContext::processExportType(const llvm::StringRef &Name) {
   return (ET != NULL);
 }
 
+const clang::FunctionDecl *
+RSContext::lookupFunctionDefinition(const llvm::StringRef &Name) {
+  clang::TranslationUnitDecl *TUDecl = mCtx.getTranslationUnitDecl();
+  const clang::IdentifierInfo *II = mPP.getIdentifierInfo(Name);
+  if (II == NULL)
+    return NULL;
+
+  clang::DeclContext::lookup_const_result R = TUDecl->lookup(II);
+  for (clang::DeclContext::lookup_const_iterator I = R.first, E = R.second;
+       I != E;
+       I++) {
+    const clang::FunctionDecl *FD = llvm::dyn_cast<clang::FunctionDecl>(*I);
+    const clang::FunctionDecl *Def = NULL;
+    if (FD && FD->hasBody(Def))
+      return Def;
+  }
+
+  return NULL;
+}
+
+bool RSContext::processFusedKernels(const std::string &First,
+                                    const std::string &Second) {
+  clang::DiagnosticsEngine *DiagEngine = getDiagnostics();
+  const clang::FunctionDecl *FDs[2] = { lookupFunctionDefinition(First),
+                                        lookupFunctionDefinition(Second) };
+  const std::string *Names[2] = { &First, &Second };
+  bool valid = true;
+
+  for (int i = 0; i < 2; i++) {
+    if (FDs[i] == NULL) {
+      DiagEngine->Report(
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "kernel '%0' named in #pragma rs fuse "
+                                    "is not defined"))
+        << *Names[i];
+      valid = false;
+    } else if (FDs[i]->getStorageClass() != clang::SC_None) {
+      DiagEngine->Report(
+        clang::FullSourceLoc(FDs[i]->getLocation(), *getSourceManager()),
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "kernel '%0' named in #pragma rs fuse "
+                                    "cannot be extern or static"))
+        << *Names[i];
+      valid = false;
+    }
+  }
+
+  if (!valid)
+    return false;
+
+  RSExportForEach *EFE = RSExportForEach::CreateFused(this, FDs[0], FDs[1]);
+  if (EFE == NULL)
+    return false;
+
+  mExportForEach.push_back(EFE);
+  return true;
+}
+
+namespace {
+
+// Get the width and signedness of the integer type @DT. Return false if @DT
+// is not an integer type.
+static bool GetIntegerRange(RSExportPrimitiveType::DataType DT,
+                            unsigned &Bits,
+                            bool &Signed) {
+  Signed = false;
+  switch (DT) {
+    case RSExportPrimitiveType::DataTypeSigned8:
+      Signed = true;
+      // Fall through
+    case RSExportPrimitiveType::DataTypeUnsigned8:
+      Bits = 8;
+      return true;
+    case RSExportPrimitiveType::DataTypeSigned16:
+      Signed = true;
+      // Fall through
+    case RSExportPrimitiveType::DataTypeUnsigned16:
+      Bits = 16;
+      return true;
+    case RSExportPrimitiveType::DataTypeSigned32:
+      Signed = true;
+      // Fall through
+    case RSExportPrimitiveType::DataTypeUnsigned32:
+      Bits = 32;
+      return true;
+    case RSExportPrimitiveType::DataTypeSigned64:
+      Signed = true;
+      // Fall through
+    case RSExportPrimitiveType::DataTypeUnsigned64:
+      Bits = 64;
+      return true;
+    case RSExportPrimitiveType::DataTypeBoolean:
+      Bits = 1;
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool RSContext::processSpecializations() {
+  if (mPragmaSpecializations.empty() && mOptionSpecializations.empty()) {
+    return true;
+  }
+
+  clang::DiagnosticsEngine *DiagEngine = getDiagnostics();
+  bool valid = true;
+
+  // Each specialized kernel takes a forEach slot of its own, and older
+  // runtimes only launch slot 0 (root)
+  if (getTargetAPI() < SLANG_ICS_TARGET_API) {
+    DiagEngine->Report(
+      DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                  "kernel specialization requires target "
+                                  "API %0 or above"))
+        << SLANG_ICS_TARGET_API;
+    return false;
+  }
+
+  // Later requests for the same variable win, and -specialize overrides
+  // #pragma rs specialize
+  mSpecializations.clear();
+  const SpecializationList *Requests[2] = { &mPragmaSpecializations,
+                                            &mOptionSpecializations };
+  for (int i = 0; i < 2; i++) {
+    for (SpecializationList::const_iterator RI = Requests[i]->begin(),
+             RE = Requests[i]->end();
+         RI != RE;
+         RI++) {
+      SpecializationList::iterator SI = mSpecializations.begin(),
+          SE = mSpecializations.end();
+      while ((SI != SE) && (SI->first != RI->first)) {
+        SI++;
+      }
+      if (SI == SE) {
+        mSpecializations.push_back(*RI);
+      } else {
+        SI->second = RI->second;
+      }
+    }
+  }
+
+  for (SpecializationList::iterator SI = mSpecializations.begin(),
+           SE = mSpecializations.end();
+       SI != SE;
+       SI++) {
+    const RSExportVar *EV = NULL;
+    for (ExportVarList::const_iterator VI = mExportVars.begin(),
+             VE = mExportVars.end();
+         VI != VE && EV == NULL;
+         VI++) {
+      if ((*VI)->getName() == SI->first) {
+        EV = *VI;
+      }
+    }
+
+    if (EV == NULL) {
+      DiagEngine->Report(
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "cannot specialize '%0', which is not an "
+                                    "exported global variable"))
+        << SI->first;
+      valid = false;
+      continue;
+    }
+
+    if (EV->isFoldedConst()) {
+      DiagEngine->Report(
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "cannot specialize '%0', which is a "
+                                    "constant"))
+        << SI->first;
+      valid = false;
+      continue;
+    }
+
+    const RSExportType *ET = EV->getType();
+    if ((ET->getClass() != RSExportType::ExportClassPrimitive) ||
+        static_cast<const RSExportPrimitiveType*>(ET)->isRSObjectType()) {
+      DiagEngine->Report(
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "cannot specialize '%0' of non-primitive "
+                                    "type '%1'"))
+        << SI->first << ET->getName();
+      valid = false;
+      continue;
+    }
+
+    // Normalize the value to what the backend expects for the type
+    RSExportPrimitiveType::DataType DT =
+        static_cast<const RSExportPrimitiveType*>(ET)->getType();
+    std::string Value(SI->second);
+    bool ValidValue;
+    bool InRange = true;
+    unsigned Bits;
+    bool Signed;
+    if ((DT == RSExportPrimitiveType::DataTypeFloat32) ||
+        (DT == RSExportPrimitiveType::DataTypeFloat64)) {
+      const char *Begin = Value.c_str();
+      char *End;
+      double Float = strtod(Begin, &End);
+      ValidValue = (End != Begin) && (*End == '\0');
+      // strtod() overflows to infinity
+      double Max = (DT == RSExportPrimitiveType::DataTypeFloat32) ?
+                   FLT_MAX : DBL_MAX;
+      InRange = (Float >= -Max) && (Float <= Max);
+    } else if (!GetIntegerRange(DT, Bits, Signed)) {
+      ValidValue = false;
+    } else if ((Value == "true") || (Value == "false")) {
+      ValidValue = (DT == RSExportPrimitiveType::DataTypeBoolean);
+      SI->second = (Value == "true") ? "1" : "0";
+    } else if (Signed) {
+      long long Int;
+      ValidValue = !llvm::StringRef(Value).getAsInteger(0, Int);
+      if (ValidValue) {
+        if (Bits < 64) {
+          long long Limit = 1LL << (Bits - 1);
+          InRange = (Int >= -Limit) && (Int < Limit);
+        }
+        SI->second = llvm::itostr(Int);
+      }
+    } else {
+      // Negative values do not parse as unsigned, and are reported as
+      // invalid
+      unsigned long long Int;
+      ValidValue = !llvm::StringRef(Value).getAsInteger(0, Int);
+      if (ValidValue) {
+        if (Bits < 64)
+          InRange = ((Int >> Bits) == 0);
+        SI->second = llvm::utostr(Int);
+      }
+    }
+
+    if (!ValidValue) {
+      DiagEngine->Report(
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "invalid value '%0' for specialized "
+                                    "variable '%1' of type '%2'"))
+        << Value << SI->first << ET->getName();
+      valid = false;
+    } else if (!InRange) {
+      DiagEngine->Report(
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "value '%0' is out of range for "
+                                    "specialized variable '%1' of type '%2'"))
+        << Value << SI->first << ET->getName();
+      valid = false;
+    }
+  }
+
+  if (!valid) {
+    return false;
+  }
+
+  if (mExportForEach.empty()) {
+    DiagEngine->Report(
+      DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Warning,
+                                  "specialization has no effect, since the "
+                                  "script has no forEach kernels"));
+    return true;
+  }
+
+  // Add a specialized variant of each kernel, keeping the generic ones as a
+  // fallback
+  ExportForEachList Specialized;
+  for (ExportForEachList::const_iterator FI = mExportForEach.begin(),
+           FE = mExportForEach.end();
+       FI != FE;
+       FI++) {
+    Specialized.push_back(RSExportForEach::CreateSpecialized(this, *FI));
+  }
+  mExportForEach.splice(mExportForEach.end(), Specialized);
+
+  return true;
+}
+
 bool RSContext::processExport() {
   bool valid = true;
 
@@ -217,6 +533,42 @@ bool RSContext::processExport() {
     }
   }
 
+  // Export the kernels requested by #pragma rs fuse
+  for (FusedKernelList::const_iterator FI = mFusedKernels.begin(),
+           FE = mFusedKernels.end();
+       FI != FE;
+       FI++) {
+    if (!processFusedKernels(FI->first, FI->second)) {
+      valid = false;
+    }
+  }
+
+  // Add the variants requested by #pragma rs specialize and -specialize
+  if (valid && !processSpecializations()) {
+    valid = false;
+  }
+
+  // Warn about in-place declarations that do not name a forEach kernel
+  for (llvm::StringSet<>::const_iterator II = mInPlaceKernels.begin(),
+           IE = mInPlaceKernels.end();
+       II != IE;
+       II++) {
+    bool Found = false;
+    for (ExportForEachList::const_iterator FI = mExportForEach.begin(),
+             FE = mExportForEach.end();
+         FI != FE && !Found;
+         FI++) {
+      Found = ((*FI)->getName() == II->getKey());
+    }
+    if (!Found) {
+      getDiagnostics()->Report(
+        getDiagnostics()->getCustomDiagID(clang::DiagnosticsEngine::Warning,
+                                          "#pragma rs inplace names '%0', "
+                                          "which is not a forEach kernel"))
+        << II->getKey();
+    }
+  }
+
   // Finally, export type forcely set to be exported by user
   for (NeedExportTypeSet::const_iterator EI = mNeedExportTypes.begin(),
            EE = mNeedExportTypes.end();
@@ -277,6 +629,16 @@ bool RSContext::reflectToJava(const std::string &OutputPathBase,
   return ret;
 }
 
+void RSContext::removeExportVar(const RSExportVar *EV) {
+  mExportVars.remove(const_cast<RSExportVar*>(EV));
+  return;
+}
+
+void RSContext::removeExportFunc(const RSExportFunc *EF) {
+  mExportFuncs.remove(const_cast<RSExportFunc*>(EF));
+  return;
+}
+
 RSContext::~RSContext() {
   delete mLicenseNote;
   delete mTargetData;
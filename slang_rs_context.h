@@ -30,6 +30,7 @@
 #include "llvm/ADT/StringMap.h"
 
 #include "slang_pragma_recorder.h"
+#include "slang_rs_loop_hints.h"
 
 namespace llvm {
   class LLVMContext;
@@ -62,6 +63,8 @@ class RSContext {
   typedef std::list<RSExportFunc*> ExportFuncList;
   typedef std::list<RSExportForEach*> ExportForEachList;
   typedef llvm::StringMap<RSExportType*> ExportTypeMap;
+  typedef std::list<std::pair<std::string, std::string> > FusedKernelList;
+  typedef std::list<std::pair<std::string, std::string> > SpecializationList;
 
  private:
   clang::Preprocessor &mPP;
@@ -78,6 +81,32 @@ class RSContext {
 
   NeedExportTypeSet mNeedExportTypes;
 
+  // Kernel pairs requested by #pragma rs fuse(first, second)
+  FusedKernelList mFusedKernels;
+  llvm::StringSet<> mFusedKernelNames;
+
+  // Kernels declared by #pragma rs inplace(kernel), whose in and out may
+  // refer to the same allocation
+  llvm::StringSet<> mInPlaceKernels;
+
+  // Set by #pragma rs fp_relaxed / fp_imprecise
+  bool mFPRelaxed;
+  bool mFPImprecise;
+
+  // Set by #pragma rs unroll(N) / nounroll / vectorize
+  RSLoopHints mLoopHints;
+
+  // Global values requested by #pragma rs specialize(var = value, ...) and
+  // by -specialize (which takes precedence), and the validated result
+  SpecializationList mPragmaSpecializations;
+  SpecializationList mOptionSpecializations;
+  SpecializationList mSpecializations;
+
+  // Names of the reflected Java members the app uses (given by
+  // -java-usage-file), or NULL if unknown
+  const llvm::StringSet<> *mJavaUsage;
+  bool mStripUnusedExports;
+
   std::string *mLicenseNote;
   std::string mReflectJavaPackageName;
   std::string mReflectJavaPathName;
@@ -88,6 +117,11 @@ class RSContext {
   bool processExportVar(const clang::VarDecl *VD);
   bool processExportFunc(const clang::FunctionDecl *FD);
   bool processExportType(const llvm::StringRef &Name);
+  bool processFusedKernels(const std::string &First,
+                           const std::string &Second);
+  bool processSpecializations();
+  const clang::FunctionDecl *lookupFunctionDefinition(
+      const llvm::StringRef &Name);
 
   ExportVarList mExportVars;
   ExportFuncList mExportFuncs;
@@ -129,6 +163,80 @@ class RSContext {
     return;
   }
 
+  inline void addFusedKernels(const std::string &First,
+                              const std::string &Second) {
+    mFusedKernels.push_back(make_pair(First, Second));
+    mFusedKernelNames.insert(First);
+    mFusedKernelNames.insert(Second);
+    return;
+  }
+  inline bool isFusedKernel(const llvm::StringRef &Name) const {
+    return mFusedKernelNames.count(Name);
+  }
+
+  inline void addInPlaceKernel(const std::string &Name) {
+    mInPlaceKernels.insert(Name);
+    return;
+  }
+  inline bool isInPlaceKernel(const llvm::StringRef &Name) const {
+    return mInPlaceKernels.count(Name);
+  }
+
+  // fp_imprecise implies fp_relaxed
+  inline void setFPRelaxed() {
+    mFPRelaxed = true;
+    return;
+  }
+  inline void setFPImprecise() {
+    mFPRelaxed = true;
+    mFPImprecise = true;
+    return;
+  }
+  inline bool isFPRelaxed() const { return mFPRelaxed; }
+  inline bool isFPImprecise() const { return mFPImprecise; }
+
+  inline RSLoopHints &getLoopHints() { return mLoopHints; }
+
+  inline void addPragmaSpecialization(const std::string &Name,
+                                      const std::string &Value) {
+    mPragmaSpecializations.push_back(make_pair(Name, Value));
+    return;
+  }
+  inline void addOptionSpecialization(const std::string &Name,
+                                      const std::string &Value) {
+    mOptionSpecializations.push_back(make_pair(Name, Value));
+    return;
+  }
+
+  // The (variable, value) pairs the specialized kernels are compiled for,
+  // valid after processExport()
+  typedef SpecializationList::const_iterator const_specialization_iterator;
+  const_specialization_iterator specializations_begin() const {
+    return mSpecializations.begin();
+  }
+  const_specialization_iterator specializations_end() const {
+    return mSpecializations.end();
+  }
+  inline bool hasSpecializations() const { return !mSpecializations.empty(); }
+
+  inline void setJavaUsage(const llvm::StringSet<> *JavaUsage,
+                           bool StripUnusedExports) {
+    mJavaUsage = JavaUsage;
+    mStripUnusedExports = StripUnusedExports;
+    return;
+  }
+  inline bool hasJavaUsage() const { return (mJavaUsage != NULL); }
+  // Whether the app uses the reflected Java member @Name (e.g. "invoke_foo")
+  inline bool isUsedFromJava(const llvm::StringRef &Name) const {
+    return mJavaUsage->count(Name);
+  }
+  inline bool shouldStripUnusedExports() const { return mStripUnusedExports; }
+
+  // Stop exporting @EV / @EF, which is unused. Must be called before the
+  // export metadata and reflection are generated.
+  void removeExportVar(const RSExportVar *EV);
+  void removeExportFunc(const RSExportFunc *EF);
+
   inline void setReflectJavaPackageName(const std::string &S) {
     mReflectJavaPackageName = S;
     return;
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_double_lint.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/Stmt.h"
+#include "clang/AST/StmtVisitor.h"
+#include "clang/AST/Type.h"
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceManager.h"
+
+#include "clang/Lex/Lexer.h"
+
+#include "slang_rs_export_foreach.h"
+
+namespace slang {
+
+namespace {
+
+static bool IsDouble(clang::QualType T) {
+  return T->isSpecificBuiltinType(clang::BuiltinType::Double);
+}
+
+static bool IsFloat(clang::QualType T) {
+  return T->isSpecificBuiltinType(clang::BuiltinType::Float);
+}
+
+// Return the unsuffixed (double) floating-point constant @E is, possibly
+// negated, or NULL.
+static const clang::FloatingLiteral *GetDoubleLiteral(const clang::Expr *E) {
+  E = E->IgnoreParens();
+  if (const clang::UnaryOperator *UO =
+          llvm::dyn_cast<clang::UnaryOperator>(E)) {
+    if ((UO->getOpcode() == clang::UO_Minus) ||
+        (UO->getOpcode() == clang::UO_Plus))
+      E = UO->getSubExpr()->IgnoreParens();
+  }
+
+  const clang::FloatingLiteral *FL = llvm::dyn_cast<clang::FloatingLiteral>(E);
+  if ((FL != NULL) && IsDouble(FL->getType()))
+    return FL;
+  return NULL;
+}
+
+// Whether @E is a float promoted to double
+static bool IsFloatPromotion(const clang::Expr *E) {
+  const clang::ImplicitCastExpr *ICE =
+      llvm::dyn_cast<clang::ImplicitCastExpr>(E->IgnoreParens());
+  return (ICE != NULL) &&
+         (ICE->getCastKind() == clang::CK_FloatingCast) &&
+         IsDouble(ICE->getType()) &&
+         IsFloat(ICE->getSubExpr()->getType());
+}
+
+// Whether the double precision of @E comes from its subexpressions, which are
+// checked on their own
+static bool IsCompoundExpr(const clang::Expr *E) {
+  E = E->IgnoreParenImpCasts();
+  return llvm::isa<clang::BinaryOperator>(E) ||
+         llvm::isa<clang::ConditionalOperator>(E) ||
+         llvm::isa<clang::CallExpr>(E);
+}
+
+// Whether @E is double because the script says so (e.g. a double variable),
+// rather than because of a constant or a conversion
+static bool IsExplicitDouble(const clang::ASTContext &Ctx,
+                             const clang::Expr *E) {
+  E = E->IgnoreParens();
+  while (const clang::ImplicitCastExpr *ICE =
+             llvm::dyn_cast<clang::ImplicitCastExpr>(E)) {
+    if (ICE->getCastKind() != clang::CK_LValueToRValue)
+      return false;  // A conversion to double
+    E = ICE->getSubExpr()->IgnoreParens();
+  }
+  return IsDouble(E->getType()) &&
+         !IsCompoundExpr(E) && !E->isEvaluatable(Ctx);
+}
+
+class DoubleLintVisitor : public clang::StmtVisitor<DoubleLintVisitor> {
+ private:
+  clang::ASTContext &mCtx;
+  clang::SourceManager &mSM;
+  clang::DiagnosticsEngine &mDiagEngine;
+  // Canonical declaration => definition, for the functions in the script
+  const std::map<const clang::FunctionDecl*,
+                 const clang::FunctionDecl*> &mDefinitions;
+  // The functions defined in the script that the visited code calls
+  std::vector<const clang::FunctionDecl*> &mCallees;
+
+  unsigned mDiagConstant;
+  unsigned mDiagPromotion;
+  unsigned mDiagCall;
+
+  clang::SourceLocation getEndOfToken(clang::SourceLocation Loc) {
+    return clang::Lexer::getLocForEndOfToken(Loc, 0, mSM,
+                                             mCtx.getLangOptions());
+  }
+
+  bool canFix(const clang::Expr *E) {
+    return E->getLocStart().isFileID() && E->getLocEnd().isFileID();
+  }
+
+  // Append the 'f' suffix to @FL
+  void addSuffix(clang::DiagnosticBuilder &DB,
+                 const clang::FloatingLiteral *FL) {
+    if (!FL->getLocation().isFileID())
+      return;
+    DB << clang::FixItHint::CreateInsertion(getEndOfToken(FL->getLocation()),
+                                            "f");
+    return;
+  }
+
+  // Wrap @E in a conversion to float
+  void addCastToFloat(clang::DiagnosticBuilder &DB, const clang::Expr *E) {
+    if (!canFix(E))
+      return;
+    DB << clang::FixItHint::CreateInsertion(E->getLocStart(), "(float)(")
+       << clang::FixItHint::CreateInsertion(getEndOfToken(E->getLocEnd()),
+                                            ")");
+    return;
+  }
+
+  // Report @Op, an operand of double-precision arithmetic, if it is what made
+  // the arithmetic double precision. Return true if reported.
+  bool checkConstantOperand(const clang::Expr *Op) {
+    if (const clang::FloatingLiteral *FL = GetDoubleLiteral(Op)) {
+      clang::DiagnosticBuilder DB =
+          mDiagEngine.Report(clang::FullSourceLoc(FL->getLocation(), mSM),
+                             mDiagConstant);
+      DB << FL->getSourceRange();
+      addSuffix(DB, FL);
+      return true;
+    }
+
+    if (IsDouble(Op->getType()) && !IsFloatPromotion(Op) &&
+        Op->isEvaluatable(mCtx)) {
+      // E.g. (1.0 / 3.0)
+      clang::DiagnosticBuilder DB =
+          mDiagEngine.Report(clang::FullSourceLoc(Op->getExprLoc(), mSM),
+                             mDiagConstant);
+      DB << Op->getSourceRange();
+      addCastToFloat(DB, Op);
+      return true;
+    }
+
+    return false;
+  }
+
+ public:
+  DoubleLintVisitor(clang::ASTContext &Ctx,
+                    clang::DiagnosticsEngine &DiagEngine,
+                    const std::map<const clang::FunctionDecl*,
+                                   const clang::FunctionDecl*> &Definitions,
+                    std::vector<const clang::FunctionDecl*> &Callees)
+      : mCtx(Ctx),
+        mSM(Ctx.getSourceManager()),
+        mDiagEngine(DiagEngine),
+        mDefinitions(Definitions),
+        mCallees(Callees) {
+    mDiagConstant = mDiagEngine.getCustomDiagID(
+        clang::DiagnosticsEngine::Warning,
+        "double-precision constant makes this arithmetic double precision "
+        "[-Wrs-double]");
+    mDiagPromotion = mDiagEngine.getCustomDiagID(
+        clang::DiagnosticsEngine::Warning,
+        "float is promoted to double for this arithmetic [-Wrs-double]");
+    mDiagCall = mDiagEngine.getCustomDiagID(
+        clang::DiagnosticsEngine::Warning,
+        "call to double-precision function '%0' [-Wrs-double]");
+    return;
+  }
+
+  void VisitStmt(clang::Stmt *S) {
+    for (clang::Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+         I != E;
+         I++) {
+      if (clang::Stmt *Child = *I)
+        Visit(Child);
+    }
+    return;
+  }
+
+  void VisitBinaryOperator(clang::BinaryOperator *BO) {
+    VisitStmt(BO);
+
+    if (!BO->isMultiplicativeOp() && !BO->isAdditiveOp() &&
+        !BO->isComparisonOp() && !BO->isCompoundAssignmentOp())
+      return;
+
+    const clang::Expr *LHS = BO->getLHS();
+    const clang::Expr *RHS = BO->getRHS();
+    bool LHSPromoted;
+
+    if (clang::CompoundAssignOperator *CAO =
+            llvm::dyn_cast<clang::CompoundAssignOperator>(BO)) {
+      // The left operand of x *= ... is converted without a cast node. A
+      // double on the left means the script asked for double arithmetic.
+      if (!IsDouble(CAO->getComputationLHSType()) ||
+          IsDouble(LHS->getType()))
+        return;
+      LHSPromoted = IsFloat(LHS->getType());
+    } else {
+      if (!IsDouble(LHS->getType()) || BO->isEvaluatable(mCtx))
+        return;
+      LHSPromoted = IsFloatPromotion(LHS);
+    }
+
+    // A constant only matters if it is what makes the arithmetic double
+    // precision (unlike in d * 2.0 with d a double)
+    bool Reported = false;
+    if (!IsExplicitDouble(mCtx, RHS))
+      Reported |= checkConstantOperand(LHS);
+    if (!IsExplicitDouble(mCtx, LHS))
+      Reported |= checkConstantOperand(RHS);
+    if (Reported)
+      return;
+
+    // A float operand meets a double one
+    const clang::Expr *Promoted = NULL;
+    const clang::Expr *Other = NULL;
+    if (LHSPromoted) {
+      Promoted = LHS;
+      Other = RHS;
+    } else if (IsFloatPromotion(RHS)) {
+      Promoted = RHS;
+      Other = LHS;
+    }
+    if ((Promoted == NULL) || IsFloatPromotion(Other) ||
+        IsCompoundExpr(Other))
+      return;
+
+    clang::DiagnosticBuilder DB =
+        mDiagEngine.Report(clang::FullSourceLoc(Promoted->getExprLoc(), mSM),
+                           mDiagPromotion);
+    DB << Promoted->getSourceRange() << Other->getSourceRange();
+    addCastToFloat(DB, Other);
+    return;
+  }
+
+  void VisitCallExpr(clang::CallExpr *CE) {
+    VisitStmt(CE);
+
+    const clang::FunctionDecl *FD = CE->getDirectCallee();
+    if (FD == NULL)
+      return;
+
+    std::map<const clang::FunctionDecl*,
+             const clang::FunctionDecl*>::const_iterator I =
+        mDefinitions.find(FD->getCanonicalDecl());
+    if (I != mDefinitions.end()) {
+      mCallees.push_back(I->second);
+      return;
+    }
+
+    // A math function from the headers or the C library, called with double
+    // arguments so that overload resolution picked the double version
+    bool UsesDouble = IsDouble(FD->getResultType());
+    for (unsigned i = 0, e = FD->getNumParams(); i != e; i++)
+      UsesDouble |= IsDouble(FD->getParamDecl(i)->getType());
+    if (!UsesDouble)
+      return;
+
+    clang::DiagnosticBuilder DB =
+        mDiagEngine.Report(clang::FullSourceLoc(CE->getExprLoc(), mSM),
+                           mDiagCall);
+    DB << FD->getName() << CE->getSourceRange();
+    for (unsigned i = 0, e = CE->getNumArgs(); i != e; i++) {
+      const clang::Expr *Arg = CE->getArg(i);
+      if (!IsDouble(Arg->getType()) || IsFloatPromotion(Arg))
+        continue;
+      if (const clang::FloatingLiteral *FL = GetDoubleLiteral(Arg))
+        addSuffix(DB, FL);
+      else if (!IsCompoundExpr(Arg) || Arg->isEvaluatable(mCtx))
+        addCastToFloat(DB, Arg);
+    }
+    return;
+  }
+};
+
+}  // namespace
+
+void RSDoubleLint::addFunction(const clang::FunctionDecl *FD) {
+  mFunctions.push_back(FD);
+  return;
+}
+
+void RSDoubleLint::check(clang::ASTContext &C,
+                         clang::DiagnosticsEngine &DiagEngine) {
+  std::map<const clang::FunctionDecl*, const clang::FunctionDecl*> Definitions;
+  for (unsigned i = 0, e = mFunctions.size(); i != e; i++)
+    Definitions[mFunctions[i]->getCanonicalDecl()] = mFunctions[i];
+
+  // Start from the exported functions (kernels and invokables), and visit
+  // what they call
+  std::vector<const clang::FunctionDecl*> Worklist;
+  for (unsigned i = 0, e = mFunctions.size(); i != e; i++) {
+    const clang::FunctionDecl *FD = mFunctions[i];
+    if ((FD->getStorageClass() == clang::SC_None) &&
+        !RSExportForEach::isInitRSFunc(FD) &&
+        !RSExportForEach::isDtorRSFunc(FD))
+      Worklist.push_back(FD);
+  }
+
+  std::set<const clang::FunctionDecl*> Visited;
+  for (unsigned i = 0; i < Worklist.size(); i++) {
+    const clang::FunctionDecl *FD = Worklist[i];
+    if (!Visited.insert(FD).second)
+      continue;
+
+    std::vector<const clang::FunctionDecl*> Callees;
+    DoubleLintVisitor(C, DiagEngine, Definitions, Callees)
+        .Visit(FD->getBody());
+    Worklist.insert(Worklist.end(), Callees.begin(), Callees.end());
+  }
+
+  return;
+}
+
+}  // namespace slang
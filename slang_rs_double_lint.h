@@ -0,0 +1,58 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_DOUBLE_LINT_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_DOUBLE_LINT_H_
+
+#include <vector>
+
+namespace clang {
+  class ASTContext;
+  class DiagnosticsEngine;
+  class FunctionDecl;
+}  // namespace clang
+
+namespace slang {
+
+// Lint for arithmetic that is done in double precision without the script
+// asking for it (-Wrs-double): unsuffixed floating-point constants (1.0
+// rather than 1.0f), floats promoted to double to meet such a constant or a
+// double variable, and calls to the double-precision variants of the math
+// functions. Only the functions reachable from the exported kernels and
+// invokables are checked, and each warning carries a fix-it that keeps the
+// computation in single precision.
+class RSDoubleLint {
+ private:
+  // The functions defined in the script, in source order
+  std::vector<const clang::FunctionDecl*> mFunctions;
+
+ public:
+  RSDoubleLint() {
+    return;
+  }
+
+  // Record the definition @FD. Must be given every function the script
+  // defines (i.e., not the ones from the RS headers).
+  void addFunction(const clang::FunctionDecl *FD);
+
+  // Report the double-precision arithmetic in the functions reachable from
+  // the exported ones.
+  void check(clang::ASTContext &C, clang::DiagnosticsEngine &DiagEngine);
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_DOUBLE_LINT_H_  NOLINT
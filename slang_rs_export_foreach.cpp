@@ -20,9 +20,11 @@
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/StmtVisitor.h"
 #include "clang/AST/TypeLoc.h"
 
 #include "llvm/DerivedTypes.h"
+#include "llvm/ADT/APSInt.h"
 #include "llvm/Target/TargetData.h"
 
 #include "slang_assert.h"
@@ -48,6 +50,68 @@ static void ReportNameError(clang::DiagnosticsEngine *DiagEngine,
   return;
 }
 
+// Count the references to a kernel's input parameter that do not access the
+// element the kernel was invoked on (i.e. anything other than *in, in[0] or
+// in->field).
+class ForeignElementCounter
+    : public clang::StmtVisitor<ForeignElementCounter> {
+ private:
+  clang::ASTContext &mCtx;
+  const clang::ParmVarDecl *mPVD;
+  unsigned mRefs;
+  unsigned mOwnRefs;
+
+  bool refersToParam(const clang::Expr *E) const {
+    const clang::DeclRefExpr *DRE =
+        llvm::dyn_cast<clang::DeclRefExpr>(E->IgnoreParenImpCasts());
+    return (DRE != NULL) && (DRE->getDecl() == mPVD);
+  }
+
+ public:
+  ForeignElementCounter(clang::ASTContext &C, const clang::ParmVarDecl *PVD)
+      : mCtx(C), mPVD(PVD), mRefs(0), mOwnRefs(0) {
+    return;
+  }
+
+  void VisitStmt(clang::Stmt *S) {
+    for (clang::Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+         I != E;
+         I++) {
+      if (clang::Stmt *Child = *I)
+        Visit(Child);
+    }
+  }
+
+  void VisitDeclRefExpr(clang::DeclRefExpr *DRE) {
+    if (DRE->getDecl() == mPVD)
+      mRefs++;
+  }
+
+  void VisitUnaryDeref(clang::UnaryOperator *UO) {
+    if (refersToParam(UO->getSubExpr()))
+      mOwnRefs++;
+    VisitStmt(UO);
+  }
+
+  void VisitArraySubscriptExpr(clang::ArraySubscriptExpr *ASE) {
+    llvm::APSInt Idx;
+    if (refersToParam(ASE->getBase()) &&
+        ASE->getIdx()->isIntegerConstantExpr(Idx, mCtx) && !Idx)
+      mOwnRefs++;
+    VisitStmt(ASE);
+  }
+
+  void VisitMemberExpr(clang::MemberExpr *ME) {
+    if (ME->isArrow() && refersToParam(ME->getBase()))
+      mOwnRefs++;
+    VisitStmt(ME);
+  }
+
+  unsigned getCount() const {
+    return mRefs - mOwnRefs;
+  }
+};
+
 }  // namespace
 
 // This function takes care of additional validation and construction of
@@ -59,7 +123,7 @@ bool RSExportForEach::validateAndConstructParams(
   clang::ASTContext &C = Context->getASTContext();
   clang::DiagnosticsEngine *DiagEngine = Context->getDiagnostics();
 
-  if (!isRootRSFunc(FD)) {
+  if (!isRootRSFunc(FD) && !Context->isFusedKernel(FD->getName())) {
     slangAssert(false && "must be called on compute root function!");
   }
 
@@ -71,8 +135,9 @@ bool RSExportForEach::validateAndConstructParams(
     DiagEngine->Report(
       clang::FullSourceLoc(FD->getLocation(), DiagEngine->getSourceManager()),
       DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
-                                  "compute root() is required to return a "
-                                  "void type"));
+                                  "compute %0() is required to return a "
+                                  "void type"))
+      << FD->getName();
     valid = false;
   }
 
@@ -104,8 +169,9 @@ bool RSExportForEach::validateAndConstructParams(
       clang::FullSourceLoc(FD->getLocation(),
                            DiagEngine->getSourceManager()),
       DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
-                                  "Compute root() must have at least one "
-                                  "parameter for in or out"));
+                                  "Compute %0() must have at least one "
+                                  "parameter for in or out"))
+      << FD->getName();
     valid = false;
   }
 
@@ -128,9 +194,9 @@ bool RSExportForEach::validateAndConstructParams(
         clang::FullSourceLoc(PVD->getLocation(),
                              DiagEngine->getSourceManager()),
         DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
-                                    "Unexpected root() parameter '%0' "
-                                    "of type '%1'"))
-        << PVD->getName() << PVD->getType().getAsString();
+                                    "Unexpected %0() parameter '%1' "
+                                    "of type '%2'"))
+        << FD->getName() << PVD->getName() << PVD->getType().getAsString();
       valid = false;
     } else {
       llvm::StringRef ParamName = PVD->getName();
@@ -162,9 +228,10 @@ bool RSExportForEach::validateAndConstructParams(
             clang::FullSourceLoc(PVD->getLocation(),
                                  DiagEngine->getSourceManager()),
             DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
-                                        "Unexpected root() parameter '%0' "
-                                        "of type '%1'"))
-            << PVD->getName() << PVD->getType().getAsString();
+                                        "Unexpected %0() parameter '%1' "
+                                        "of type '%2'"))
+            << FD->getName() << PVD->getName()
+            << PVD->getType().getAsString();
           valid = false;
         }
       }
@@ -176,11 +243,11 @@ bool RSExportForEach::validateAndConstructParams(
   mMetadataEncoding = 0;
   if (valid) {
     // Set up the bitwise metadata encoding for runtime argument passing.
-    mMetadataEncoding |= (mIn ?       0x01 : 0);
-    mMetadataEncoding |= (mOut ?      0x02 : 0);
-    mMetadataEncoding |= (mUsrData ?  0x04 : 0);
-    mMetadataEncoding |= (mX ?        0x08 : 0);
-    mMetadataEncoding |= (mY ?        0x10 : 0);
+    mMetadataEncoding |= (mIn ?       ME_In : 0);
+    mMetadataEncoding |= (mOut ?      ME_Out : 0);
+    mMetadataEncoding |= (mUsrData ?  ME_UsrData : 0);
+    mMetadataEncoding |= (mX ?        ME_X : 0);
+    mMetadataEncoding |= (mY ?        ME_Y : 0);
   }
 
   if (Context->getTargetAPI() < SLANG_ICS_TARGET_API) {
@@ -195,9 +262,10 @@ bool RSExportForEach::validateAndConstructParams(
         clang::FullSourceLoc(FD->getLocation(),
                              DiagEngine->getSourceManager()),
         DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
-                                    "Compute root() targeting SDK levels "
-                                    "%0-%1 may not skip parameters"))
-        << SLANG_MINIMUM_TARGET_API << (SLANG_ICS_TARGET_API-1);
+                                    "Compute %0() targeting SDK levels "
+                                    "%1-%2 may not skip parameters"))
+        << FD->getName() << SLANG_MINIMUM_TARGET_API
+        << (SLANG_ICS_TARGET_API-1);
       valid = false;
     }
   }
@@ -293,6 +361,124 @@ RSExportForEach *RSExportForEach::Create(RSContext *Context,
   return FE;
 }
 
+RSExportForEach *RSExportForEach::CreateFused(
+    RSContext *Context,
+    const clang::FunctionDecl *First,
+    const clang::FunctionDecl *Second) {
+  slangAssert(Context && First && Second);
+  clang::DiagnosticsEngine *DiagEngine = Context->getDiagnostics();
+  const clang::SourceManager &SM = DiagEngine->getSourceManager();
+
+  if (Context->getTargetAPI() < SLANG_ICS_TARGET_API) {
+    DiagEngine->Report(
+      clang::FullSourceLoc(First->getLocation(), SM),
+      DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                  "kernel fusion requires target API %0 or "
+                                  "above"))
+      << SLANG_ICS_TARGET_API;
+    return NULL;
+  }
+
+  RSExportForEach *FEFirst = Create(Context, First);
+  RSExportForEach *FESecond = Create(Context, Second);
+  if (FEFirst == NULL || FESecond == NULL)
+    return NULL;
+
+  bool valid = true;
+  const RSExportForEach *Stages[2] = { FEFirst, FESecond };
+  const clang::FunctionDecl *StageFDs[2] = { First, Second };
+  for (int i = 0; i < 2; i++) {
+    // Check the encoding for usrData (mUsrData is cleared for void*).
+    if (!Stages[i]->mIn || !Stages[i]->mOut ||
+        (Stages[i]->mMetadataEncoding & ME_UsrData)) {
+      DiagEngine->Report(
+        clang::FullSourceLoc(StageFDs[i]->getLocation(), SM),
+        DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                    "fused kernel '%0' must take exactly one "
+                                    "input and one output and no usrData"))
+        << StageFDs[i]->getName();
+      valid = false;
+    }
+  }
+
+  if (!valid)
+    return NULL;
+
+  clang::QualType FirstOutTy = FEFirst->mOut->getType().getCanonicalType()
+      ->getPointeeType().getUnqualifiedType();
+  clang::QualType SecondInTy = FESecond->mIn->getType().getCanonicalType()
+      ->getPointeeType().getUnqualifiedType();
+  if (FirstOutTy != SecondInTy) {
+    DiagEngine->Report(
+      clang::FullSourceLoc(Second->getLocation(), SM),
+      DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                  "fused kernel '%0' expects input elements "
+                                  "of type '%1', but '%2' produces '%3'"))
+      << Second->getName() << SecondInTy.getAsString()
+      << First->getName() << FirstOutTy.getAsString();
+    valid = false;
+  }
+
+  // The intermediate result is never materialized in an allocation, so the
+  // second kernel cannot look at neighbouring elements.
+  ForeignElementCounter Counter(Context->getASTContext(), FESecond->mIn);
+  Counter.Visit(Second->getBody());
+  if (Counter.getCount() != 0) {
+    DiagEngine->Report(
+      clang::FullSourceLoc(Second->getLocation(), SM),
+      DiagEngine->getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                  "kernel '%0' may only read its own input "
+                                  "element to be fused"))
+      << Second->getName();
+    valid = false;
+  }
+
+  if (!valid)
+    return NULL;
+
+  std::string Name(First->getName());
+  Name.append("_").append(Second->getName());
+
+  RSExportForEach *FE = new RSExportForEach(Context, Name, First);
+  FE->mIn = FEFirst->mIn;
+  FE->mOut = FESecond->mOut;
+  FE->mInType = FEFirst->mInType;
+  FE->mOutType = FESecond->mOutType;
+  FE->mX = (FEFirst->mX ? FEFirst->mX : FESecond->mX);
+  FE->mY = (FEFirst->mY ? FEFirst->mY : FESecond->mY);
+  FE->numParams = 2 + (FE->mX ? 1 : 0) + (FE->mY ? 1 : 0);
+  FE->mMetadataEncoding =
+      ME_In | ME_Out | (FE->mX ? ME_X : 0) | (FE->mY ? ME_Y : 0);
+  FE->mFuseFirst = FEFirst;
+  FE->mFuseSecond = FESecond;
+
+  return FE;
+}
+
+RSExportForEach *RSExportForEach::CreateSpecialized(
+    RSContext *Context,
+    const RSExportForEach *Base) {
+  slangAssert(Context && Base);
+
+  RSExportForEach *FE =
+      new RSExportForEach(Context, Base->getName() + "_specialized", NULL);
+  FE->mParamPacketType = Base->mParamPacketType;
+  FE->mInType = Base->mInType;
+  FE->mOutType = Base->mOutType;
+  FE->numParams = Base->numParams;
+  FE->mMetadataEncoding = Base->mMetadataEncoding;
+  FE->mIn = Base->mIn;
+  FE->mOut = Base->mOut;
+  FE->mUsrData = Base->mUsrData;
+  FE->mX = Base->mX;
+  FE->mY = Base->mY;
+  FE->mZ = Base->mZ;
+  FE->mAr = Base->mAr;
+  FE->mSpecializedFrom = Base;
+
+  return FE;
+}
+
 bool RSExportForEach::isRSForEachFunc(int targetAPI,
     const clang::FunctionDecl *FD) {
   // We currently support only compute root() being exported via forEach
@@ -53,6 +53,13 @@ class RSExportForEach : public RSExportable {
   const clang::ParmVarDecl *mZ;
   const clang::ParmVarDecl *mAr;
 
+  // For fused kernels, the two stages (in calling order)
+  const RSExportForEach *mFuseFirst;
+  const RSExportForEach *mFuseSecond;
+
+  // For specialized kernels, the generic kernel they were derived from
+  const RSExportForEach *mSpecializedFrom;
+
   // TODO(all): Add support for LOD/face when we have them
   RSExportForEach(RSContext *Context, const llvm::StringRef &Name,
          const clang::FunctionDecl *FD)
@@ -60,7 +67,8 @@ class RSExportForEach : public RSExportable {
       mName(Name.data(), Name.size()), mParamPacketType(NULL), mInType(NULL),
       mOutType(NULL), numParams(0), mMetadataEncoding(0),
       mIn(NULL), mOut(NULL), mUsrData(NULL),
-      mX(NULL), mY(NULL), mZ(NULL), mAr(NULL) {
+      mX(NULL), mY(NULL), mZ(NULL), mAr(NULL),
+      mFuseFirst(NULL), mFuseSecond(NULL), mSpecializedFrom(NULL) {
     return;
   }
 
@@ -68,9 +76,33 @@ class RSExportForEach : public RSExportable {
                                   const clang::FunctionDecl *FD);
 
  public:
+  // The bits of getMetadataEncoding(), one per parameter the kernel takes
+  enum {
+    ME_In = 0x01,
+    ME_Out = 0x02,
+    ME_UsrData = 0x04,
+    ME_X = 0x08,
+    ME_Y = 0x10
+  };
+
   static RSExportForEach *Create(RSContext *Context,
                                  const clang::FunctionDecl *FD);
 
+  // Create the kernel computing Second(First(in)) for each element, as
+  // requested by #pragma rs fuse(First, Second). Both kernels must take a
+  // single input and output and no usrData, and Second may only read its own
+  // input element.
+  static RSExportForEach *CreateFused(RSContext *Context,
+                                      const clang::FunctionDecl *First,
+                                      const clang::FunctionDecl *Second);
+
+  // Create the variant of @Base that is compiled with the global values
+  // requested by #pragma rs specialize (see
+  // RSContext::specializations_begin()). It is named <base>_specialized and
+  // gets its own slot.
+  static RSExportForEach *CreateSpecialized(RSContext *Context,
+                                            const RSExportForEach *Base);
+
   inline const std::string &getName() const {
     return mName;
   }
@@ -107,6 +139,26 @@ class RSExportForEach : public RSExportable {
     return mMetadataEncoding;
   }
 
+  inline bool isFused() const {
+    return (mFuseFirst != NULL);
+  }
+
+  inline const RSExportForEach *getFusedFirst() const {
+    return mFuseFirst;
+  }
+
+  inline const RSExportForEach *getFusedSecond() const {
+    return mFuseSecond;
+  }
+
+  inline bool isSpecialized() const {
+    return (mSpecializedFrom != NULL);
+  }
+
+  inline const RSExportForEach *getSpecializedFrom() const {
+    return mSpecializedFrom;
+  }
+
   typedef RSExportRecordType::const_field_iterator const_param_iterator;
 
   inline const_param_iterator params_begin() const {
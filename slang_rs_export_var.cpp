@@ -32,7 +32,8 @@ RSExportVar::RSExportVar(RSContext *Context,
     : RSExportable(Context, RSExportable::EX_VAR),
       mName(VD->getName().data(), VD->getName().size()),
       mET(ET),
-      mIsConst(false) {
+      mIsConst(false),
+      mIsFoldedConst(false) {
   // mInit - Evaluate initializer expression
   const clang::Expr *Initializer = VD->getAnyInitializer();
   if (Initializer != NULL) {
@@ -73,6 +74,13 @@ RSExportVar::RSExportVar(RSContext *Context,
     mIsConst = QT.isConstQualified();
   }
 
+  // mIsFoldedConst - Can it be replaced by its value?
+  if (mIsConst && !mInit.Val.isUninit() &&
+      (ET->getClass() == RSExportType::ExportClassPrimitive) &&
+      !static_cast<const RSExportPrimitiveType*>(ET)->isRSObjectType()) {
+    mIsFoldedConst = (mInit.Val.isInt() || mInit.Val.isFloat());
+  }
+
   return;
 }
 
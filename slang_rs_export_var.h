@@ -40,6 +40,7 @@ class RSExportVar : public RSExportable {
   std::string mName;
   const RSExportType *mET;
   bool mIsConst;
+  bool mIsFoldedConst;
 
   clang::Expr::EvalResult mInit;
 
@@ -51,6 +52,9 @@ class RSExportVar : public RSExportable {
   inline const std::string &getName() const { return mName; }
   inline const RSExportType *getType() const { return mET; }
   inline bool isConst() const { return mIsConst; }
+  // A const variable of primitive type with a known initializer is folded
+  // into the code and reflected as a Java constant, so it has no export slot.
+  inline bool isFoldedConst() const { return mIsFoldedConst; }
 
   inline const clang::APValue &getInit() const { return mInit.Val; }
 };  // RSExportVar
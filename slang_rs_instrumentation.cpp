@@ -0,0 +1,249 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_instrumentation.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/Diagnostic.h"
+
+#include "llvm/Analysis/ValueTracking.h"
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Function.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/Instructions.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Metadata.h"
+#include "llvm/Module.h"
+
+#include "llvm/Support/IRBuilder.h"
+#include "llvm/Support/InstIterator.h"
+
+#include "slang_assert.h"
+#include "slang_rs_metadata.h"
+
+namespace slang {
+
+namespace {
+
+// int64_t rsUptimeNanos(), from the runtime. The code generator lowers
+// llvm.readcyclecounter to 0 on ARM, so the regions are timed by the clock.
+static const char UptimeNanosFunc[] = "_Z13rsUptimeNanosv";
+
+// A call to RS_REGION_BEGIN_FUNC or RS_REGION_END_FUNC
+struct RegionMarker {
+  llvm::CallInst *Call;
+  std::string Name;
+};
+
+// The first instruction of @F that is not one of the allocas that start its
+// entry block
+static llvm::Instruction *GetEntryInsertPoint(llvm::Function *F) {
+  llvm::BasicBlock::iterator I = F->getEntryBlock().begin();
+  while (llvm::isa<llvm::AllocaInst>(I))
+    I++;
+  return I;
+}
+
+static void AddToCounter(llvm::IRBuilder<> &IB,
+                         llvm::GlobalVariable *Counters,
+                         unsigned Index,
+                         llvm::Value *Amount) {
+  IB.CreateAtomicRMW(llvm::AtomicRMWInst::Add,
+                     IB.CreateConstInBoundsGEP2_32(Counters, 0, Index),
+                     Amount,
+                     llvm::Monotonic);
+  return;
+}
+
+// Collect the calls to @Marker (which @Macro calls) in @M, in the order of the
+// code. The calls without a constant name are reported and removed.
+static void GetRegionMarkers(llvm::Module *M,
+                             const llvm::Function *Marker,
+                             const char *Macro,
+                             std::vector<RegionMarker> &Markers,
+                             clang::DiagnosticsEngine &DiagEngine) {
+  if (Marker == NULL)
+    return;
+
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    std::vector<llvm::CallInst*> Unnamed;
+    for (llvm::inst_iterator I = llvm::inst_begin(F), IE = llvm::inst_end(F);
+         I != IE;
+         I++) {
+      llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+      if ((CI == NULL) || (CI->getCalledFunction() != Marker))
+        continue;
+
+      RegionMarker RM;
+      RM.Call = CI;
+      if ((CI->getNumArgOperands() != 1) ||
+          !llvm::GetConstantStringInfo(CI->getArgOperand(0), RM.Name)) {
+        DiagEngine.Report(DiagEngine.getCustomDiagID(
+            clang::DiagnosticsEngine::Error,
+            "%0() in '%1' needs a constant region name"))
+            << Macro << F->getName();
+        Unnamed.push_back(CI);
+        continue;
+      }
+      Markers.push_back(RM);
+    }
+
+    for (unsigned i = 0, e = Unnamed.size(); i != e; i++)
+      Unnamed[i]->eraseFromParent();
+  }
+
+  return;
+}
+
+}  // namespace
+
+const char *RSInstrumentation::getKindName(CounterKind K) {
+  switch (K) {
+    case CK_Elements: return "elements";
+    case CK_Calls: return "calls";
+    case CK_RegionEntries: return "region_entries";
+    case CK_RegionNanos: return "region_nanos";
+    default: break;
+  }
+  slangAssert(false && "Unknown instrumentation counter kind");
+  return NULL;
+}
+
+void RSInstrumentation::addKernel(llvm::Function *F) {
+  mEntries.push_back(std::make_pair(F, mCounters.size()));
+  mCounters.push_back(std::make_pair(CK_Elements, F->getName().str()));
+  return;
+}
+
+void RSInstrumentation::addInvokable(llvm::Function *F) {
+  mEntries.push_back(std::make_pair(F, mCounters.size()));
+  mCounters.push_back(std::make_pair(CK_Calls, F->getName().str()));
+  return;
+}
+
+void RSInstrumentation::instrument(llvm::Module *M,
+                                   clang::DiagnosticsEngine &DiagEngine) {
+  llvm::LLVMContext &C = M->getContext();
+  llvm::Type *Int64Ty = llvm::Type::getInt64Ty(C);
+
+  llvm::Function *BeginFunc = M->getFunction(RS_REGION_BEGIN_FUNC);
+  llvm::Function *EndFunc = M->getFunction(RS_REGION_END_FUNC);
+
+  std::vector<RegionMarker> Begins, Ends;
+  GetRegionMarkers(M, BeginFunc, "RS_REGION_BEGIN", Begins, DiagEngine);
+  GetRegionMarkers(M, EndFunc, "RS_REGION_END", Ends, DiagEngine);
+
+  // Each region has an entries counter followed by a nanoseconds counter
+  std::map<std::string, unsigned> Regions;
+  for (unsigned i = 0, e = Begins.size(); i != e; i++) {
+    if (Regions.count(Begins[i].Name))
+      continue;
+    Regions[Begins[i].Name] = mCounters.size();
+    mCounters.push_back(std::make_pair(CK_RegionEntries, Begins[i].Name));
+    mCounters.push_back(std::make_pair(CK_RegionNanos, Begins[i].Name));
+  }
+
+  // Without counters there is nothing to add, but the region markers (which
+  // can then only be unpaired ends) must still be checked and removed
+  llvm::GlobalVariable *Counters = NULL;
+  if (!mCounters.empty()) {
+    llvm::ArrayType *CountersTy =
+        llvm::ArrayType::get(Int64Ty, mCounters.size());
+    Counters =
+        new llvm::GlobalVariable(*M, CountersTy, false,
+                                 llvm::GlobalValue::ExternalLinkage,
+                                 llvm::Constant::getNullValue(CountersTy),
+                                 RS_INSTR_COUNTERS_NAME);
+
+    llvm::NamedMDNode *CountersMetadata =
+        M->getOrInsertNamedMetadata(RS_INSTR_COUNTERS_MN);
+    for (unsigned i = 0, e = mCounters.size(); i != e; i++) {
+      llvm::Value *Counter[] = {
+        llvm::MDString::get(C, getKindName(mCounters[i].first)),
+        llvm::MDString::get(C, mCounters[i].second)
+      };
+      CountersMetadata->addOperand(llvm::MDNode::get(C, Counter));
+    }
+  }
+
+  llvm::IRBuilder<> IB(C);
+
+  for (unsigned i = 0, e = mEntries.size(); i != e; i++) {
+    IB.SetInsertPoint(GetEntryInsertPoint(mEntries[i].first));
+    AddToCounter(IB, Counters, mEntries[i].second, IB.getInt64(1));
+  }
+
+  llvm::Constant *UptimeNanos = NULL;
+  if (!Begins.empty())
+    UptimeNanos = M->getOrInsertFunction(UptimeNanosFunc, Int64Ty, NULL);
+
+  // A region remembers when it began in a local of the function it is in
+  std::map<std::pair<llvm::Function*, std::string>, llvm::AllocaInst*> Starts;
+
+  for (unsigned i = 0, e = Begins.size(); i != e; i++) {
+    llvm::CallInst *CI = Begins[i].Call;
+    llvm::Function *F = CI->getParent()->getParent();
+    llvm::AllocaInst *&Start = Starts[std::make_pair(F, Begins[i].Name)];
+    if (Start == NULL)
+      Start = new llvm::AllocaInst(Int64Ty, "region." + Begins[i].Name,
+                                   F->getEntryBlock().begin());
+
+    // Count the entry before reading the clock, to leave it out of the
+    // time
+    IB.SetInsertPoint(CI);
+    AddToCounter(IB, Counters, Regions[Begins[i].Name], IB.getInt64(1));
+    IB.CreateStore(IB.CreateCall(UptimeNanos), Start);
+    CI->eraseFromParent();
+  }
+
+  for (unsigned i = 0, e = Ends.size(); i != e; i++) {
+    llvm::CallInst *CI = Ends[i].Call;
+    llvm::Function *F = CI->getParent()->getParent();
+    std::map<std::pair<llvm::Function*, std::string>,
+             llvm::AllocaInst*>::const_iterator Start =
+        Starts.find(std::make_pair(F, Ends[i].Name));
+    if (Start == Starts.end()) {
+      DiagEngine.Report(DiagEngine.getCustomDiagID(
+          clang::DiagnosticsEngine::Error,
+          "RS_REGION_END(%0) in '%1' has no RS_REGION_BEGIN(%0) in the same "
+          "function"))
+          << Ends[i].Name << F->getName();
+      CI->eraseFromParent();
+      continue;
+    }
+
+    IB.SetInsertPoint(CI);
+    llvm::Value *Now = IB.CreateCall(UptimeNanos);
+    AddToCounter(IB, Counters, Regions[Ends[i].Name] + 1,
+                 IB.CreateSub(Now, IB.CreateLoad(Start->second)));
+    CI->eraseFromParent();
+  }
+
+  if ((BeginFunc != NULL) && BeginFunc->use_empty())
+    BeginFunc->eraseFromParent();
+  if ((EndFunc != NULL) && EndFunc->use_empty())
+    EndFunc->eraseFromParent();
+
+  return;
+}
+
+}  // namespace slang
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_INSTRUMENTATION_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_INSTRUMENTATION_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// The functions that RS_REGION_BEGIN(name) and RS_REGION_END(name) call with
+// "name" under -instrument. They are replaced by the counter updates.
+#define RS_REGION_BEGIN_FUNC "__rs_region_begin"
+#define RS_REGION_END_FUNC "__rs_region_end"
+
+namespace clang {
+  class DiagnosticsEngine;
+}  // namespace clang
+
+namespace llvm {
+  class Function;
+  class Module;
+}  // namespace llvm
+
+namespace slang {
+
+// Counters built into a script for investigating it on the device
+// (-instrument): the elements each forEach kernel processed, the calls to
+// each invokable, and how many times and for how many nanoseconds (by
+// rsUptimeNanos()) the code between RS_REGION_BEGIN(name) and
+// RS_REGION_END(name) ran. The counters are the
+// i64 elements of the RS_INSTR_COUNTERS_NAME global, updated atomically, and
+// RS_INSTR_COUNTERS_MN describes them, so a dump of the global can be decoded
+// with the bitcode.
+class RSInstrumentation {
+ public:
+  enum CounterKind {
+    CK_Elements,
+    CK_Calls,
+    CK_RegionEntries,
+    CK_RegionNanos
+  };
+
+  static const char *getKindName(CounterKind K);
+
+ private:
+  std::vector<std::pair<CounterKind, std::string> > mCounters;
+
+  // The kernels and invokables, with their counters
+  std::vector<std::pair<llvm::Function*, unsigned> > mEntries;
+
+ public:
+  RSInstrumentation() {
+    return;
+  }
+
+  // Count the elements forEach kernel @F processes
+  void addKernel(llvm::Function *F);
+
+  // Count the calls to invokable @F
+  void addInvokable(llvm::Function *F);
+
+  // Add the counters of the kernels and invokables added so far and of the
+  // regions marked in @M, and describe them in its metadata. Regions that
+  // end without beginning in the same function are errors.
+  void instrument(llvm::Module *M, clang::DiagnosticsEngine &DiagEngine);
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_INSTRUMENTATION_H_  NOLINT
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_internalize.h"
+
+#include <vector>
+
+#include "llvm/Metadata.h"
+#include "llvm/Module.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include "slang_rs_metadata.h"
+
+namespace slang {
+
+namespace {
+
+static bool GetExportSymbolNames(const llvm::NamedMDNode *N,
+                                 unsigned NameOpIdx,
+                                 std::vector<const char *> &Names) {
+  if (N == NULL)
+    return true;
+
+  for (unsigned i = 0, e = N->getNumOperands(); i != e; ++i) {
+    llvm::MDNode *V = N->getOperand(i);
+    if (V == NULL)
+      continue;
+
+    if (V->getNumOperands() < (NameOpIdx + 1)) {
+      llvm::errs() << "Invalid metadata spec of " << N->getName()
+                   << " in Renderscript executable. (#op)\n";
+      return false;
+    }
+
+    llvm::MDString *Name =
+        llvm::dyn_cast<llvm::MDString>(V->getOperand(NameOpIdx));
+    if (Name == NULL) {
+      llvm::errs() << "Invalid metadata spec of " << N->getName()
+                   << " in Renderscript executable. (#name)\n";
+      return false;
+    }
+
+    Names.push_back(Name->getString().data());
+  }
+  return true;
+}
+
+}  // namespace
+
+bool GetRSExternalSymbols(const llvm::Module *M,
+                          std::vector<const char *> &Names) {
+  Names.push_back("init");
+  Names.push_back("root");
+  Names.push_back(".rs.dtor");
+
+  // Read by whoever runs an instrumented script
+  Names.push_back(RS_PROFILE_COUNTERS_NAME);
+  Names.push_back(RS_PROFILE_LAYOUT_NAME);
+  Names.push_back(RS_INSTR_COUNTERS_NAME);
+
+  // Variables marked as export must be externally visible
+  if (!GetExportSymbolNames(M->getNamedMetadata(RS_EXPORT_VAR_MN),
+                            RS_EXPORT_VAR_NAME, Names))
+    return false;
+  // So are those exported functions
+  if (!GetExportSymbolNames(M->getNamedMetadata(RS_EXPORT_FUNC_MN),
+                            RS_EXPORT_FUNC_NAME, Names))
+    return false;
+  // And the forEach kernels (other than root, e.g. fused kernels)
+  if (!GetExportSymbolNames(M->getNamedMetadata(RS_EXPORT_FOREACH_NAME_MN),
+                            RS_EXPORT_FOREACH_NAME, Names))
+    return false;
+
+  return true;
+}
+
+}  // namespace slang
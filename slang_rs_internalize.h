@@ -0,0 +1,42 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_INTERNALIZE_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_INTERNALIZE_H_
+
+#include <vector>
+
+namespace llvm {
+  class Module;
+}  // namespace llvm
+
+namespace slang {
+
+// Add to @Names the symbols of script @M that the runtime looks up and which
+// must therefore not be internalized: init, root and .rs.dtor, the exported
+// variables, functions and forEach kernels (as listed in the export metadata)
+// and the counters of -profile-generate and -instrument. Everything else is
+// only referred to from inside the script.
+//
+// Both llvm-rs-cc (before optimizing) and llvm-rs-link (after linking in the
+// runtime library) internalize with this list. The names point into @M. Return
+// false if the export metadata of @M is malformed.
+bool GetRSExternalSymbols(const llvm::Module *M,
+                          std::vector<const char *> &Names);
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_INTERNALIZE_H_  NOLINT
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_kernel_cost.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+
+#include "llvm/Function.h"
+#include "llvm/Instructions.h"
+#include "llvm/IntrinsicInst.h"
+#include "llvm/Intrinsics.h"
+
+#include "slang_assert.h"
+#include "slang_rs_passes.h"
+
+namespace slang {
+
+namespace {
+
+// Assumed iteration count of a loop with unknown trip count
+static const unsigned DefaultLoopTrips = 8;
+
+// Nesting limit for calls to functions defined in the script
+static const unsigned MaxCallDepth = 4;
+
+// Counts saturate here, so deep loop nests cannot overflow them
+static const unsigned MaxCount = 1U << 30;
+
+static unsigned SaturatingMul(unsigned A, unsigned B) {
+  if ((A != 0) && (B > MaxCount / A))
+    return MaxCount;
+  return A * B;
+}
+
+// The math builtins that are implemented with a polynomial or a loop, rather
+// than a handful of instructions
+static const char *TranscendentalBuiltins[] = {
+  "acos", "acosh", "acospi", "asin", "asinh", "asinpi", "atan", "atan2",
+  "atan2pi", "atanh", "atanpi", "cbrt", "cos", "cosh", "cospi", "distance",
+  "erf", "erfc", "exp", "exp10", "exp2", "expm1", "fast_distance",
+  "fast_length", "fast_normalize", "fmod", "hypot", "length", "lgamma", "log",
+  "log10", "log1p", "log2", "logb", "normalize", "pow", "pown", "powr",
+  "remainder", "remquo", "rootn", "rsqrt", "sin", "sincos", "sinh", "sinpi",
+  "sqrt", "tan", "tanh", "tanpi", "tgamma"
+};
+
+// The math builtins that amount to a few ALU instructions
+static const char *ALUBuiltins[] = {
+  "abs", "ceil", "clamp", "copysign", "cross", "degrees", "dot", "fabs",
+  "fdim", "floor", "fma", "fmax", "fmin", "fract", "mad", "max", "min", "mix",
+  "radians", "rint", "round", "sign", "step", "trunc"
+};
+
+static bool IsInList(llvm::StringRef Name, const char **List, size_t Size) {
+  for (size_t i = 0; i < Size; i++)
+    if (Name == List[i])
+      return true;
+  return false;
+}
+
+#define IS_IN_LIST(Name, List)  \
+  IsInList(Name, List, sizeof(List) / sizeof(List[0]))
+
+}  // namespace
+
+class RSKernelCostEstimator {
+ private:
+  RSKernelCost &mCost;
+  // Functions being estimated, to cut off recursion
+  std::set<const llvm::Function*> mActive;
+
+  void add(RSKernelCost::Class C, unsigned Weight) {
+    mCost.mCount[C] = std::min(mCost.mCount[C] + Weight, MaxCount);
+    return;
+  }
+
+  void addCall(llvm::CallInst *CI, unsigned Weight, unsigned Depth) {
+    llvm::Function *Callee = CI->getCalledFunction();
+    if (Callee == NULL) {
+      add(RSKernelCost::KC_Call, Weight);
+      return;
+    }
+
+    if (!Callee->isDeclaration()) {
+      if ((Depth < MaxCallDepth) && !mActive.count(Callee))
+        addFunction(Callee, Weight, Depth + 1);
+      else
+        add(RSKernelCost::KC_Call, Weight);
+      return;
+    }
+
+    if (llvm::IntrinsicInst *II = llvm::dyn_cast<llvm::IntrinsicInst>(CI)) {
+      switch (II->getIntrinsicID()) {
+        case llvm::Intrinsic::dbg_declare:
+        case llvm::Intrinsic::dbg_value:
+        case llvm::Intrinsic::lifetime_start:
+        case llvm::Intrinsic::lifetime_end: {
+          return;
+        }
+        case llvm::Intrinsic::memcpy:
+        case llvm::Intrinsic::memmove:
+        case llvm::Intrinsic::memset: {
+          add(RSKernelCost::KC_Memory, Weight);
+          return;
+        }
+        case llvm::Intrinsic::cos:
+        case llvm::Intrinsic::exp:
+        case llvm::Intrinsic::exp2:
+        case llvm::Intrinsic::log:
+        case llvm::Intrinsic::log10:
+        case llvm::Intrinsic::log2:
+        case llvm::Intrinsic::pow:
+        case llvm::Intrinsic::powi:
+        case llvm::Intrinsic::sin:
+        case llvm::Intrinsic::sqrt: {
+          add(RSKernelCost::KC_Math, Weight);
+          return;
+        }
+        default: {
+          add(RSKernelCost::KC_ALU, Weight);
+          return;
+        }
+      }
+    }
+
+    llvm::StringRef Name = GetRSBuiltinName(Callee);
+    if (Name.empty())
+      Name = Callee->getName();
+    if (IS_IN_LIST(Name, TranscendentalBuiltins))
+      add(RSKernelCost::KC_Math, Weight);
+    else if (IS_IN_LIST(Name, ALUBuiltins))
+      add(RSKernelCost::KC_ALU, Weight);
+    else
+      add(RSKernelCost::KC_Call, Weight);
+    return;
+  }
+
+  void addInstruction(llvm::Instruction *I, unsigned Weight, unsigned Depth) {
+    if (llvm::isa<llvm::PHINode>(I) || llvm::isa<llvm::BitCastInst>(I) ||
+        llvm::isa<llvm::AllocaInst>(I) || llvm::isa<llvm::ReturnInst>(I) ||
+        llvm::isa<llvm::UnreachableInst>(I))
+      return;
+
+    if (llvm::BranchInst *BI = llvm::dyn_cast<llvm::BranchInst>(I)) {
+      if (BI->isConditional())
+        add(RSKernelCost::KC_Branch, Weight);
+    } else if (llvm::isa<llvm::SwitchInst>(I) ||
+               llvm::isa<llvm::IndirectBrInst>(I)) {
+      add(RSKernelCost::KC_Branch, Weight);
+    } else if (llvm::isa<llvm::LoadInst>(I) || llvm::isa<llvm::StoreInst>(I) ||
+               llvm::isa<llvm::AtomicRMWInst>(I) ||
+               llvm::isa<llvm::AtomicCmpXchgInst>(I)) {
+      add(RSKernelCost::KC_Memory, Weight);
+    } else if (llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(I)) {
+      addCall(CI, Weight, Depth);
+    } else {
+      add(RSKernelCost::KC_ALU, Weight);
+    }
+    return;
+  }
+
+ public:
+  explicit RSKernelCostEstimator(RSKernelCost &Cost) : mCost(Cost) {
+    return;
+  }
+
+  void addFunction(llvm::Function *F, unsigned Weight, unsigned Depth) {
+    mActive.insert(F);
+
+    llvm::DominatorTreeBase<llvm::BasicBlock> DT(false);
+    DT.recalculate(*F);
+    llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop> LI;
+    LI.Analyze(DT);
+
+    for (llvm::Function::iterator BI = F->begin(), BE = F->end();
+         BI != BE;
+         BI++) {
+      unsigned BlockWeight = Weight;
+      for (llvm::Loop *L = LI.getLoopFor(BI); L != NULL;
+           L = L->getParentLoop()) {
+        unsigned Trips = L->getSmallConstantTripCount();
+        BlockWeight = SaturatingMul(BlockWeight,
+                                    (Trips != 0) ? Trips : DefaultLoopTrips);
+      }
+
+      for (llvm::BasicBlock::iterator I = BI->begin(), E = BI->end();
+           I != E;
+           I++)
+        addInstruction(I, BlockWeight, Depth);
+    }
+
+    mActive.erase(F);
+    return;
+  }
+};
+
+RSKernelCost RSKernelCost::Estimate(llvm::Function *F) {
+  slangAssert(F && !F->isDeclaration());
+
+  RSKernelCost Cost;
+  RSKernelCostEstimator Estimator(Cost);
+  Estimator.addFunction(F, 1, 0);
+  return Cost;
+}
+
+const char *RSKernelCost::getClassName(Class C) {
+  switch (C) {
+    case KC_ALU: return "alu";
+    case KC_Memory: return "memory";
+    case KC_Math: return "math";
+    case KC_Branch: return "branch";
+    case KC_Call: return "call";
+    default: break;
+  }
+  slangAssert(false && "Unknown kernel cost class");
+  return NULL;
+}
+
+std::string RSKernelCost::getEncoding() const {
+  std::string Encoding;
+  for (unsigned i = 0; i < KC_NumClasses; i++) {
+    if (i > 0)
+      Encoding.append(",");
+    Encoding.append(llvm::utostr_32(mCount[i]));
+  }
+  return Encoding;
+}
+
+}  // namespace slang
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_KERNEL_COST_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_KERNEL_COST_H_
+
+#include <string>
+
+namespace llvm {
+  class Function;
+}  // namespace llvm
+
+namespace slang {
+
+// Static estimate of the work a forEach kernel does per element, as the
+// number of (optimized) IR instructions of each class. Instructions in loops
+// are counted once per iteration (assuming 8 iterations when the trip count
+// is unknown), and calls to functions defined in the script count the
+// callee's instructions.
+//
+// The runtime can use this to pick chunk sizes, or to run a cheap launch on
+// a single thread.
+class RSKernelCost {
+ public:
+  enum Class {
+    KC_ALU,     // Arithmetic, compares, selects and conversions
+    KC_Memory,  // Loads, stores and memory intrinsics
+    KC_Math,    // Calls to transcendental math builtins (sin, exp, pow, ...)
+    KC_Branch,  // Conditional branches and switches
+    KC_Call,    // Other calls into the runtime (rsGetElementAt, ...)
+    KC_NumClasses
+  };
+
+ private:
+  unsigned mCount[KC_NumClasses];
+
+ public:
+  RSKernelCost() {
+    for (unsigned i = 0; i < KC_NumClasses; i++)
+      mCount[i] = 0;
+    return;
+  }
+
+  static RSKernelCost Estimate(llvm::Function *F);
+
+  inline unsigned get(Class C) const { return mCount[C]; }
+
+  static const char *getClassName(Class C);
+
+  // "<alu>,<memory>,<math>,<branch>,<call>", as recorded in
+  // RS_EXPORT_FOREACH_COST_MN
+  std::string getEncoding() const;
+
+  friend class RSKernelCostEstimator;
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_KERNEL_COST_H_  NOLINT
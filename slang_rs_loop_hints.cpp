@@ -0,0 +1,253 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_loop_hints.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Stmt.h"
+#include "clang/AST/StmtVisitor.h"
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/SourceManager.h"
+
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Function.h"
+#include "llvm/Metadata.h"
+#include "llvm/Module.h"
+
+#include "slang_assert.h"
+#include "slang_rs_metadata.h"
+
+namespace slang {
+
+namespace {
+
+static const char *GetHintName(RSLoopHints::Kind K) {
+  switch (K) {
+    case RSLoopHints::LH_Unroll: return "unroll";
+    case RSLoopHints::LH_NoUnroll: return "nounroll";
+    case RSLoopHints::LH_Vectorize: return "vectorize";
+  }
+  slangAssert(false && "Unknown loop hint");
+  return NULL;
+}
+
+// Collect the loop statements of a function body in source order (which is
+// also the order clang emits their headers in).
+class LoopCollector : public clang::StmtVisitor<LoopCollector> {
+ private:
+  std::vector<const clang::Stmt*> &mLoops;
+
+ public:
+  explicit LoopCollector(std::vector<const clang::Stmt*> &Loops)
+      : mLoops(Loops) {
+    return;
+  }
+
+  void VisitStmt(clang::Stmt *S) {
+    if (llvm::isa<clang::ForStmt>(S) ||
+        llvm::isa<clang::WhileStmt>(S) ||
+        llvm::isa<clang::DoStmt>(S))
+      mLoops.push_back(S);
+
+    for (clang::Stmt::child_iterator I = S->child_begin(), E = S->child_end();
+         I != E;
+         I++) {
+      if (clang::Stmt *Child = *I)
+        Visit(Child);
+    }
+  }
+};
+
+// Orders loops by the position of their header in the function
+class LoopHeaderOrder {
+ private:
+  const std::map<const llvm::BasicBlock*, unsigned> &mBlockOrder;
+
+ public:
+  explicit LoopHeaderOrder(
+      const std::map<const llvm::BasicBlock*, unsigned> &BlockOrder)
+      : mBlockOrder(BlockOrder) {
+    return;
+  }
+
+  bool operator()(const llvm::Loop *A, const llvm::Loop *B) const {
+    return mBlockOrder.find(A->getHeader())->second <
+           mBlockOrder.find(B->getHeader())->second;
+  }
+};
+
+}  // namespace
+
+void RSLoopHints::addHint(Kind K, unsigned Count, clang::SourceLocation Loc) {
+  Hint H;
+  H.K = K;
+  H.Count = Count;
+  H.Loc = Loc;
+  mPending.push_back(H);
+
+  if (K == LH_Unroll)
+    mHasUnroll = true;
+  return;
+}
+
+void RSLoopHints::resolve(clang::ASTContext &C,
+                          clang::DiagnosticsEngine &DiagEngine) {
+  clang::SourceManager &SM = C.getSourceManager();
+  clang::TranslationUnitDecl *TUDecl = C.getTranslationUnitDecl();
+
+  std::vector<const clang::FunctionDecl*> Funcs;
+  for (clang::DeclContext::decl_iterator I = TUDecl->decls_begin(),
+          E = TUDecl->decls_end(); I != E; I++) {
+    const clang::FunctionDecl *FD = llvm::dyn_cast<clang::FunctionDecl>(*I);
+    if (FD && FD->doesThisDeclarationHaveABody())
+      Funcs.push_back(FD);
+  }
+
+  for (std::list<Hint>::const_iterator I = mPending.begin(),
+          E = mPending.end(); I != E; I++) {
+    const Hint &H = *I;
+    const clang::FunctionDecl *Owner = NULL;
+    std::vector<const clang::Stmt*> Loops;
+    int Ordinal = -1;
+
+    for (std::vector<const clang::FunctionDecl*>::const_iterator
+            FI = Funcs.begin(), FE = Funcs.end(); FI != FE; FI++) {
+      const clang::Stmt *Body = (*FI)->getBody();
+      if (SM.isBeforeInTranslationUnit(Body->getLocStart(), H.Loc) &&
+          SM.isBeforeInTranslationUnit(H.Loc, Body->getLocEnd())) {
+        Owner = *FI;
+        break;
+      }
+    }
+
+    if (Owner != NULL) {
+      LoopCollector(Loops).Visit(const_cast<clang::Stmt*>(Owner->getBody()));
+      for (unsigned i = 0, e = Loops.size(); i != e; i++) {
+        if (SM.isBeforeInTranslationUnit(H.Loc, Loops[i]->getLocStart())) {
+          Ordinal = i;
+          break;
+        }
+      }
+    }
+
+    if (Ordinal < 0) {
+      DiagEngine.Report(
+        clang::FullSourceLoc(H.Loc, SM),
+        DiagEngine.getCustomDiagID(clang::DiagnosticsEngine::Warning,
+                                   "'#pragma rs %0' is not followed by a "
+                                   "loop in the same function; ignored"))
+        << GetHintName(H.K);
+      continue;
+    }
+
+    FunctionHints &FH = mFunctionHints[Owner->getName()];
+    FH.NumLoops = Loops.size();
+    FH.Hints.push_back(std::make_pair(static_cast<unsigned>(Ordinal), H));
+  }
+
+  return;
+}
+
+void RSLoopHints::apply(llvm::Module *M,
+                        clang::DiagnosticsEngine &DiagEngine) {
+  llvm::LLVMContext &Ctx = M->getContext();
+  llvm::Type *Int32Ty = llvm::Type::getInt32Ty(Ctx);
+
+  for (llvm::StringMap<FunctionHints>::const_iterator
+          I = mFunctionHints.begin(), E = mFunctionHints.end();
+       I != E;
+       I++) {
+    const FunctionHints &FH = I->getValue();
+    llvm::Function *F = M->getFunction(I->getKey());
+    if (F == NULL || F->isDeclaration())
+      continue;
+
+    llvm::DominatorTreeBase<llvm::BasicBlock> DT(false);
+    DT.recalculate(*F);
+    llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop> LI;
+    LI.Analyze(DT);
+
+    std::map<const llvm::BasicBlock*, unsigned> BlockOrder;
+    unsigned Index = 0;
+    for (llvm::Function::const_iterator BI = F->begin(), BE = F->end();
+         BI != BE;
+         BI++)
+      BlockOrder[BI] = Index++;
+
+    std::vector<llvm::Loop*> Loops;
+    std::vector<llvm::Loop*> Worklist(LI.begin(), LI.end());
+    while (!Worklist.empty()) {
+      llvm::Loop *L = Worklist.back();
+      Worklist.pop_back();
+      Loops.push_back(L);
+      Worklist.insert(Worklist.end(), L->begin(), L->end());
+    }
+    std::sort(Loops.begin(), Loops.end(), LoopHeaderOrder(BlockOrder));
+
+    if (Loops.size() != FH.NumLoops) {
+      // Some loop was folded away (or was not a loop at all) during codegen,
+      // so we cannot tell which loop a hint was meant for.
+      DiagEngine.Report(
+        clang::FullSourceLoc(FH.Hints.front().second.Loc,
+                             DiagEngine.getSourceManager()),
+        DiagEngine.getCustomDiagID(clang::DiagnosticsEngine::Warning,
+                                   "loop hints in '%0' could not be matched "
+                                   "with the generated code; ignored"))
+        << I->getKey();
+      continue;
+    }
+
+    // Merge the hints for each loop into a single node of
+    // (name, count) pairs
+    std::map<unsigned, llvm::SmallVector<llvm::Value*, 4> > LoopOps;
+    for (unsigned i = 0, e = FH.Hints.size(); i != e; i++) {
+      const Hint &H = FH.Hints[i].second;
+      llvm::SmallVector<llvm::Value*, 4> &Ops = LoopOps[FH.Hints[i].first];
+      Ops.push_back(llvm::MDString::get(Ctx, GetHintName(H.K)));
+      Ops.push_back(llvm::ConstantInt::get(Int32Ty, H.Count));
+    }
+
+    for (std::map<unsigned, llvm::SmallVector<llvm::Value*, 4> >::iterator
+            OI = LoopOps.begin(), OE = LoopOps.end();
+         OI != OE;
+         OI++) {
+      llvm::Loop *L = Loops[OI->first];
+      llvm::MDNode *Node = llvm::MDNode::get(Ctx, OI->second);
+      for (llvm::Loop::block_iterator BI = L->block_begin(),
+              BE = L->block_end();
+           BI != BE;
+           BI++) {
+        if (LI.getLoopFor(*BI) == L)
+          (*BI)->getTerminator()->setMetadata(RS_LOOP_HINT_MD, Node);
+      }
+    }
+  }
+
+  return;
+}
+
+}  // namespace slang
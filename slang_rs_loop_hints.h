@@ -0,0 +1,99 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_LOOP_HINTS_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_LOOP_HINTS_H_
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/SourceLocation.h"
+
+#include "llvm/ADT/StringMap.h"
+
+namespace llvm {
+  class Module;
+}
+
+namespace clang {
+  class ASTContext;
+  class DiagnosticsEngine;
+}
+
+namespace slang {
+
+// Per-loop optimization hints given by #pragma rs unroll(N), #pragma rs
+// nounroll and #pragma rs vectorize. A hint applies to the first loop
+// following it in the same function.
+//
+// Clang offers no way to annotate the IR it generates for a loop, so the
+// hints are matched up in two steps: resolve() maps each hint onto the
+// ordinal of its loop within the function (in the AST), and apply() finds the
+// loop with that ordinal in the generated IR and attaches the hint as
+// RS_LOOP_HINT_MD metadata to the terminators of its blocks.
+class RSLoopHints {
+ public:
+  enum Kind {
+    LH_Unroll,
+    LH_NoUnroll,
+    LH_Vectorize
+  };
+
+ private:
+  struct Hint {
+    Kind K;
+    unsigned Count;
+    clang::SourceLocation Loc;
+  };
+
+  struct FunctionHints {
+    unsigned NumLoops;
+    // (loop ordinal, hint)
+    std::vector<std::pair<unsigned, Hint> > Hints;
+  };
+
+  std::list<Hint> mPending;
+  llvm::StringMap<FunctionHints> mFunctionHints;
+  bool mHasUnroll;
+
+ public:
+  RSLoopHints() : mHasUnroll(false) {
+    return;
+  }
+
+  void addHint(Kind K, unsigned Count, clang::SourceLocation Loc);
+
+  inline bool empty() const {
+    return mPending.empty();
+  }
+
+  // Whether any of the hints asks for a loop to be unrolled
+  inline bool hasUnrollHint() const {
+    return mHasUnroll;
+  }
+
+  // Map the hints onto the loops in @C. Must be called before codegen.
+  void resolve(clang::ASTContext &C, clang::DiagnosticsEngine &DiagEngine);
+
+  // Attach the resolved hints to the loops in @M (the unoptimized IR
+  // generated from the ASTContext given to resolve()).
+  void apply(llvm::Module *M, clang::DiagnosticsEngine &DiagEngine);
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_LOOP_HINTS_H_  NOLINT
@@ -21,6 +21,9 @@
 #define RS_EXPORT_VAR_MN  "#rs_export_var"
 #define RS_EXPORT_VAR_NAME  0
 #define RS_EXPORT_VAR_TYPE  1
+// "1" if the script never writes the variable (so the runtime may share a
+// single copy with the Java side), "0" otherwise
+#define RS_EXPORT_VAR_READ_ONLY  2
 
 #define RS_EXPORT_FUNC_MN "#rs_export_func"
 #define RS_EXPORT_FUNC_NAME 0
@@ -31,4 +34,51 @@
 
 #define RS_EXPORT_FOREACH_MN "#rs_export_foreach"
 
+#define RS_EXPORT_FOREACH_NAME_MN "#rs_export_foreach_name"
+#define RS_EXPORT_FOREACH_NAME 0
+
+// One "<alu>,<memory>,<math>,<branch>,<call>" string per forEach kernel (in
+// the order of RS_EXPORT_FOREACH_MN), estimating its instructions per element
+// (see RSKernelCost)
+#define RS_EXPORT_FOREACH_COST_MN "#rs_export_foreach_cost"
+
+// One RSSideEffects::Effect bitmask (as a decimal string) per forEach kernel
+// and per invokable function, in the order of RS_EXPORT_FOREACH_MN and
+// RS_EXPORT_FUNC_MN: 0 for pure, 0x1 reads globals, 0x2 writes globals, 0x4
+// calls side-effecting runtime APIs such as rsSendToClient()
+#define RS_EXPORT_FOREACH_SIDE_EFFECTS_MN "#rs_export_foreach_side_effects"
+#define RS_EXPORT_FUNC_SIDE_EFFECTS_MN "#rs_export_func_side_effects"
+
+// One "<contiguous>,<invariant>,<strided>,<gather>" string per forEach kernel
+// (in the order of RS_EXPORT_FOREACH_MN), counting its rsGetElementAt() and
+// rsSetElementAt() calls by how their indices move with x (see
+// RSAccessPattern)
+#define RS_EXPORT_FOREACH_ACCESS_MN "#rs_export_foreach_access"
+
+// Instruction metadata attached to the terminators of a loop's blocks to
+// carry its #pragma rs unroll/nounroll/vectorize hints as a list of
+// (hint name, count) pairs
+#define RS_LOOP_HINT_MD "rs.loop"
+
+// Globals added by -profile-generate (see RSProfile): the counters, an array
+// of i64, and a string describing them, with one
+// "function <name> <blocks> <branches>\n" line per instrumented function
+#define RS_PROFILE_COUNTERS_NAME ".rs.profile.counters"
+#define RS_PROFILE_LAYOUT_NAME ".rs.profile.layout"
+
+// Added by -instrument (see RSInstrumentation): the counters, an array of
+// i64, and one (kind, name) pair of strings per counter, in order. The kind
+// is "elements" (of a kernel), "calls" (of an invokable), "region_entries"
+// or "region_nanos".
+#define RS_INSTR_COUNTERS_NAME ".rs.instr.counters"
+#define RS_INSTR_COUNTERS_MN "#rs_instr_counters"
+
+// Added by -lto-only: the module has only been cleaned up, and llvm-rs-link
+// is to optimize it. The one string says whether the script relaxed its
+// floating-point precision.
+#define RS_DEFERRED_OPT_MN "#rs_deferred_opt"
+#define RS_DEFERRED_OPT_FP_FULL "full"
+#define RS_DEFERRED_OPT_FP_RELAXED "relaxed"
+#define RS_DEFERRED_OPT_FP_IMPRECISE "imprecise"
+
 #endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_METADATA_H_  NOLINT
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_opt_remarks.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "llvm/Analysis/DebugInfo.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+
+#include "llvm/Function.h"
+#include "llvm/Instructions.h"
+#include "llvm/Module.h"
+
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "slang_assert.h"
+#include "slang_rs_passes.h"
+
+namespace slang {
+
+namespace {
+
+// Get the source location of @I from its debug info. Return false if it has
+// none.
+static bool GetLocation(const llvm::Instruction *I,
+                        std::string &File,
+                        unsigned &Line,
+                        unsigned &Column) {
+  const llvm::DebugLoc &DL = I->getDebugLoc();
+  if (DL.isUnknown())
+    return false;
+
+  Line = DL.getLine();
+  Column = DL.getCol();
+  File.clear();
+  if (llvm::MDNode *Scope = DL.getScope(I->getContext()))
+    File = llvm::DIScope(Scope).getFilename();
+  return true;
+}
+
+// The name a call to @Callee is reported with: the builtin's name for the
+// (mangled) RS builtins, the function name otherwise
+static std::string GetCalleeName(const llvm::Function *Callee) {
+  llvm::StringRef Name = GetRSBuiltinName(Callee);
+  if (Name.empty())
+    Name = Callee->getName();
+  return Name.str();
+}
+
+// Whether a call to @Callee is one the builtin folding could remove: the math
+// builtins, as opposed to the runtime API (rs*) and plain C functions
+static bool IsMathBuiltin(const llvm::Function *Callee) {
+  llvm::StringRef Name = GetRSBuiltinName(Callee);
+  return !Name.empty() && !Name.startswith("rs");
+}
+
+static std::string GetCallKey(const std::string &Callee,
+                              const std::string &File,
+                              unsigned Line,
+                              unsigned Column) {
+  return Callee + "@" + File + ":" + llvm::utostr_32(Line) + ":" +
+         llvm::utostr_32(Column);
+}
+
+static std::string GetLineKey(const std::string &File, unsigned Line) {
+  return File + ":" + llvm::utostr_32(Line);
+}
+
+// Collect the loops of @F, outermost first
+static void GetLoops(llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop> &LI,
+                     std::vector<llvm::Loop*> &Loops) {
+  for (llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop>::iterator
+          I = LI.begin(), E = LI.end();
+       I != E;
+       I++)
+    Loops.push_back(*I);
+
+  for (unsigned i = 0; i < Loops.size(); i++) {
+    const std::vector<llvm::Loop*> &SubLoops = Loops[i]->getSubLoops();
+    Loops.insert(Loops.end(), SubLoops.begin(), SubLoops.end());
+  }
+  return;
+}
+
+}  // namespace
+
+const char *RSOptRemarks::getPassName(Pass P) {
+  switch (P) {
+    case OR_Inline: return "inline";
+    case OR_Unroll: return "unroll";
+    case OR_BuiltinFold: return "builtin-fold";
+    default: break;
+  }
+  slangAssert(false && "Unknown optimization remark pass");
+  return NULL;
+}
+
+const char *RSOptRemarks::getDecisionName(Pass P, bool Applied) {
+  switch (P) {
+    case OR_Inline: return Applied ? "inlined" : "not-inlined";
+    case OR_Unroll: return Applied ? "unrolled" : "not-unrolled";
+    case OR_BuiltinFold: return Applied ? "folded" : "not-folded";
+    default: break;
+  }
+  slangAssert(false && "Unknown optimization remark pass");
+  return NULL;
+}
+
+void RSOptRemarks::recordUnoptimized(llvm::Function *F, bool IsKernel) {
+  std::vector<llvm::Function*> Worklist;
+  Worklist.push_back(F);
+
+  for (unsigned i = 0; i < Worklist.size(); i++) {
+    llvm::Function *Fn = Worklist[i];
+    if (Fn->isDeclaration() || !mRecorded.insert(Fn).second)
+      continue;
+
+    Remark R;
+    R.Export = F->getName();
+    R.IsKernel = IsKernel;
+    R.Function = Fn->getName();
+    R.LoopDepth = 0;
+    R.Applied = false;
+
+    // Loops, located by the first instruction of their header
+    llvm::DominatorTreeBase<llvm::BasicBlock> DT(false);
+    DT.recalculate(*Fn);
+    llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop> LI;
+    LI.Analyze(DT);
+
+    std::vector<llvm::Loop*> Loops;
+    GetLoops(LI, Loops);
+    for (unsigned j = 0, e = Loops.size(); j != e; j++) {
+      llvm::BasicBlock *Header = Loops[j]->getHeader();
+      for (llvm::BasicBlock::iterator I = Header->begin(), IE = Header->end();
+           I != IE;
+           I++) {
+        if (GetLocation(I, R.File, R.Line, R.Column)) {
+          R.P = OR_Unroll;
+          R.Callee.clear();
+          R.LoopDepth = Loops[j]->getLoopDepth();
+          mRemarks.push_back(R);
+          R.LoopDepth = 0;
+          break;
+        }
+      }
+    }
+
+    // Calls to script functions and math builtins
+    for (llvm::inst_iterator I = llvm::inst_begin(Fn), IE = llvm::inst_end(Fn);
+         I != IE;
+         I++) {
+      llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+      if (CI == NULL)
+        continue;
+      llvm::Function *Callee = CI->getCalledFunction();
+      if (Callee == NULL)
+        continue;
+
+      if (!Callee->isDeclaration()) {
+        R.P = OR_Inline;
+        Worklist.push_back(Callee);
+      } else if (IsMathBuiltin(Callee)) {
+        R.P = OR_BuiltinFold;
+      } else {
+        continue;
+      }
+
+      if (GetLocation(CI, R.File, R.Line, R.Column)) {
+        R.Callee = GetCalleeName(Callee);
+        mRemarks.push_back(R);
+      }
+    }
+  }
+
+  return;
+}
+
+void RSOptRemarks::resolve(llvm::Module *M) {
+  // The located call sites, and the deepest loop each source line is in.
+  // A line from an unrolled inner loop can still be in the loop around it,
+  // so a loop survived only if its header line is still as deep as it was
+  // (inlining into a loop only makes it deeper).
+  std::set<std::string> Calls;
+  std::map<std::string, unsigned> LoopDepths;
+
+  std::string File;
+  unsigned Line, Column;
+
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    if (F->isDeclaration())
+      continue;
+
+    llvm::DominatorTreeBase<llvm::BasicBlock> DT(false);
+    DT.recalculate(*F);
+    llvm::LoopInfoBase<llvm::BasicBlock, llvm::Loop> LI;
+    LI.Analyze(DT);
+
+    for (llvm::Function::iterator BB = F->begin(), BE = F->end();
+         BB != BE;
+         BB++) {
+      unsigned Depth = LI.getLoopDepth(BB);
+      for (llvm::BasicBlock::iterator I = BB->begin(), IE = BB->end();
+           I != IE;
+           I++) {
+        if (!GetLocation(I, File, Line, Column))
+          continue;
+        if (Depth > 0) {
+          unsigned &LineDepth = LoopDepths[GetLineKey(File, Line)];
+          if (LineDepth < Depth)
+            LineDepth = Depth;
+        }
+
+        llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(I);
+        if ((CI != NULL) && (CI->getCalledFunction() != NULL))
+          Calls.insert(GetCallKey(GetCalleeName(CI->getCalledFunction()),
+                                  File, Line, Column));
+      }
+    }
+  }
+
+  for (std::vector<Remark>::iterator R = mRemarks.begin(),
+          RE = mRemarks.end();
+       R != RE;
+       R++) {
+    if (R->P == OR_Unroll)
+      R->Applied = (LoopDepths[GetLineKey(R->File, R->Line)] < R->LoopDepth);
+    else
+      R->Applied = !Calls.count(GetCallKey(R->Callee, R->File, R->Line,
+                                           R->Column));
+  }
+
+  return;
+}
+
+void RSOptRemarks::print(llvm::raw_ostream &OS) const {
+  const std::string *Export = NULL;
+
+  for (std::vector<Remark>::const_iterator R = mRemarks.begin(),
+          RE = mRemarks.end();
+       R != RE;
+       R++) {
+    if ((Export == NULL) || (*Export != R->Export)) {
+      Export = &R->Export;
+      OS << "Remarks for " << (R->IsKernel ? "kernel" : "invokable") << " '"
+         << R->Export << "':\n";
+    }
+
+    OS << "  " << R->File << ":" << R->Line << ":" << R->Column << ": ";
+    switch (R->P) {
+      case OR_Inline: {
+        OS << "call to '" << R->Callee << "' in '" << R->Function << "' "
+           << (R->Applied ? "was inlined" : "was not inlined");
+        break;
+      }
+      case OR_Unroll: {
+        OS << "loop in '" << R->Function << "' "
+           << (R->Applied ? "was unrolled or removed" : "was not unrolled");
+        break;
+      }
+      case OR_BuiltinFold: {
+        OS << "call to '" << R->Callee << "' in '" << R->Function << "' "
+           << (R->Applied ? "was folded" : "stays a call");
+        break;
+      }
+      default: {
+        slangAssert(false && "Unknown optimization remark pass");
+      }
+    }
+    OS << "\n";
+  }
+
+  return;
+}
+
+void RSOptRemarks::printTable(llvm::raw_ostream &OS) const {
+  for (std::vector<Remark>::const_iterator R = mRemarks.begin(),
+          RE = mRemarks.end();
+       R != RE;
+       R++) {
+    OS << R->Export << "\t" << getPassName(R->P) << "\t"
+       << getDecisionName(R->P, R->Applied) << "\t" << R->File << "\t"
+       << R->Line << "\t" << R->Column << "\t" << R->Function << "\t"
+       << R->Callee << "\n";
+  }
+  return;
+}
+
+}  // namespace slang
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_OPT_REMARKS_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_OPT_REMARKS_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class Function;
+  class Module;
+  class raw_ostream;
+}  // namespace llvm
+
+namespace slang {
+
+// What the optimizer did to the code of the exported kernels and invokables:
+// which calls to script functions were inlined, which loops were unrolled and
+// which calls to math builtins were folded away (-opt-remarks).
+//
+// LLVM has no way for passes to report their decisions, so they are inferred
+// by comparing the unoptimized module against the optimized one. A call site
+// or loop is identified by its source location, which needs the module to be
+// compiled with debug info (the backend strips it again after optimization).
+class RSOptRemarks {
+ public:
+  enum Pass {
+    OR_Inline,
+    OR_Unroll,
+    OR_BuiltinFold
+  };
+
+ private:
+  struct Remark {
+    Pass P;
+    // The exported kernel or invokable the remark is reported under
+    std::string Export;
+    bool IsKernel;
+    // The function containing the call site or loop
+    std::string Function;
+    // The function called (for OR_Inline and OR_BuiltinFold)
+    std::string Callee;
+    std::string File;
+    unsigned Line;
+    unsigned Column;
+    // How many loops the loop is nested in, itself included (for OR_Unroll)
+    unsigned LoopDepth;
+    // Whether the call was inlined or folded, or the loop unrolled
+    bool Applied;
+  };
+
+  std::vector<Remark> mRemarks;
+  // The functions whose call sites and loops have been recorded
+  std::set<const llvm::Function*> mRecorded;
+
+  static const char *getPassName(Pass P);
+  static const char *getDecisionName(Pass P, bool Applied);
+
+ public:
+  // Record the call sites and loops of @F, an exported kernel (@IsKernel) or
+  // invokable, and of the script functions it calls, in the unoptimized
+  // module. Functions already recorded under another export are skipped.
+  void recordUnoptimized(llvm::Function *F, bool IsKernel);
+
+  // Find out what became of the recorded call sites and loops in the
+  // optimized module @M.
+  void resolve(llvm::Module *M);
+
+  inline bool empty() const {
+    return mRemarks.empty();
+  }
+
+  // Print the remarks for humans, grouped by exported function
+  void print(llvm::raw_ostream &OS) const;
+
+  // Print the remarks as tab-separated values, one per line:
+  // export, pass, decision, file, line, column, function, callee
+  void printTable(llvm::raw_ostream &OS) const;
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_OPT_REMARKS_H_  NOLINT
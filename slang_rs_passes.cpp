@@ -0,0 +1,592 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_passes.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Function.h"
+#include "llvm/InstrTypes.h"
+#include "llvm/Instructions.h"
+#include "llvm/Module.h"
+#include "llvm/Pass.h"
+
+#include "llvm/Metadata.h"
+
+#include "llvm/Support/IRBuilder.h"
+#include "llvm/Support/InstIterator.h"
+
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/UnrollLoop.h"
+
+#include "slang_rs_metadata.h"
+
+namespace slang {
+
+namespace {
+
+// Return the reciprocal of @C if it is a finite, non-zero value (or a vector
+// of those), and NULL otherwise.
+static llvm::Constant *GetReciprocal(llvm::Constant *C) {
+  if (llvm::ConstantFP *CFP = llvm::dyn_cast<llvm::ConstantFP>(C)) {
+    const llvm::APFloat &Divisor = CFP->getValueAPF();
+    if (Divisor.isZero() || Divisor.isInfinity() || Divisor.isNaN())
+      return NULL;
+
+    llvm::APFloat Recip(Divisor.getSemantics(), 1);
+    Recip.divide(Divisor, llvm::APFloat::rmNearestTiesToEven);
+    if (Recip.isZero() || Recip.isInfinity() || Recip.isNaN())
+      return NULL;
+
+    return llvm::ConstantFP::get(C->getContext(), Recip);
+  }
+
+  if (llvm::ConstantVector *CV = llvm::dyn_cast<llvm::ConstantVector>(C)) {
+    std::vector<llvm::Constant*> Elements;
+    for (unsigned i = 0, e = CV->getNumOperands(); i != e; i++) {
+      llvm::Constant *R = GetReciprocal(CV->getOperand(i));
+      if (R == NULL)
+        return NULL;
+      Elements.push_back(R);
+    }
+    return llvm::ConstantVector::get(Elements);
+  }
+
+  return NULL;
+}
+
+class RSRelaxedFDiv : public llvm::FunctionPass {
+ public:
+  static char ID;
+
+  RSRelaxedFDiv() : llvm::FunctionPass(ID) {
+    return;
+  }
+
+  virtual bool runOnFunction(llvm::Function &F) {
+    std::vector<llvm::BinaryOperator*> Worklist;
+
+    for (llvm::inst_iterator I = llvm::inst_begin(F), E = llvm::inst_end(F);
+         I != E;
+         I++) {
+      llvm::BinaryOperator *BO = llvm::dyn_cast<llvm::BinaryOperator>(&*I);
+      if (BO && (BO->getOpcode() == llvm::Instruction::FDiv) &&
+          llvm::isa<llvm::Constant>(BO->getOperand(1)))
+        Worklist.push_back(BO);
+    }
+
+    bool Changed = false;
+    for (std::vector<llvm::BinaryOperator*>::iterator I = Worklist.begin(),
+             E = Worklist.end();
+         I != E;
+         I++) {
+      llvm::BinaryOperator *BO = *I;
+      llvm::Constant *Recip =
+          GetReciprocal(llvm::cast<llvm::Constant>(BO->getOperand(1)));
+      if (Recip == NULL)
+        continue;
+
+      llvm::BinaryOperator *Mul =
+          llvm::BinaryOperator::CreateFMul(BO->getOperand(0), Recip, "", BO);
+      Mul->takeName(BO);
+      BO->replaceAllUsesWith(Mul);
+      BO->eraseFromParent();
+      Changed = true;
+    }
+
+    return Changed;
+  }
+};
+
+// Return the loop hints attached to @L, looking at the latch first since its
+// terminator is the one most likely to survive loop canonicalization.
+static llvm::MDNode *GetLoopHints(llvm::Loop *L) {
+  if (llvm::BasicBlock *Latch = L->getLoopLatch())
+    if (llvm::MDNode *N = Latch->getTerminator()->getMetadata(RS_LOOP_HINT_MD))
+      return N;
+  return L->getHeader()->getTerminator()->getMetadata(RS_LOOP_HINT_MD);
+}
+
+class RSLoopHintUnroll : public llvm::LoopPass {
+ public:
+  static char ID;
+
+  RSLoopHintUnroll() : llvm::LoopPass(ID) {
+    return;
+  }
+
+  virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const {
+    // Same requirements as the stock loop unroller
+    AU.addRequired<llvm::LoopInfo>();
+    AU.addPreserved<llvm::LoopInfo>();
+    AU.addRequiredID(llvm::LoopSimplifyID);
+    AU.addPreservedID(llvm::LoopSimplifyID);
+    AU.addRequiredID(llvm::LCSSAID);
+    AU.addPreservedID(llvm::LCSSAID);
+    AU.addPreserved<llvm::ScalarEvolution>();
+    return;
+  }
+
+  virtual bool runOnLoop(llvm::Loop *L, llvm::LPPassManager &LPM) {
+    llvm::MDNode *Hints = GetLoopHints(L);
+    if (Hints == NULL)
+      return false;
+
+    unsigned Count = 0;
+    for (unsigned i = 0, e = Hints->getNumOperands(); i + 1 < e; i += 2) {
+      llvm::MDString *Name =
+          llvm::dyn_cast_or_null<llvm::MDString>(Hints->getOperand(i));
+      llvm::ConstantInt *Value =
+          llvm::dyn_cast_or_null<llvm::ConstantInt>(Hints->getOperand(i + 1));
+      if (Name == NULL || Value == NULL)
+        continue;
+
+      if (Name->getString() == "nounroll")
+        return false;
+      else if (Name->getString() == "unroll")
+        Count = Value->getZExtValue();
+    }
+
+    if (Count <= 1)
+      return false;
+
+    unsigned TripCount = L->getSmallConstantTripCount();
+    unsigned TripMultiple = L->getSmallConstantTripMultiple();
+
+    return llvm::UnrollLoop(L, Count, TripCount, TripMultiple,
+                            &getAnalysis<llvm::LoopInfo>(), &LPM);
+  }
+};
+
+
+// Constant folding of the RS math builtins. The functions take the operands
+// of a call (already known to be finite float constants) and return the
+// result, which is only used if it is finite as well.
+typedef float (*BuiltinFoldFn)(const float *Args);
+
+static const llvm::APFloat::roundingMode RM =
+    llvm::APFloat::rmNearestTiesToEven;
+
+static float FoldAcos(const float *A) { return ::acos(A[0]); }
+static float FoldAsin(const float *A) { return ::asin(A[0]); }
+static float FoldAtan(const float *A) { return ::atan(A[0]); }
+static float FoldAtan2(const float *A) { return ::atan2(A[0], A[1]); }
+static float FoldCbrt(const float *A) { return ::cbrt(A[0]); }
+static float FoldCeil(const float *A) { return ::ceil(A[0]); }
+static float FoldCos(const float *A) { return ::cos(A[0]); }
+static float FoldCosh(const float *A) { return ::cosh(A[0]); }
+static float FoldExp(const float *A) { return ::exp(A[0]); }
+static float FoldExp2(const float *A) { return ::exp2(A[0]); }
+static float FoldExp10(const float *A) { return ::pow(10.0, A[0]); }
+static float FoldFabs(const float *A) { return ::fabs(A[0]); }
+static float FoldFloor(const float *A) { return ::floor(A[0]); }
+static float FoldFmod(const float *A) { return ::fmod(A[0], A[1]); }
+static float FoldHypot(const float *A) { return ::hypot(A[0], A[1]); }
+static float FoldLog(const float *A) { return ::log(A[0]); }
+static float FoldLog2(const float *A) { return ::log2(A[0]); }
+static float FoldLog10(const float *A) { return ::log10(A[0]); }
+static float FoldPow(const float *A) { return ::pow(A[0], A[1]); }
+static float FoldRsqrt(const float *A) { return 1.0 / ::sqrt(A[0]); }
+static float FoldSin(const float *A) { return ::sin(A[0]); }
+static float FoldSinh(const float *A) { return ::sinh(A[0]); }
+static float FoldSqrt(const float *A) { return ::sqrt(A[0]); }
+static float FoldTan(const float *A) { return ::tan(A[0]); }
+static float FoldTanh(const float *A) { return ::tanh(A[0]); }
+
+// The following match the float arithmetic of the runtime exactly.
+static float FoldFmax(const float *A) { return (A[0] < A[1]) ? A[1] : A[0]; }
+static float FoldFmin(const float *A) { return (A[1] < A[0]) ? A[1] : A[0]; }
+
+static float FoldClamp(const float *A) {
+  float R = (A[0] < A[1]) ? A[1] : A[0];
+  return (R > A[2]) ? A[2] : R;
+}
+
+static float FoldMad(const float *A) {
+  llvm::APFloat R(A[0]);
+  R.multiply(llvm::APFloat(A[1]), RM);
+  R.add(llvm::APFloat(A[2]), RM);
+  return R.convertToFloat();
+}
+
+static float FoldMix(const float *A) {
+  llvm::APFloat Start(A[0]), R(A[1]);
+  R.subtract(Start, RM);
+  R.multiply(llvm::APFloat(A[2]), RM);
+  Start.add(R, RM);
+  return Start.convertToFloat();
+}
+
+struct FoldableBuiltin {
+  const char *Name;
+  unsigned NumArgs;
+  BuiltinFoldFn Fn;
+};
+
+static const FoldableBuiltin FoldableBuiltins[] = {
+  { "acos", 1, FoldAcos }, { "asin", 1, FoldAsin }, { "atan", 1, FoldAtan },
+  { "atan2", 2, FoldAtan2 }, { "cbrt", 1, FoldCbrt }, { "ceil", 1, FoldCeil },
+  { "clamp", 3, FoldClamp }, { "cos", 1, FoldCos }, { "cosh", 1, FoldCosh },
+  { "exp", 1, FoldExp }, { "exp2", 1, FoldExp2 }, { "exp10", 1, FoldExp10 },
+  { "fabs", 1, FoldFabs }, { "floor", 1, FoldFloor }, { "fmax", 2, FoldFmax },
+  { "fmin", 2, FoldFmin }, { "fmod", 2, FoldFmod }, { "hypot", 2, FoldHypot },
+  { "log", 1, FoldLog }, { "log2", 1, FoldLog2 }, { "log10", 1, FoldLog10 },
+  { "mad", 3, FoldMad }, { "mix", 3, FoldMix }, { "pow", 2, FoldPow },
+  { "powr", 2, FoldPow }, { "rsqrt", 1, FoldRsqrt }, { "sin", 1, FoldSin },
+  { "sinh", 1, FoldSinh }, { "sqrt", 1, FoldSqrt }, { "tan", 1, FoldTan },
+  { "tanh", 1, FoldTanh },
+};
+
+static const FoldableBuiltin *GetFoldableBuiltin(llvm::StringRef Name) {
+  for (unsigned i = 0,
+           e = sizeof(FoldableBuiltins) / sizeof(FoldableBuiltins[0]);
+       i != e;
+       i++)
+    if (Name == FoldableBuiltins[i].Name)
+      return &FoldableBuiltins[i];
+  return NULL;
+}
+
+// Return element @Idx of the constant @C, where a scalar stands for a splat.
+static llvm::Constant *GetConstantElement(llvm::Constant *C, unsigned Idx) {
+  if (!C->getType()->isVectorTy())
+    return C;
+  if (llvm::isa<llvm::ConstantAggregateZero>(C))
+    return llvm::Constant::getNullValue(C->getType()->getScalarType());
+  if (llvm::ConstantVector *CV = llvm::dyn_cast<llvm::ConstantVector>(C))
+    return CV->getOperand(Idx);
+  return NULL;
+}
+
+// If @V is a float constant (or a vector of equal float constants), return
+// its value in @Value.
+static bool GetSplatFloat(llvm::Value *V, double &Value) {
+  llvm::Constant *C = llvm::dyn_cast<llvm::Constant>(V);
+  if ((C == NULL) || !C->getType()->getScalarType()->isFloatTy())
+    return false;
+
+  unsigned NumElements = 1;
+  if (llvm::VectorType *VT = llvm::dyn_cast<llvm::VectorType>(C->getType()))
+    NumElements = VT->getNumElements();
+
+  for (unsigned i = 0; i < NumElements; i++) {
+    llvm::ConstantFP *CFP =
+        llvm::dyn_cast_or_null<llvm::ConstantFP>(GetConstantElement(C, i));
+    if (CFP == NULL)
+      return false;
+    double D = CFP->getValueAPF().convertToFloat();
+    if ((i > 0) && (D != Value))
+      return false;
+    Value = D;
+  }
+  return true;
+}
+
+// Same as GetSplatFloat() for integer constants.
+static bool GetSplatInt(llvm::Value *V, int64_t &Value) {
+  llvm::Constant *C = llvm::dyn_cast<llvm::Constant>(V);
+  if ((C == NULL) || !C->getType()->getScalarType()->isIntegerTy())
+    return false;
+
+  unsigned NumElements = 1;
+  if (llvm::VectorType *VT = llvm::dyn_cast<llvm::VectorType>(C->getType()))
+    NumElements = VT->getNumElements();
+
+  for (unsigned i = 0; i < NumElements; i++) {
+    llvm::ConstantInt *CI =
+        llvm::dyn_cast_or_null<llvm::ConstantInt>(GetConstantElement(C, i));
+    if (CI == NULL)
+      return false;
+    int64_t I = CI->getSExtValue();
+    if ((i > 0) && (I != Value))
+      return false;
+    Value = I;
+  }
+  return true;
+}
+
+class RSBuiltinFold : public llvm::FunctionPass {
+ private:
+  // Evaluate the call to @Builtin at compile time. Returns NULL unless all
+  // arguments are finite float constants and so are all results.
+  llvm::Constant *Evaluate(llvm::CallInst *CI, const FoldableBuiltin *Builtin) {
+    llvm::Type *Ty = CI->getType();
+    if (!Ty->getScalarType()->isFloatTy() ||
+        (CI->getNumArgOperands() != Builtin->NumArgs))
+      return NULL;
+
+    unsigned NumElements = 1;
+    if (llvm::VectorType *VT = llvm::dyn_cast<llvm::VectorType>(Ty))
+      NumElements = VT->getNumElements();
+
+    std::vector<llvm::Constant*> Results;
+    for (unsigned i = 0; i < NumElements; i++) {
+      float Args[3];
+      for (unsigned a = 0; a < Builtin->NumArgs; a++) {
+        llvm::Constant *C =
+            llvm::dyn_cast<llvm::Constant>(CI->getArgOperand(a));
+        if ((C == NULL) || !C->getType()->getScalarType()->isFloatTy())
+          return NULL;
+        llvm::ConstantFP *CFP =
+            llvm::dyn_cast_or_null<llvm::ConstantFP>(GetConstantElement(C, i));
+        if ((CFP == NULL) || CFP->getValueAPF().isNaN() ||
+            CFP->getValueAPF().isInfinity())
+          return NULL;
+        Args[a] = CFP->getValueAPF().convertToFloat();
+      }
+
+      llvm::APFloat Result(Builtin->Fn(Args));
+      if (Result.isNaN() || Result.isInfinity())
+        return NULL;
+      Results.push_back(llvm::ConstantFP::get(CI->getContext(), Result));
+    }
+
+    if (!Ty->isVectorTy())
+      return Results.front();
+    return llvm::ConstantVector::get(Results);
+  }
+
+  // Return the RS builtin @Name taking and returning @Ty (float or floatN),
+  // declaring it if necessary.
+  llvm::Value *GetUnaryBuiltin(llvm::Module *M, llvm::StringRef Name,
+                               llvm::Type *Ty) {
+    std::string Mangled = "_Z" + llvm::utostr(Name.size()) + Name.str();
+    if (llvm::VectorType *VT = llvm::dyn_cast<llvm::VectorType>(Ty))
+      Mangled += "Dv" + llvm::utostr(VT->getNumElements()) + "_f";
+    else
+      Mangled += "f";
+
+    llvm::FunctionType *FTy = llvm::FunctionType::get(Ty, Ty, false);
+    llvm::Constant *F = M->getOrInsertFunction(Mangled, FTy);
+    if (llvm::Function *Fn = llvm::dyn_cast<llvm::Function>(F)) {
+      Fn->setDoesNotAccessMemory();
+      Fn->setDoesNotThrow();
+    }
+    return F;
+  }
+
+  // Rewrite pow(x, c), powr(x, c) and pown(x, n) for exponents that have a
+  // cheaper exact equivalent. Returns NULL if there is none.
+  llvm::Value *SimplifyPow(llvm::CallInst *CI, llvm::StringRef Name) {
+    if ((CI->getNumArgOperands() != 2) ||
+        !CI->getType()->getScalarType()->isFloatTy())
+      return NULL;
+
+    llvm::Value *X = CI->getArgOperand(0);
+    double Y;
+    if (Name == "pown") {
+      int64_t N;
+      if (!GetSplatInt(CI->getArgOperand(1), N))
+        return NULL;
+      Y = N;
+    } else if (!GetSplatFloat(CI->getArgOperand(1), Y)) {
+      return NULL;
+    }
+
+    llvm::IRBuilder<> Builder(CI);
+    llvm::Type *Ty = CI->getType();
+
+    if (Y == 0.0)  // Even for x = NaN
+      return llvm::ConstantFP::get(Ty, 1.0);
+    if (Y == 1.0)
+      return X;
+    if (Y == 2.0)
+      return Builder.CreateFMul(X, X);
+    if (Y == -1.0)
+      return Builder.CreateFDiv(llvm::ConstantFP::get(Ty, 1.0), X);
+    if ((Y == 0.5) && (Name != "pown")) {
+      // pow(x, 0.5) = fabs(sqrt(x)), except that pow(-inf, 0.5) = inf
+      llvm::Module *M = CI->getParent()->getParent()->getParent();
+      llvm::Value *Sqrt =
+          Builder.CreateCall(GetUnaryBuiltin(M, "sqrt", Ty), X);
+      llvm::Value *Fabs =
+          Builder.CreateCall(GetUnaryBuiltin(M, "fabs", Ty), Sqrt);
+      llvm::Value *IsNegInf =
+          Builder.CreateFCmpOEQ(X, llvm::ConstantFP::get(Ty, -HUGE_VAL));
+      return Builder.CreateSelect(IsNegInf,
+                                  llvm::ConstantFP::get(Ty, HUGE_VAL), Fabs);
+    }
+
+    return NULL;
+  }
+
+  // Lower clamp(x, lo, hi) with constant bounds to compares and selects,
+  // which the code generator turns into min/max instructions.
+  llvm::Value *SimplifyClamp(llvm::CallInst *CI) {
+    if ((CI->getNumArgOperands() != 3) ||
+        !CI->getType()->getScalarType()->isFloatTy())
+      return NULL;
+
+    llvm::Type *Ty = CI->getType();
+    llvm::Value *Bounds[2];
+    for (unsigned i = 0; i < 2; i++) {
+      llvm::Constant *C = llvm::dyn_cast<llvm::Constant>(
+          CI->getArgOperand(i + 1));
+      if (C == NULL)
+        return NULL;
+      // Splat the scalar bounds of clamp(floatN, float, float)
+      if (Ty->isVectorTy() && !C->getType()->isVectorTy())
+        C = llvm::ConstantVector::get(std::vector<llvm::Constant*>(
+            llvm::cast<llvm::VectorType>(Ty)->getNumElements(), C));
+      Bounds[i] = C;
+    }
+
+    llvm::IRBuilder<> Builder(CI);
+    llvm::Value *X = CI->getArgOperand(0);
+    llvm::Value *Low = Builder.CreateSelect(
+        Builder.CreateFCmpOLT(X, Bounds[0]), Bounds[0], X);
+    return Builder.CreateSelect(
+        Builder.CreateFCmpOGT(Low, Bounds[1]), Bounds[1], Low);
+  }
+
+ public:
+  static char ID;
+
+  RSBuiltinFold() : llvm::FunctionPass(ID) {
+    return;
+  }
+
+  virtual bool runOnFunction(llvm::Function &F) {
+    std::vector<llvm::CallInst*> Worklist;
+
+    for (llvm::inst_iterator I = llvm::inst_begin(F), E = llvm::inst_end(F);
+         I != E;
+         I++) {
+      llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I);
+      if (CI && !GetRSBuiltinName(CI->getCalledFunction()).empty())
+        Worklist.push_back(CI);
+    }
+
+    bool Changed = false;
+    for (std::vector<llvm::CallInst*>::iterator I = Worklist.begin(),
+             E = Worklist.end();
+         I != E;
+         I++) {
+      llvm::CallInst *CI = *I;
+      llvm::StringRef Name = GetRSBuiltinName(CI->getCalledFunction());
+
+      llvm::Value *Replacement = NULL;
+      if (const FoldableBuiltin *Builtin = GetFoldableBuiltin(Name))
+        Replacement = Evaluate(CI, Builtin);
+      if ((Replacement == NULL) &&
+          ((Name == "pow") || (Name == "powr") || (Name == "pown")))
+        Replacement = SimplifyPow(CI, Name);
+      if ((Replacement == NULL) && (Name == "clamp"))
+        Replacement = SimplifyClamp(CI);
+
+      if (Replacement == NULL)
+        continue;
+
+      if (llvm::isa<llvm::Instruction>(Replacement) &&
+          !Replacement->hasName())
+        Replacement->takeName(CI);
+      CI->replaceAllUsesWith(Replacement);
+      CI->eraseFromParent();
+      Changed = true;
+    }
+
+    return Changed;
+  }
+};
+
+static void AddRelaxedFPPasses(const llvm::PassManagerBuilder &Builder,
+                               llvm::PassManagerBase &PM) {
+  PM.add(createRSRelaxedFDivPass());
+  return;
+}
+
+static void AddBuiltinFoldPasses(const llvm::PassManagerBuilder &Builder,
+                                 llvm::PassManagerBase &PM) {
+  PM.add(createRSBuiltinFoldPass());
+  return;
+}
+
+static void AddLoopHintPasses(const llvm::PassManagerBuilder &Builder,
+                              llvm::PassManagerBase &PM) {
+  PM.add(createRSLoopHintUnrollPass());
+  return;
+}
+
+}  // namespace
+
+char RSRelaxedFDiv::ID = 0;
+char RSLoopHintUnroll::ID = 0;
+char RSBuiltinFold::ID = 0;
+
+llvm::StringRef GetRSBuiltinName(const llvm::Function *F) {
+  if ((F == NULL) || !F->isDeclaration())
+    return llvm::StringRef();
+
+  llvm::StringRef Mangled = F->getName();
+  if (!Mangled.startswith("_Z"))
+    return llvm::StringRef();
+
+  Mangled = Mangled.substr(2);
+  size_t Digits = Mangled.find_first_not_of("0123456789");
+  unsigned Length;
+  if ((Digits == 0) || (Digits == llvm::StringRef::npos) ||
+      Mangled.substr(0, Digits).getAsInteger(10, Length) ||
+      (Digits + Length > Mangled.size()))
+    return llvm::StringRef();
+
+  llvm::StringRef Name = Mangled.substr(Digits, Length);
+  if (Name.startswith("native_"))
+    return Name.substr(7);
+  if (Name.startswith("half_"))
+    return Name.substr(5);
+  return Name;
+}
+
+llvm::FunctionPass *createRSRelaxedFDivPass() {
+  return new RSRelaxedFDiv();
+}
+
+llvm::Pass *createRSLoopHintUnrollPass() {
+  return new RSLoopHintUnroll();
+}
+
+llvm::FunctionPass *createRSBuiltinFoldPass() {
+  return new RSBuiltinFold();
+}
+
+void PopulateRSPassExtensions(llvm::PassManagerBuilder &PMBuilder,
+                              bool RelaxedFP,
+                              bool LoopHints) {
+  PMBuilder.addExtension(llvm::PassManagerBuilder::EP_ScalarOptimizerLate,
+                         AddBuiltinFoldPasses);
+  if (RelaxedFP)
+    PMBuilder.addExtension(llvm::PassManagerBuilder::EP_ScalarOptimizerLate,
+                           AddRelaxedFPPasses);
+  if (LoopHints)
+    PMBuilder.addExtension(llvm::PassManagerBuilder::EP_LoopOptimizerEnd,
+                           AddLoopHintPasses);
+  return;
+}
+
+}  // namespace slang
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_PASSES_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_PASSES_H_
+
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+  class Function;
+  class FunctionPass;
+  class Pass;
+  class PassManagerBuilder;
+}
+
+namespace slang {
+
+// Replace floating-point division by a constant with multiplication by its
+// reciprocal. This is not exact, so it is only used for scripts that declare
+// #pragma rs fp_relaxed or #pragma rs fp_imprecise.
+llvm::FunctionPass *createRSRelaxedFDivPass();
+
+// Unroll the loops carrying an unroll(N) hint in their RS_LOOP_HINT_MD
+// metadata (see RSLoopHints) by N.
+llvm::Pass *createRSLoopHintUnrollPass();
+
+// Fold calls to the RS math builtins whose arguments are all constant, and
+// replace pow(x, c) for c = 0, 1, 2, -1 and 0.5 (and likewise powr() and
+// pown()) by cheaper exact equivalents. Also lowers clamp() with constant
+// bounds to compares and selects.
+llvm::FunctionPass *createRSBuiltinFoldPass();
+
+// Have the optimization pipeline built by @PMBuilder run the builtin folding,
+// the reciprocal division if @RelaxedFP, and the hinted unrolling if
+// @LoopHints. Used by llvm-rs-cc, and by llvm-rs-link for scripts whose
+// optimization was left to it (-lto-only), which also runs the builtin
+// folding before linking in the libraries (see GetRSBuiltinName()).
+void PopulateRSPassExtensions(llvm::PassManagerBuilder &PMBuilder,
+                              bool RelaxedFP,
+                              bool LoopHints);
+
+// Return the source-level name of the RS builtin declared by @F ("pow" for
+// "_Z3powDv4_fS_"), without any native_ or half_ prefix, or an empty string
+// if @F is not a declaration of an overloaded (i.e. mangled) function.
+llvm::StringRef GetRSBuiltinName(const llvm::Function *F);
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_PASSES_H_  NOLINT
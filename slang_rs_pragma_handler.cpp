@@ -18,6 +18,7 @@
 
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "clang/Basic/TokenKinds.h"
 
@@ -25,8 +26,13 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/Token.h"
 
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/SmallString.h"
+
 #include "slang_assert.h"
 #include "slang_rs_context.h"
+#include "slang_rs_loop_hints.h"
 
 namespace slang {
 
@@ -158,6 +164,236 @@ class RSVersionPragmaHandler : public RSPragmaHandler {
   }
 };
 
+class RSFusePragmaHandler : public RSPragmaHandler {
+ private:
+  std::vector<std::string> mKernels;
+
+  void handleItem(const std::string &Item) {
+    mKernels.push_back(Item);
+  }
+
+ public:
+  RSFusePragmaHandler(llvm::StringRef Name, RSContext *Context)
+      : RSPragmaHandler(Name, Context) { return; }
+
+  void HandlePragma(clang::Preprocessor &PP,
+                    clang::PragmaIntroducerKind Introducer,
+                    clang::Token &FirstToken) {
+    clang::SourceLocation PragmaLoc = FirstToken.getLocation();
+    mKernels.clear();
+    this->handleItemListPragma(PP, FirstToken);
+
+    if (mKernels.size() != 2) {
+      clang::DiagnosticsEngine &DiagEngine = PP.getDiagnostics();
+      DiagEngine.Report(
+          PragmaLoc,
+          DiagEngine.getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                     "#pragma rs fuse expects exactly two "
+                                     "kernel names"));
+      return;
+    }
+
+    mContext->addPragma(this->getName(), mKernels[0] + "," + mKernels[1]);
+    mContext->addFusedKernels(mKernels[0], mKernels[1]);
+  }
+};
+
+class RSInPlacePragmaHandler : public RSPragmaHandler {
+ private:
+  void handleItem(const std::string &Item) {
+    mContext->addPragma(this->getName(), Item);
+    mContext->addInPlaceKernel(Item);
+  }
+
+ public:
+  RSInPlacePragmaHandler(llvm::StringRef Name, RSContext *Context)
+      : RSPragmaHandler(Name, Context) { return; }
+
+  void HandlePragma(clang::Preprocessor &PP,
+                    clang::PragmaIntroducerKind Introducer,
+                    clang::Token &FirstToken) {
+    this->handleItemListPragma(PP, FirstToken);
+  }
+};
+
+class RSFPPrecisionPragmaHandler : public RSPragmaHandler {
+ private:
+  bool mImprecise;
+
+ public:
+  RSFPPrecisionPragmaHandler(llvm::StringRef Name, RSContext *Context,
+                             bool Imprecise)
+      : RSPragmaHandler(Name, Context), mImprecise(Imprecise) { return; }
+
+  void HandlePragma(clang::Preprocessor &PP,
+                    clang::PragmaIntroducerKind Introducer,
+                    clang::Token &FirstToken) {
+    this->handleNonParamPragma(PP, FirstToken);
+    mContext->addPragma(this->getName(), "");
+    if (mImprecise)
+      mContext->setFPImprecise();
+    else
+      mContext->setFPRelaxed();
+  }
+};
+
+class RSLoopHintPragmaHandler : public RSPragmaHandler {
+ private:
+  RSLoopHints::Kind mKind;
+  clang::SourceLocation mLoc;
+  clang::Preprocessor *mPP;
+
+  void handleInt(const int v) {
+    if (v <= 0) {
+      clang::DiagnosticsEngine &DiagEngine = mPP->getDiagnostics();
+      DiagEngine.Report(
+          mLoc,
+          DiagEngine.getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                     "#pragma rs unroll expects a positive "
+                                     "count"));
+      return;
+    }
+    std::stringstream ss;
+    ss << v;
+    mContext->addPragma(this->getName(), ss.str());
+    mContext->getLoopHints().addHint(mKind, v, mLoc);
+  }
+
+ public:
+  RSLoopHintPragmaHandler(llvm::StringRef Name, RSContext *Context,
+                          RSLoopHints::Kind Kind)
+      : RSPragmaHandler(Name, Context), mKind(Kind), mPP(NULL) { return; }
+
+  void HandlePragma(clang::Preprocessor &PP,
+                    clang::PragmaIntroducerKind Introducer,
+                    clang::Token &FirstToken) {
+    mLoc = FirstToken.getLocation();
+    mPP = &PP;
+    if (mKind == RSLoopHints::LH_Unroll) {
+      this->handleIntegerParamPragma(PP, FirstToken);
+    } else {
+      this->handleNonParamPragma(PP, FirstToken);
+      mContext->addPragma(this->getName(), "");
+      mContext->getLoopHints().addHint(mKind, 0, mLoc);
+    }
+  }
+};
+
+class RSSpecializePragmaHandler : public RSPragmaHandler {
+ private:
+  void reportSyntaxError(clang::Preprocessor &PP, clang::Token &Tok) {
+    clang::DiagnosticsEngine &DiagEngine = PP.getDiagnostics();
+    DiagEngine.Report(
+        Tok.getLocation(),
+        DiagEngine.getCustomDiagID(clang::DiagnosticsEngine::Error,
+                                   "#pragma rs specialize expects a list of "
+                                   "'variable = value'"));
+    while (Tok.isNot(clang::tok::eod))
+      PP.LexUnexpandedToken(Tok);
+  }
+
+  // Parse the (optionally negated) literal at @Tok into @Value, normalizing
+  // numbers to plain decimal. Returns false on a syntax error.
+  bool lexValue(clang::Preprocessor &PP, clang::Token &Tok,
+                std::string &Value) {
+    std::string Sign;
+    if (Tok.is(clang::tok::minus)) {
+      Sign = "-";
+      PP.LexUnexpandedToken(Tok);
+    }
+
+    if (Tok.is(clang::tok::identifier) && Sign.empty()) {
+      // true or false, checked against the variable type later
+      Value = PP.getSpelling(Tok);
+      return true;
+    }
+
+    if (Tok.isNot(clang::tok::numeric_constant))
+      return false;
+
+    llvm::SmallString<64> Buffer;
+    bool Invalid = false;
+    llvm::StringRef Spelling = PP.getSpelling(Tok, Buffer, &Invalid);
+    if (Invalid)
+      return false;
+
+    clang::NumericLiteralParser NumericLiteral(Spelling.begin(),
+                                               Spelling.end(),
+                                               Tok.getLocation(),
+                                               PP);
+    if (NumericLiteral.hadError)
+      return false;
+
+    std::stringstream ss;
+    if (NumericLiteral.isFloatingLiteral()) {
+      llvm::APFloat Val(llvm::APFloat::IEEEdouble);
+      NumericLiteral.GetFloatValue(Val);
+      ss.precision(17);
+      ss << Sign << Val.convertToDouble();
+    } else {
+      llvm::APInt Val(64, 0);
+      if (NumericLiteral.GetIntegerValue(Val))
+        return false;  // Overflow
+      ss << Sign << Val.getZExtValue();
+    }
+    Value = ss.str();
+    return true;
+  }
+
+ public:
+  RSSpecializePragmaHandler(llvm::StringRef Name, RSContext *Context)
+      : RSPragmaHandler(Name, Context) { return; }
+
+  void HandlePragma(clang::Preprocessor &PP,
+                    clang::PragmaIntroducerKind Introducer,
+                    clang::Token &FirstToken) {
+    clang::Token &PragmaToken = FirstToken;
+
+    // Skip "specialize"
+    PP.LexUnexpandedToken(PragmaToken);
+    if (PragmaToken.isNot(clang::tok::l_paren)) {
+      reportSyntaxError(PP, PragmaToken);
+      return;
+    }
+
+    do {
+      PP.LexUnexpandedToken(PragmaToken);
+      if (PragmaToken.isNot(clang::tok::identifier)) {
+        reportSyntaxError(PP, PragmaToken);
+        return;
+      }
+      std::string Name = PP.getSpelling(PragmaToken);
+
+      PP.LexUnexpandedToken(PragmaToken);
+      if (PragmaToken.isNot(clang::tok::equal)) {
+        reportSyntaxError(PP, PragmaToken);
+        return;
+      }
+
+      std::string Value;
+      PP.LexUnexpandedToken(PragmaToken);
+      if (!lexValue(PP, PragmaToken, Value)) {
+        reportSyntaxError(PP, PragmaToken);
+        return;
+      }
+
+      mContext->addPragma(this->getName(), Name + "=" + Value);
+      mContext->addPragmaSpecialization(Name, Value);
+
+      PP.LexUnexpandedToken(PragmaToken);
+    } while (PragmaToken.is(clang::tok::comma));
+
+    if (PragmaToken.isNot(clang::tok::r_paren)) {
+      reportSyntaxError(PP, PragmaToken);
+      return;
+    }
+
+    do {
+      PP.LexUnexpandedToken(PragmaToken);
+    } while (PragmaToken.isNot(clang::tok::eod));
+  }
+};
+
 }  // namespace
 
 RSPragmaHandler *
@@ -180,6 +416,49 @@ RSPragmaHandler::CreatePragmaVersionHandler(RSContext *Context) {
   return new RSVersionPragmaHandler("version", Context);
 }
 
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaFuseHandler(RSContext *Context) {
+  return new RSFusePragmaHandler("fuse", Context);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaInPlaceHandler(RSContext *Context) {
+  return new RSInPlacePragmaHandler("inplace", Context);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaFPRelaxedHandler(RSContext *Context) {
+  return new RSFPPrecisionPragmaHandler("fp_relaxed", Context, false);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaFPImpreciseHandler(RSContext *Context) {
+  return new RSFPPrecisionPragmaHandler("fp_imprecise", Context, true);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaUnrollHandler(RSContext *Context) {
+  return new RSLoopHintPragmaHandler("unroll", Context,
+                                     RSLoopHints::LH_Unroll);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaNoUnrollHandler(RSContext *Context) {
+  return new RSLoopHintPragmaHandler("nounroll", Context,
+                                     RSLoopHints::LH_NoUnroll);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaVectorizeHandler(RSContext *Context) {
+  return new RSLoopHintPragmaHandler("vectorize", Context,
+                                     RSLoopHints::LH_Vectorize);
+}
+
+RSPragmaHandler *
+RSPragmaHandler::CreatePragmaSpecializeHandler(RSContext *Context) {
+  return new RSSpecializePragmaHandler("specialize", Context);
+}
+
 void RSPragmaHandler::handleItemListPragma(clang::Preprocessor &PP,
                                            clang::Token &FirstToken) {
   clang::Token &PragmaToken = FirstToken;
@@ -69,6 +69,14 @@ class RSPragmaHandler : public clang::PragmaHandler {
       RSContext *Context);
   static RSPragmaHandler *CreatePragmaReflectLicenseHandler(RSContext *Context);
   static RSPragmaHandler *CreatePragmaVersionHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaFuseHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaInPlaceHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaFPRelaxedHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaFPImpreciseHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaUnrollHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaNoUnrollHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaVectorizeHandler(RSContext *Context);
+  static RSPragmaHandler *CreatePragmaSpecializeHandler(RSContext *Context);
 
   virtual void HandlePragma(clang::Preprocessor &PP,
                             clang::PragmaIntroducerKind Introducer,
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_profile.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Function.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/Instructions.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Metadata.h"
+#include "llvm/Module.h"
+
+#include "llvm/Support/IRBuilder.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/system_error.h"
+
+#include "slang_rs_metadata.h"
+
+namespace slang {
+
+namespace {
+
+// Instruction metadata holding the branch weights that the optimizer and
+// code generator understand
+static const char *ProfMD = "prof";
+static const char *BranchWeights = "branch_weights";
+
+// Collect the conditional branches of @F, in the order of their blocks
+static void GetConditionalBranches(llvm::Function *F,
+                                   std::vector<llvm::BranchInst*> &Branches) {
+  for (llvm::Function::iterator BB = F->begin(), BE = F->end();
+       BB != BE;
+       BB++) {
+    llvm::BranchInst *BI = llvm::dyn_cast<llvm::BranchInst>(BB->getTerminator());
+    if ((BI != NULL) && BI->isConditional())
+      Branches.push_back(BI);
+  }
+  return;
+}
+
+static void IncrementCounter(llvm::IRBuilder<> &IB,
+                             llvm::GlobalVariable *Counters,
+                             unsigned Index,
+                             llvm::Value *Amount) {
+  llvm::Value *Counter = IB.CreateConstInBoundsGEP2_32(Counters, 0, Index);
+  IB.CreateStore(IB.CreateAdd(IB.CreateLoad(Counter), Amount), Counter);
+  return;
+}
+
+// Return the counts in @Weights if it is the branch weights of a two-way
+// branch
+static bool GetBranchWeights(const llvm::MDNode *Weights,
+                             uint64_t &Taken,
+                             uint64_t &NotTaken) {
+  if ((Weights == NULL) || (Weights->getNumOperands() != 3))
+    return false;
+
+  const llvm::MDString *Name =
+      llvm::dyn_cast<llvm::MDString>(Weights->getOperand(0));
+  const llvm::ConstantInt *T =
+      llvm::dyn_cast<llvm::ConstantInt>(Weights->getOperand(1));
+  const llvm::ConstantInt *NT =
+      llvm::dyn_cast<llvm::ConstantInt>(Weights->getOperand(2));
+  if ((Name == NULL) || (Name->getString() != BranchWeights) ||
+      (T == NULL) || (NT == NULL))
+    return false;
+
+  Taken = T->getZExtValue();
+  NotTaken = NT->getZExtValue();
+  return true;
+}
+
+}  // namespace
+
+void RSProfile::Instrument(llvm::Module *M) {
+  llvm::LLVMContext &C = M->getContext();
+  llvm::Type *Int64Ty = llvm::Type::getInt64Ty(C);
+
+  std::string Layout;
+  unsigned NumCounters = 0;
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    if (F->isDeclaration())
+      continue;
+    std::vector<llvm::BranchInst*> Branches;
+    GetConditionalBranches(F, Branches);
+    Layout.append("function " + F->getName().str() + " " +
+                  llvm::utostr_32(F->size()) + " " +
+                  llvm::utostr_32(Branches.size()) + "\n");
+    NumCounters += F->size() + Branches.size();
+  }
+
+  if (NumCounters == 0)
+    return;
+
+  llvm::ArrayType *CountersTy = llvm::ArrayType::get(Int64Ty, NumCounters);
+  llvm::GlobalVariable *Counters =
+      new llvm::GlobalVariable(*M, CountersTy, false,
+                               llvm::GlobalValue::ExternalLinkage,
+                               llvm::Constant::getNullValue(CountersTy),
+                               RS_PROFILE_COUNTERS_NAME);
+
+  llvm::Constant *LayoutInit = llvm::ConstantArray::get(C, Layout, true);
+  new llvm::GlobalVariable(*M, LayoutInit->getType(), true,
+                           llvm::GlobalValue::ExternalLinkage, LayoutInit,
+                           RS_PROFILE_LAYOUT_NAME);
+
+  // The counters of each function: one per block, then one per conditional
+  // branch (counting how often it goes to its first successor)
+  llvm::IRBuilder<> IB(C);
+  unsigned Index = 0;
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    if (F->isDeclaration())
+      continue;
+
+    std::vector<llvm::BranchInst*> Branches;
+    GetConditionalBranches(F, Branches);
+
+    for (llvm::Function::iterator BB = F->begin(), BE = F->end();
+         BB != BE;
+         BB++) {
+      // After the allocas of the entry block, which must stay together for
+      // the inliner to treat them as the callee's stack frame
+      llvm::BasicBlock::iterator I = BB->getFirstNonPHI();
+      while (llvm::isa<llvm::AllocaInst>(I))
+        I++;
+      IB.SetInsertPoint(I);
+      IncrementCounter(IB, Counters, Index++, IB.getInt64(1));
+    }
+
+    for (unsigned i = 0, e = Branches.size(); i != e; i++) {
+      IB.SetInsertPoint(Branches[i]);
+      IncrementCounter(IB, Counters, Index++,
+                       IB.CreateZExt(Branches[i]->getCondition(), Int64Ty));
+    }
+  }
+
+  return;
+}
+
+bool RSProfile::load(const std::string &File, std::string &Error) {
+  llvm::OwningPtr<llvm::MemoryBuffer> MB;
+  if (llvm::error_code EC = llvm::MemoryBuffer::getFile(File, MB)) {
+    Error = EC.message();
+    return false;
+  }
+
+  llvm::StringRef Buffer = MB->getBuffer();
+  unsigned LineNo = 0;
+  Counts *Expected = NULL;
+  size_t NumBlocks = 0, NumBranches = 0;
+
+  while (!Buffer.empty()) {
+    std::pair<llvm::StringRef, llvm::StringRef> Line = Buffer.split('\n');
+    Buffer = Line.second;
+    LineNo++;
+
+    llvm::SmallVector<llvm::StringRef, 16> Tokens;
+    llvm::SplitString(Line.first.split('#').first, Tokens);
+    if (Tokens.empty())
+      continue;
+
+    if (Expected == NULL) {
+      // function <name> <blocks> <branches>
+      if ((Tokens.size() != 4) || (Tokens[0] != "function") ||
+          Tokens[2].getAsInteger(10, NumBlocks) ||
+          Tokens[3].getAsInteger(10, NumBranches)) {
+        Error = "line " + llvm::utostr_32(LineNo) + ": expected 'function "
+                "<name> <blocks> <branches>'";
+        return false;
+      }
+      Expected = &mFunctions[Tokens[1].str()];
+      continue;
+    }
+
+    if (Tokens.size() != NumBlocks + NumBranches) {
+      Error = "line " + llvm::utostr_32(LineNo) + ": expected " +
+              llvm::utostr(NumBlocks + NumBranches) + " counts";
+      return false;
+    }
+
+    Expected->Blocks.clear();
+    Expected->Taken.clear();
+    for (size_t i = 0, e = Tokens.size(); i != e; i++) {
+      uint64_t Count;
+      if (Tokens[i].getAsInteger(10, Count)) {
+        Error = "line " + llvm::utostr_32(LineNo) + ": invalid count '" +
+                Tokens[i].str() + "'";
+        return false;
+      }
+      if (i < NumBlocks)
+        Expected->Blocks.push_back(Count);
+      else
+        Expected->Taken.push_back(Count);
+    }
+    Expected = NULL;
+  }
+
+  if (Expected != NULL) {
+    Error = "missing the counts of the last function";
+    return false;
+  }
+
+  return true;
+}
+
+void RSProfile::apply(llvm::Module *M,
+                      std::vector<std::string> &Mismatched) const {
+  llvm::LLVMContext &C = M->getContext();
+  llvm::Type *Int32Ty = llvm::Type::getInt32Ty(C);
+
+  // The functions with a matching profile, and the highest entry count
+  std::map<const llvm::Function*, const Counts*> Profiled;
+  uint64_t MaxEntry = 0;
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    if (F->isDeclaration())
+      continue;
+    std::map<std::string, Counts>::const_iterator P =
+        mFunctions.find(F->getName());
+    if (P == mFunctions.end())
+      continue;
+
+    std::vector<llvm::BranchInst*> Branches;
+    GetConditionalBranches(F, Branches);
+    if ((P->second.Blocks.size() != F->size()) ||
+        (P->second.Taken.size() != Branches.size())) {
+      Mismatched.push_back(F->getName());
+      continue;
+    }
+
+    Profiled[F] = &P->second;
+    MaxEntry = std::max(MaxEntry, P->second.Blocks.front());
+  }
+
+  for (std::map<const llvm::Function*, const Counts*>::const_iterator
+          I = Profiled.begin(), E = Profiled.end();
+       I != E;
+       I++) {
+    llvm::Function *F = const_cast<llvm::Function*>(I->first);
+    const Counts *P = I->second;
+
+    unsigned Block = 0, Branch = 0;
+    for (llvm::Function::iterator BB = F->begin(), BE = F->end();
+         BB != BE;
+         BB++, Block++) {
+      llvm::BranchInst *BI =
+          llvm::dyn_cast<llvm::BranchInst>(BB->getTerminator());
+      if ((BI == NULL) || !BI->isConditional())
+        continue;
+
+      uint64_t Total = P->Blocks[Block];
+      uint64_t Taken = P->Taken[Branch++];
+      if (Total == 0)
+        continue;  // Nothing is known about it
+      uint64_t NotTaken = (Total > Taken) ? (Total - Taken) : 0;
+      while ((Taken > 0xffffffffu) || (NotTaken > 0xffffffffu)) {
+        Taken >>= 1;
+        NotTaken >>= 1;
+      }
+
+      llvm::Value *Weights[] = {
+        llvm::MDString::get(C, BranchWeights),
+        llvm::ConstantInt::get(Int32Ty, Taken),
+        llvm::ConstantInt::get(Int32Ty, NotTaken)
+      };
+      BI->setMetadata(ProfMD, llvm::MDNode::get(C, Weights));
+    }
+
+    // Inline the functions that run about as often as the hottest kernel.
+    // Keep the ones that never ran out of line, but only if the profile
+    // covered a caller (a kernel that was never launched in the profiling
+    // run tells nothing).
+    uint64_t Entry = P->Blocks.front();
+    if (Entry > 0) {
+      if (Entry * 2 >= MaxEntry)
+        F->addFnAttr(llvm::Attribute::InlineHint);
+      continue;
+    }
+
+    for (llvm::Value::use_iterator UI = F->use_begin(), UE = F->use_end();
+         UI != UE;
+         UI++) {
+      llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(*UI);
+      if (CI == NULL)
+        continue;
+      std::map<const llvm::Function*, const Counts*>::const_iterator Caller =
+          Profiled.find(CI->getParent()->getParent());
+      if ((Caller != Profiled.end()) && (Caller->second->Blocks.front() > 0)) {
+        F->addFnAttr(llvm::Attribute::NoInline);
+        F->addFnAttr(llvm::Attribute::OptimizeForSize);
+        break;
+      }
+    }
+  }
+
+  return;
+}
+
+void RSProfile::LayoutColdBlocks(llvm::Module *M) {
+  for (llvm::Module::iterator F = M->begin(), FE = M->end(); F != FE; F++) {
+    if (F->isDeclaration())
+      continue;
+
+    std::vector<llvm::BasicBlock*> Cold;
+    for (llvm::Function::iterator BB = F->begin(), BE = F->end();
+         BB != BE;
+         BB++) {
+      llvm::BranchInst *BI =
+          llvm::dyn_cast<llvm::BranchInst>(BB->getTerminator());
+      uint64_t Taken, NotTaken;
+      if ((BI == NULL) || !BI->isConditional() ||
+          !GetBranchWeights(BI->getMetadata(ProfMD), Taken, NotTaken))
+        continue;
+
+      llvm::BasicBlock *Succ = NULL;
+      if ((Taken == 0) && (NotTaken > 0))
+        Succ = BI->getSuccessor(0);
+      else if ((NotTaken == 0) && (Taken > 0))
+        Succ = BI->getSuccessor(1);
+
+      // Only the blocks that nothing else leads to
+      if ((Succ != NULL) && (Succ->getSinglePredecessor() == BB))
+        Cold.push_back(Succ);
+    }
+
+    for (unsigned i = 0, e = Cold.size(); i != e; i++) {
+      if (Cold[i] != &F->back())
+        Cold[i]->moveAfter(&F->back());
+    }
+  }
+
+  return;
+}
+
+}  // namespace slang
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_PROFILE_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_PROFILE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+  class Module;
+}  // namespace llvm
+
+namespace slang {
+
+// Execution counts of the functions of a script, for profile-guided
+// optimization.
+//
+// Instrument() makes a script count how many times each basic block runs and
+// each conditional branch is taken, in the RS_PROFILE_COUNTERS_NAME global.
+// Whoever runs it (e.g. rs-host-bench) writes the counts out in this format,
+// with one header line per function as given by RS_PROFILE_LAYOUT_NAME:
+//
+//   # comment
+//   function <name> <number of blocks> <number of conditional branches>
+//   <count of each block> <taken count of each branch>
+//
+// Blocks and branches are numbered in the order of the unoptimized code, so
+// a profile only applies to the same script compiled with the same options.
+class RSProfile {
+ private:
+  struct Counts {
+    std::vector<uint64_t> Blocks;
+    std::vector<uint64_t> Taken;
+  };
+
+  std::map<std::string, Counts> mFunctions;
+
+ public:
+  // Add the counters to the functions defined in @M
+  static void Instrument(llvm::Module *M);
+
+  // Read the profile in @File. On failure, return false with the reason in
+  // @Error.
+  bool load(const std::string &File, std::string &Error);
+
+  inline bool empty() const { return mFunctions.empty(); }
+
+  // Annotate the functions of @M that have a profile: attach branch weights
+  // to their conditional branches, hint that the hottest ones be inlined, and
+  // keep the ones that never ran (although their callers did) out of line.
+  // The functions whose profile does not match their code are left alone
+  // and added to @Mismatched.
+  void apply(llvm::Module *M, std::vector<std::string> &Mismatched) const;
+
+  // Move the blocks that the branch weights say never run to the end of
+  // their functions, where they stay out of the way of the code that does
+  // (the code generator lays blocks out in this order). This runs after
+  // optimization (from HandleTranslationUnitLateOpt()), which does not
+  // preserve the order.
+  static void LayoutColdBlocks(llvm::Module *M);
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_PROFILE_H_  NOLINT
@@ -50,6 +50,7 @@
 
 #define RS_EXPORT_VAR_INDEX_PREFIX       "mExportVarIdx_"
 #define RS_EXPORT_VAR_PREFIX             "mExportVar_"
+#define RS_EXPORT_VAR_CONST_PREFIX       "const_"
 
 #define RS_EXPORT_FUNC_INDEX_PREFIX      "mExportFuncIdx_"
 #define RS_EXPORT_FOREACH_INDEX_PREFIX   "mExportForEachIdx_"
@@ -665,7 +666,7 @@ void RSReflection::genScriptClassConstructor(Context &C) {
        I != E;
        I++) {
     const RSExportVar *EV = *I;
-    if (!EV->getInit().isUninit())
+    if (!EV->getInit().isUninit() && !EV->isFoldedConst())
       genInitExportVariable(C, EV->getType(), EV->getName(), EV->getInit());
   }
 
@@ -720,6 +721,13 @@ void RSReflection::genInitPrimitiveExportVariable(
   slangAssert(!Val.isUninit() && "Not a valid initializer");
 
   C.indent() << RS_EXPORT_VAR_PREFIX << VarName << " = ";
+  genInitValue(C, Val);
+  C.out() << ";" << std::endl;
+
+  return;
+}
+
+void RSReflection::genInitValue(Context &C, const clang::APValue &Val) {
   switch (Val.getKind()) {
     case clang::APValue::Int: {
       llvm::APInt api = Val.getInt();
@@ -751,7 +759,6 @@ void RSReflection::genInitPrimitiveExportVariable(
       slangAssert(false && "Unknown kind of initializer");
     }
   }
-  C.out() << ";" << std::endl;
 
   return;
 }
@@ -861,6 +868,11 @@ void RSReflection::genInitExportVariable(Context &C,
 void RSReflection::genExportVariable(Context &C, const RSExportVar *EV) {
   const RSExportType *ET = EV->getType();
 
+  if (EV->isFoldedConst()) {
+    genFoldedConstExportVariable(C, EV);
+    return;
+  }
+
   C.indent() << "private final static int "RS_EXPORT_VAR_INDEX_PREFIX
              << EV->getName() << " = " << C.getNextExportVarSlot() << ";"
              << std::endl;
@@ -968,6 +980,18 @@ void RSReflection::genExportForEach(Context &C, const RSExportForEach *EF) {
     }
   }
 
+  if (EF->isSpecialized()) {
+    C.indent() << "// Same as forEach_" << EF->getSpecializedFrom()->getName()
+               << "(), but only valid while" << std::endl;
+    for (RSContext::const_specialization_iterator
+             I = mRSContext->specializations_begin(),
+             E = mRSContext->specializations_end();
+         I != E;
+         I++) {
+      C.indent() << "//   " << I->first << " == " << I->second << std::endl;
+    }
+  }
+
   C.startFunction(Context::AM_Public,
                   false,
                   "void",
@@ -1190,6 +1214,39 @@ void RSReflection::genPrimitiveTypeExportVariable(
   return;
 }
 
+// The value of a folded const variable is only known to the Java side, so
+// there is no slot to read it from.
+void RSReflection::genFoldedConstExportVariable(Context &C,
+                                                const RSExportVar *EV) {
+  slangAssert(EV->isFoldedConst() &&
+              (EV->getType()->getClass() == RSExportType::ExportClassPrimitive)
+              && "Variable should be a folded constant of primitive type here");
+
+  const RSExportPrimitiveType *EPT =
+      static_cast<const RSExportPrimitiveType*>(EV->getType());
+  const char *TypeName = GetPrimitiveTypeName(EPT);
+
+  C.indent() << "public final static " << TypeName << " "
+             RS_EXPORT_VAR_CONST_PREFIX << EV->getName() << " = ";
+  if (EPT->getType() == RSExportPrimitiveType::DataTypeBoolean)
+    C.out() << ((EV->getInit().getInt().getSExtValue() == 0) ? "false"
+                                                            : "true");
+  else
+    genInitValue(C, EV->getInit());
+  C.out() << ";" << std::endl;
+
+  C.startFunction(Context::AM_Public,
+                  false,
+                  TypeName,
+                  "get_" + EV->getName(),
+                  0);
+  C.indent() << "return "RS_EXPORT_VAR_CONST_PREFIX << EV->getName() << ";"
+             << std::endl;
+  C.endFunction();
+
+  return;
+}
+
 void RSReflection::genPointerTypeExportVariable(Context &C,
                                                 const RSExportVar *EV) {
   const RSExportType *ET = EV->getType();
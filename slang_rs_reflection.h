@@ -218,6 +218,7 @@ class RSReflection {
                       std::string &ErrorMsg);
   void genScriptClassConstructor(Context &C);
 
+  void genInitValue(Context &C, const clang::APValue &Val);
   void genInitBoolExportVariable(Context &C,
                                  const std::string &VarName,
                                  const clang::APValue &Val);
@@ -230,6 +231,7 @@ class RSReflection {
                              const clang::APValue &Val);
   void genExportVariable(Context &C, const RSExportVar *EV);
   void genPrimitiveTypeExportVariable(Context &C, const RSExportVar *EV);
+  void genFoldedConstExportVariable(Context &C, const RSExportVar *EV);
   void genPointerTypeExportVariable(Context &C, const RSExportVar *EV);
   void genVectorTypeExportVariable(Context &C, const RSExportVar *EV);
   void genMatrixTypeExportVariable(Context &C, const RSExportVar *EV);
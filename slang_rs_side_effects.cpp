@@ -0,0 +1,294 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "slang_rs_side_effects.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "llvm/Analysis/ValueTracking.h"
+
+#include "llvm/Constants.h"
+#include "llvm/Function.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/Instructions.h"
+#include "llvm/IntrinsicInst.h"
+#include "llvm/Module.h"
+
+#include "llvm/Support/InstIterator.h"
+
+#include "slang_rs_passes.h"
+
+namespace slang {
+
+namespace {
+
+// Prefixes of the runtime APIs whose effects are visible outside the calling
+// kernel
+static const char *SideEffectingRuntimeAPIs[] = {
+  "rsAllocationCopy",
+  "rsAllocationMarkDirty",
+  "rsAtomic",
+  "rsClearObject",
+  "rsDebug",
+  "rsForEach",
+  "rsSendToClient",
+  "rsSetElementAt",
+  "rsSetObject",
+  "rsg"
+};
+
+static bool IsSideEffectingRuntimeAPI(const llvm::Function *F) {
+  llvm::StringRef Name = GetRSBuiltinName(F);
+  if (Name.empty())
+    Name = F->getName();
+
+  for (size_t i = 0, e = sizeof(SideEffectingRuntimeAPIs) / sizeof(char*);
+       i != e;
+       i++) {
+    if (Name.startswith(SideEffectingRuntimeAPIs[i]))
+      return true;
+  }
+  return false;
+}
+
+// Return true if @Ptr points into a script global that is not constant, or
+// into an allocation bound to a global pointer.
+static bool IsGlobalMemory(const llvm::Value *Ptr) {
+  const llvm::Value *Base =
+      llvm::GetUnderlyingObject(const_cast<llvm::Value*>(Ptr));
+  if (const llvm::GlobalVariable *GV =
+          llvm::dyn_cast<llvm::GlobalVariable>(Base))
+    return !GV->isConstant();
+  if (const llvm::LoadInst *LI = llvm::dyn_cast<llvm::LoadInst>(Base))
+    return llvm::isa<llvm::GlobalVariable>(
+        llvm::GetUnderlyingObject(
+            const_cast<llvm::Value*>(LI->getPointerOperand())));
+  return false;
+}
+
+// Compute the effects of @F's own instructions, and collect the functions
+// defined in the module that it calls into @Callees.
+static unsigned GetLocalEffects(const llvm::Function *F,
+                                std::vector<const llvm::Function*> &Callees) {
+  unsigned Effects = RSSideEffects::SE_Pure;
+
+  for (llvm::const_inst_iterator I = llvm::inst_begin(F),
+           E = llvm::inst_end(F);
+       I != E;
+       I++) {
+    if (const llvm::LoadInst *LI = llvm::dyn_cast<llvm::LoadInst>(&*I)) {
+      if (IsGlobalMemory(LI->getPointerOperand()))
+        Effects |= RSSideEffects::SE_ReadsGlobals;
+    } else if (const llvm::StoreInst *SI =
+                   llvm::dyn_cast<llvm::StoreInst>(&*I)) {
+      if (IsGlobalMemory(SI->getPointerOperand()))
+        Effects |= RSSideEffects::SE_WritesGlobals;
+    } else if (const llvm::AtomicRMWInst *RMW =
+                   llvm::dyn_cast<llvm::AtomicRMWInst>(&*I)) {
+      if (IsGlobalMemory(RMW->getPointerOperand()))
+        Effects |= RSSideEffects::SE_ReadsGlobals |
+                   RSSideEffects::SE_WritesGlobals;
+    } else if (const llvm::AtomicCmpXchgInst *CX =
+                   llvm::dyn_cast<llvm::AtomicCmpXchgInst>(&*I)) {
+      if (IsGlobalMemory(CX->getPointerOperand()))
+        Effects |= RSSideEffects::SE_ReadsGlobals |
+                   RSSideEffects::SE_WritesGlobals;
+    } else if (const llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(&*I)) {
+      const llvm::Function *Callee = CI->getCalledFunction();
+      if (Callee == NULL) {
+        Effects |= RSSideEffects::SE_Unknown;
+        continue;
+      }
+
+      if (!Callee->isDeclaration()) {
+        Callees.push_back(Callee);
+        continue;
+      }
+
+      if (llvm::isa<llvm::DbgInfoIntrinsic>(CI))
+        continue;
+
+      if (IsSideEffectingRuntimeAPI(Callee))
+        Effects |= RSSideEffects::SE_CallsRuntime;
+
+      // Runtime functions (and memcpy/memset) handed a pointer into global
+      // memory may access it
+      for (unsigned i = 0, e = CI->getNumArgOperands(); i != e; i++) {
+        const llvm::Value *Arg = CI->getArgOperand(i);
+        if (!Arg->getType()->isPointerTy() || !IsGlobalMemory(Arg))
+          continue;
+        Effects |= RSSideEffects::SE_ReadsGlobals;
+        if (!Callee->onlyReadsMemory())
+          Effects |= RSSideEffects::SE_WritesGlobals;
+      }
+    }
+  }
+
+  return Effects;
+}
+
+}  // namespace
+
+RSSideEffects::RSSideEffects(llvm::Module *M) {
+  std::map<const llvm::Function*, std::vector<const llvm::Function*> > Callees;
+
+  for (llvm::Module::const_iterator F = M->begin(), E = M->end();
+       F != E;
+       F++) {
+    if (F->isDeclaration())
+      continue;
+    mEffects[F] = GetLocalEffects(F, Callees[F]);
+  }
+
+  // Propagate the effects of the callees up the call graph until nothing
+  // changes (the effects only ever grow, so this terminates)
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (std::map<const llvm::Function*, unsigned>::iterator
+             I = mEffects.begin(), E = mEffects.end();
+         I != E;
+         I++) {
+      unsigned Effects = I->second;
+      const std::vector<const llvm::Function*> &FCallees = Callees[I->first];
+      for (unsigned i = 0, e = FCallees.size(); i != e; i++)
+        Effects |= mEffects[FCallees[i]];
+      if (Effects != I->second) {
+        I->second = Effects;
+        Changed = true;
+      }
+    }
+  }
+
+  return;
+}
+
+unsigned RSSideEffects::get(const llvm::Function *F) const {
+  std::map<const llvm::Function*, unsigned>::const_iterator I =
+      mEffects.find(F);
+  if (I == mEffects.end())
+    return SE_Unknown;
+  return I->second;
+}
+
+bool RSSideEffects::GetWriters(const llvm::GlobalVariable *GV,
+                               std::set<const llvm::Function*> &Writers) {
+  std::vector<const llvm::Value*> Worklist;
+  Worklist.push_back(GV);
+
+  while (!Worklist.empty()) {
+    const llvm::Value *Ptr = Worklist.back();
+    Worklist.pop_back();
+
+    for (llvm::Value::const_use_iterator UI = Ptr->use_begin(),
+             UE = Ptr->use_end();
+         UI != UE;
+         UI++) {
+      const llvm::User *U = *UI;
+
+      if (const llvm::ConstantExpr *CE =
+              llvm::dyn_cast<llvm::ConstantExpr>(U)) {
+        if ((CE->getOpcode() != llvm::Instruction::GetElementPtr) &&
+            (CE->getOpcode() != llvm::Instruction::BitCast))
+          return false;
+        Worklist.push_back(CE);
+        continue;
+      }
+
+      const llvm::Instruction *I = llvm::dyn_cast<llvm::Instruction>(U);
+      if (I == NULL)
+        continue;  // E.g. the initializer of another global
+
+      if (llvm::isa<llvm::GetElementPtrInst>(I) ||
+          llvm::isa<llvm::BitCastInst>(I)) {
+        Worklist.push_back(I);
+      } else if (llvm::isa<llvm::LoadInst>(I) ||
+                 llvm::isa<llvm::DbgInfoIntrinsic>(I)) {
+        continue;
+      } else if (const llvm::StoreInst *SI =
+                     llvm::dyn_cast<llvm::StoreInst>(I)) {
+        if (SI->getValueOperand() == Ptr)
+          return false;  // The address itself is stored away
+        Writers.insert(I->getParent()->getParent());
+      } else if (const llvm::MemTransferInst *MTI =
+                     llvm::dyn_cast<llvm::MemTransferInst>(I)) {
+        if (MTI->getRawDest() == Ptr)
+          Writers.insert(I->getParent()->getParent());
+      } else if (const llvm::CallInst *CI = llvm::dyn_cast<llvm::CallInst>(I)) {
+        const llvm::Function *Callee = CI->getCalledFunction();
+        if (Callee && Callee->onlyReadsMemory())
+          continue;
+        // Passing a copy (byval) cannot modify the original
+        bool ByValOnly = true;
+        for (unsigned i = 0, e = CI->getNumArgOperands(); i != e; i++) {
+          if ((CI->getArgOperand(i) == Ptr) &&
+              !CI->paramHasAttr(i + 1, llvm::Attribute::ByVal))
+            ByValOnly = false;
+        }
+        if (!ByValOnly)
+          Writers.insert(I->getParent()->getParent());
+      } else {
+        // PHIs, selects, ptrtoint, ...
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool RSSideEffects::IsRead(const llvm::GlobalVariable *GV) {
+  std::vector<const llvm::Value*> Worklist;
+  Worklist.push_back(GV);
+
+  while (!Worklist.empty()) {
+    const llvm::Value *Ptr = Worklist.back();
+    Worklist.pop_back();
+
+    for (llvm::Value::const_use_iterator UI = Ptr->use_begin(),
+             UE = Ptr->use_end();
+         UI != UE;
+         UI++) {
+      const llvm::User *U = *UI;
+
+      if (llvm::isa<llvm::ConstantExpr>(U) ||
+          llvm::isa<llvm::GetElementPtrInst>(U) ||
+          llvm::isa<llvm::BitCastInst>(U)) {
+        Worklist.push_back(U);
+      } else if (const llvm::StoreInst *SI =
+                     llvm::dyn_cast<llvm::StoreInst>(U)) {
+        if (SI->getValueOperand() == Ptr)
+          return true;  // The address escapes
+      } else if (const llvm::MemIntrinsic *MI =
+                     llvm::dyn_cast<llvm::MemIntrinsic>(U)) {
+        if (MI->getRawDest() != Ptr)
+          return true;  // Copied from
+      } else if (llvm::isa<llvm::DbgInfoIntrinsic>(U)) {
+        continue;
+      } else if (llvm::isa<llvm::Instruction>(U)) {
+        return true;  // Loads, calls, PHIs, ...
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace slang
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_SIDE_EFFECTS_H_  // NOLINT
+#define _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_SIDE_EFFECTS_H_
+
+#include <map>
+#include <set>
+
+namespace llvm {
+  class Function;
+  class GlobalVariable;
+  class Module;
+}  // namespace llvm
+
+namespace slang {
+
+// Interprocedural summary of the effects each function in a module has
+// outside its own stack frame and arguments: whether it reads or writes
+// script globals (including allocations bound to global pointers), and
+// whether it calls runtime APIs with side effects (rsSendToClient(),
+// rsForEach(), rsDebug(), the rsg* graphics functions, ...). A kernel with
+// none of these (SE_Pure) may be split across threads in any way.
+class RSSideEffects {
+ public:
+  enum Effect {
+    SE_Pure           = 0,
+    SE_ReadsGlobals   = 0x01,
+    SE_WritesGlobals  = 0x02,
+    SE_CallsRuntime   = 0x04,
+    SE_Unknown        = 0x07
+  };
+
+ private:
+  // Bitmask of Effects for each function defined in the module
+  std::map<const llvm::Function*, unsigned> mEffects;
+
+ public:
+  explicit RSSideEffects(llvm::Module *M);
+
+  // Bitmask of Effects for @F (SE_Unknown if @F is not defined in the module)
+  unsigned get(const llvm::Function *F) const;
+
+  // Collect the functions that write @GV: through a pointer derived from its
+  // address, or by passing that address to a function that may write to
+  // it. Return false if the address escapes some other way, so the writers
+  // cannot be known.
+  static bool GetWriters(const llvm::GlobalVariable *GV,
+                         std::set<const llvm::Function*> &Writers);
+
+  // Return true if some function may read @GV (conservatively, if its
+  // address escapes).
+  static bool IsRead(const llvm::GlobalVariable *GV);
+};
+
+}  // namespace slang
+
+#endif  // _FRAMEWORKS_COMPILE_SLANG_SLANG_RS_SIDE_EFFECTS_H_  NOLINT
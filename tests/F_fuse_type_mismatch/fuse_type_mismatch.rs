@@ -0,0 +1,11 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs fuse(first, second)
+
+void first(const float *in, float *out) {
+  *out = *in;
+}
+
+void second(const int *in, int *out) {
+  *out = in[1];
+}
@@ -0,0 +1,8 @@
+// -instrument
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+void root(const int *in, int *out) {
+  *out = *in;
+  RS_REGION_END(copy);
+}
@@ -0,0 +1,13 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+float f;
+
+void foo() {
+#pragma rs unroll(0)
+  for (int i = 0; i < 4; i++) {
+    f += i;
+  }
+#pragma rs unroll(2)
+  f = 0.f;
+}
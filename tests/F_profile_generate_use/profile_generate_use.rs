@@ -0,0 +1,7 @@
+// -profile-generate -profile-use profile_generate_use.prof
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+void root(const int *in, int *out) {
+  *out = *in;
+}
@@ -0,0 +1,7 @@
+// -profile-use profile_malformed.prof
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+void root(const int *in, int *out) {
+  *out = *in;
+}
@@ -0,0 +1,10 @@
+// -target-api 11
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs specialize(level = 128)
+
+uchar level;
+
+void root(const uchar *in, uchar *out) {
+  *out = *in > level ? 255 : 0;
+}
@@ -0,0 +1,9 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs specialize(level = 300)
+
+uchar level;
+
+void root(const uchar *in, uchar *out) {
+  *out = *in > level ? 255 : 0;
+}
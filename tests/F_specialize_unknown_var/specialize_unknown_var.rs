@@ -0,0 +1,9 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs specialize(radius = 2)
+
+static int radius = 1;
+
+void root(const int *in, int *out) {
+  *out = in[radius];
+}
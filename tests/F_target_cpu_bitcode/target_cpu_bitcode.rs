@@ -0,0 +1,7 @@
+// -target-cpu cortex-a9
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+void root(const int *in, int *out) {
+    *out = *in;
+}
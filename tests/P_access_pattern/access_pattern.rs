@@ -0,0 +1,12 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+rs_allocation gSrc;
+
+void root(const uchar4 *in, uchar4 *out, const void *usrData,
+          uint32_t x, uint32_t y) {
+  const uchar4 *transposed = (const uchar4 *) rsGetElementAt(gSrc, y, x);
+  const uchar4 *even = (const uchar4 *) rsGetElementAt(gSrc, x * 2, y);
+  const uchar4 *left = (const uchar4 *) rsGetElementAt(gSrc, x - 1, y);
+  *out = *in + *transposed + *even + *left;
+}
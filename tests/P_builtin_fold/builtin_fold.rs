@@ -0,0 +1,66 @@
+// -opt-remarks
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+float r00, r01, r02, r03, r04, r05, r06, r07, r08, r09;
+float r10, r11, r12, r13, r14, r15, r16, r17, r18, r19;
+float r20, r21, r22, r23, r24, r25, r26, r27, r28, r29;
+float r30, r31, r32, r33, r34, r35, r36, r37;
+
+void root(const float *in, float *out) {
+  float x = *in;
+  // Rewritten to cheaper equivalents, or lowered to compares and selects
+  float p0 = pow(x, 2.0f);
+  float p1 = pow(x, 0.5f);
+  float p2 = pow(x, 1.0f);
+  float p3 = pow(x, -1.0f);
+  float p4 = powr(x, 0.0f);
+  float p5 = pown(x, 2);
+  float p6 = clamp(x, 0.0f, 1.0f);
+  // Not rewritten
+  float p7 = pow(x, 3.0f);
+  *out = p0 + p1 + p2 + p3 + p4 + p5 + p6 + p7;
+}
+
+void folds() {
+  // Every builtin the pass evaluates
+  r00 = acos(0.5f);
+  r01 = asin(0.5f);
+  r02 = atan(1.0f);
+  r03 = atan2(1.0f, 2.0f);
+  r04 = cbrt(27.0f);
+  r05 = ceil(1.5f);
+  r06 = clamp(2.0f, 0.0f, 1.0f);
+  r07 = cos(1.0f);
+  r08 = cosh(1.0f);
+  r09 = exp(2.0f);
+  r10 = exp2(3.0f);
+  r11 = exp10(2.0f);
+  r12 = fabs(-1.0f);
+  r13 = floor(1.5f);
+  r14 = fmax(1.0f, 2.0f);
+  r15 = fmin(1.0f, 2.0f);
+  r16 = fmod(5.0f, 3.0f);
+  r17 = hypot(3.0f, 4.0f);
+  r18 = log(3.0f);
+  r19 = log2(8.0f);
+  r20 = log10(100.0f);
+  r21 = mad(2.0f, 3.0f, 4.0f);
+  r22 = mix(0.0f, 1.0f, 0.25f);
+  r23 = pow(2.0f, 10.0f);
+  r24 = powr(2.0f, 3.0f);
+  r25 = rsqrt(4.0f);
+  r26 = sin(1.0f);
+  r27 = sinh(1.0f);
+  r28 = sqrt(2.0f);
+  r29 = tan(0.5f);
+  r30 = tanh(0.5f);
+  // Results that are not finite, and operands that are NaN or infinite
+  r31 = log(0.0f);
+  r32 = sqrt(-1.0f);
+  r33 = exp(100.0f);
+  r34 = fmod(1.0f, 0.0f);
+  r35 = fabs(0.0f / 0.0f);
+  r36 = exp2(1.0f / 0.0f);
+  r37 = fmin(-1.0f / 0.0f, 1.0f);
+}
@@ -0,0 +1,7 @@
+// -print-code-report -emit-bc
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+void root(const int *in, int *out) {
+  *out = *in;
+}
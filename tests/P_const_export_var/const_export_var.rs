@@ -0,0 +1,19 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+const int kRadius = 3;
+const float kScale = 0.25f;
+const bool kClamp = true;
+int count;
+
+void root(const float *in, float *out) {
+  float sum = 0.f;
+  for (int i = -kRadius; i <= kRadius; i++) {
+    sum += in[i];
+  }
+  sum *= kScale;
+  if (kClamp && sum > 1.f) {
+    sum = 1.f;
+  }
+  *out = sum + count;
+}
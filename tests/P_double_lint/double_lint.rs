@@ -0,0 +1,19 @@
+// -Wrs-double
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+double weight;
+
+static float half(float v) {
+  return v * 0.5;
+}
+
+static float unused(float v) {
+  return v * 0.25;
+}
+
+void root(const float *in, float *out) {
+  *out = half(*in) + 1.0;
+  *out *= 2.0;
+  *out += *in * weight;
+}
@@ -0,0 +1,7 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs fp_relaxed
+
+void root(const float4 *in, float4 *out) {
+  *out = *in / 3.0f + 0.5f;
+}
@@ -0,0 +1,15 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs fuse(brighten, invert)
+
+void brighten(const uchar4 *in, uchar4 *out, uint32_t x, uint32_t y) {
+  *out = *in;
+  out->r = in->r / 2 + 128;
+}
+
+void invert(const uchar4 *in, uchar4 *out) {
+  out->r = 255 - in[0].r;
+  out->g = 255 - in->g;
+  out->b = 255 - (*in).b;
+  out->a = in->a;
+}
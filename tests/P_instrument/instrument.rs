@@ -0,0 +1,19 @@
+// -instrument
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+int radius;
+
+void root(const float *in, float *out, uint32_t x) {
+  float sum = 0.f;
+  RS_REGION_BEGIN(blur);
+  for (int i = 0; i < radius; i++) {
+    sum += in[i];
+  }
+  RS_REGION_END(blur);
+  *out = sum;
+}
+
+void reset() {
+  radius = 0;
+}
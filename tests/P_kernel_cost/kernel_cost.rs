@@ -0,0 +1,7 @@
+// -print-kernel-cost
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+void root(const float *in, float *out) {
+  *out = *in * 2.f;
+}
@@ -0,0 +1,14 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+float gain;
+int count;
+
+static void tally() {
+  count++;
+}
+
+void root(const float *in, float *out) {
+  *out = *in * gain;
+  tally();
+}
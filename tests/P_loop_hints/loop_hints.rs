@@ -0,0 +1,26 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+float weights[9];
+
+void root(const float *in, float *out, uint32_t x) {
+  float sum = 0.f;
+#pragma rs unroll(9)
+  for (int i = 0; i < 9; i++) {
+    sum += in[i] * weights[i];
+  }
+  *out = sum;
+}
+
+void scale(float f) {
+  int i = 0;
+#pragma rs nounroll
+  while (i < 9) {
+    int j = 0;
+#pragma rs vectorize
+    do {
+      weights[i] *= f;
+    } while (++j < 1);
+    i++;
+  }
+}
@@ -0,0 +1,15 @@
+// -opt-remarks
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+static float twice(float f) {
+  return f * 2.f;
+}
+
+void root(const float *in, float *out) {
+  float sum = 0.f;
+  for (int i = 0; i < 4; i++) {
+    sum += in[i];
+  }
+  *out = twice(sum);
+}
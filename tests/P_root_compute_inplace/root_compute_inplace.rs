@@ -0,0 +1,7 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs inplace(root)
+
+void root(const float4 *in, float4 *out, uint32_t x) {
+  *out = *in * 0.5f;
+}
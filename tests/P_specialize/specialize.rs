@@ -0,0 +1,19 @@
+#pragma version(1)
+#pragma rs java_package_name(foo)
+#pragma rs specialize(radius = 2, scale = 0.5f, enabled = true)
+
+int radius = 1;
+float scale = 1.0f;
+bool enabled;
+
+static float weight(int i) {
+  return enabled ? scale / (float)(i + 1) : scale;
+}
+
+void root(const float *in, float *out) {
+  float sum = 0.f;
+  for (int i = -radius; i <= radius; i++) {
+    sum += in[i] * weight(i + radius);
+  }
+  *out = sum;
+}
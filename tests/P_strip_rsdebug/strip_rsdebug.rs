@@ -0,0 +1,11 @@
+// -strip-rsdebug
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+float gain;
+
+void root(const float *in, float *out) {
+  float scaled = *in * gain;
+  rsDebug("scaled", scaled);
+  *out = scaled;
+}
@@ -0,0 +1,18 @@
+// -java-usage-file java_usage.txt -strip-unused-exports
+#pragma version(1)
+#pragma rs java_package_name(foo)
+
+float gain;
+int debugLevel;
+int unused;
+
+void root(const float *in, float *out) {
+  *out = *in * gain;
+}
+
+void reset() {
+  gain = 1.0f;
+}
+
+void dump() {
+}
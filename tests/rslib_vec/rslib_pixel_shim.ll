@@ -0,0 +1,74 @@
+; The x86-64 C ABI passes 4-byte vectors in integer registers, while the
+; RenderScript targets pass uchar4 as <4 x i8> directly. These wrappers give
+; rslib_pixel_test.c an i32-based interface to the uchar4 functions.
+
+declare zeroext i16 @_Z16rsPackColorTo565Dv4_h(<4 x i8>)
+declare <4 x i8> @_Z16rsUnpackColor565t(i16 zeroext)
+declare zeroext i16 @_Z17rsPackColorTo5551Dv4_h(<4 x i8>)
+declare <4 x i8> @_Z17rsUnpackColor5551t(i16 zeroext)
+declare zeroext i16 @_Z17rsPackColorTo4444Dv4_h(<4 x i8>)
+declare <4 x i8> @_Z17rsUnpackColor4444t(i16 zeroext)
+declare <4 x float> @_Z16rsNormalizeColorDv4_h(<4 x i8>)
+declare <4 x i8> @_Z18rsDenormalizeColorDv4_f(<4 x float>)
+declare zeroext i8 @_Z14rsPackColorToLDv4_h(<4 x i8>)
+declare <4 x i8> @_Z14rsUnpackColorLh(i8 zeroext)
+
+define zeroext i16 @shim_pack565(i32 %c) {
+  %v = bitcast i32 %c to <4 x i8>
+  %r = call zeroext i16 @_Z16rsPackColorTo565Dv4_h(<4 x i8> %v)
+  ret i16 %r
+}
+
+define i32 @shim_unpack565(i16 zeroext %p) {
+  %v = call <4 x i8> @_Z16rsUnpackColor565t(i16 zeroext %p)
+  %r = bitcast <4 x i8> %v to i32
+  ret i32 %r
+}
+
+define zeroext i16 @shim_pack5551(i32 %c) {
+  %v = bitcast i32 %c to <4 x i8>
+  %r = call zeroext i16 @_Z17rsPackColorTo5551Dv4_h(<4 x i8> %v)
+  ret i16 %r
+}
+
+define i32 @shim_unpack5551(i16 zeroext %p) {
+  %v = call <4 x i8> @_Z17rsUnpackColor5551t(i16 zeroext %p)
+  %r = bitcast <4 x i8> %v to i32
+  ret i32 %r
+}
+
+define zeroext i16 @shim_pack4444(i32 %c) {
+  %v = bitcast i32 %c to <4 x i8>
+  %r = call zeroext i16 @_Z17rsPackColorTo4444Dv4_h(<4 x i8> %v)
+  ret i16 %r
+}
+
+define i32 @shim_unpack4444(i16 zeroext %p) {
+  %v = call <4 x i8> @_Z17rsUnpackColor4444t(i16 zeroext %p)
+  %r = bitcast <4 x i8> %v to i32
+  ret i32 %r
+}
+
+define <4 x float> @shim_normalize(i32 %c) {
+  %v = bitcast i32 %c to <4 x i8>
+  %r = call <4 x float> @_Z16rsNormalizeColorDv4_h(<4 x i8> %v)
+  ret <4 x float> %r
+}
+
+define i32 @shim_denormalize(<4 x float> %f) {
+  %v = call <4 x i8> @_Z18rsDenormalizeColorDv4_f(<4 x float> %f)
+  %r = bitcast <4 x i8> %v to i32
+  ret i32 %r
+}
+
+define zeroext i8 @shim_packL(i32 %c) {
+  %v = bitcast i32 %c to <4 x i8>
+  %r = call zeroext i8 @_Z14rsPackColorToLDv4_h(<4 x i8> %v)
+  ret i8 %r
+}
+
+define i32 @shim_unpackL(i8 zeroext %l) {
+  %v = call <4 x i8> @_Z14rsUnpackColorLh(i8 zeroext %l)
+  %r = bitcast <4 x i8> %v to i32
+  ret i32 %r
+}
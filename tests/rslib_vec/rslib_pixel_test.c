@@ -0,0 +1,136 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host-side check of the pixel format conversions in rslib_vec.ll against
+// straightforward scalar versions. Every packed value is unpacked, and all
+// RGB combinations are packed (with a few alpha values); the results must
+// match bit for bit. uchar4 values cross the C boundary as uint32_t through
+// the wrappers in rslib_pixel_shim.ll.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t uchar4 __attribute__((vector_size(4)));
+typedef float float4 __attribute__((vector_size(16)));
+
+extern uint16_t shim_pack565(uchar4);
+extern uchar4 shim_unpack565(uint16_t);
+extern uint16_t shim_pack5551(uchar4);
+extern uchar4 shim_unpack5551(uint16_t);
+extern uint16_t shim_pack4444(uchar4);
+extern uchar4 shim_unpack4444(uint16_t);
+extern float4 shim_normalize(uchar4);
+extern uchar4 shim_denormalize(float4);
+extern uint8_t shim_packL(uchar4);
+extern uchar4 shim_unpackL(uint8_t);
+
+
+static int failures = 0;
+
+#define EXPECT(name, cond, fmt, ...)                                \
+  do {                                                              \
+    if (!(cond)) {                                                  \
+      if (failures++ < 10) {                                        \
+        printf("%s mismatch: " fmt "\n", name, __VA_ARGS__);        \
+      }                                                             \
+    }                                                               \
+  } while (0)
+
+static int Same(uchar4 a, const uint8_t *b) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+static uint8_t Widen(unsigned v, unsigned bits) {
+  return (uint8_t) ((v << (8 - bits)) | (v >> (2 * bits - 8)));
+}
+
+static void CheckUnpack() {
+  for (unsigned p = 0; p < 65536; p++) {
+    uint8_t e565[4] = {Widen(p >> 11, 5), Widen((p >> 5) & 63, 6),
+                       Widen(p & 31, 5), 255};
+    uint8_t e5551[4] = {Widen(p >> 11, 5), Widen((p >> 6) & 31, 5),
+                        Widen((p >> 1) & 31, 5), (p & 1) ? 255 : 0};
+    uint8_t e4444[4] = {(p >> 12) * 17, ((p >> 8) & 15) * 17,
+                        ((p >> 4) & 15) * 17, (p & 15) * 17};
+    EXPECT("unpack565", Same(shim_unpack565(p), e565), "%04x", p);
+    EXPECT("unpack5551", Same(shim_unpack5551(p), e5551), "%04x", p);
+    EXPECT("unpack4444", Same(shim_unpack4444(p), e4444), "%04x", p);
+  }
+  for (unsigned l = 0; l < 256; l++) {
+    uint8_t e[4] = {l, l, l, 255};
+    EXPECT("unpackL", Same(shim_unpackL(l), e), "%02x", l);
+  }
+}
+
+static void CheckPack() {
+  static const uint8_t alphas[] = {0, 127, 128, 255};
+  for (unsigned rgb = 0; rgb < (1 << 24); rgb++) {
+    unsigned r = rgb >> 16, g = (rgb >> 8) & 255, b = rgb & 255;
+    unsigned a = alphas[rgb & 3];
+    uchar4 c = {r, g, b, a};
+    unsigned e565 = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    unsigned e5551 = ((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) |
+                     (a >> 7);
+    unsigned e4444 = ((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) |
+                     (a >> 4);
+    unsigned eL = (77 * r + 150 * g + 29 * b + 128) >> 8;
+    EXPECT("pack565", shim_pack565(c) == e565, "%06x", rgb);
+    EXPECT("pack5551", shim_pack5551(c) == e5551, "%06x", rgb);
+    EXPECT("pack4444", shim_pack4444(c) == e4444, "%06x", rgb);
+    EXPECT("packL", shim_packL(c) == eL, "%06x", rgb);
+  }
+}
+
+static uint8_t RefDenormalize(float f) {
+  f = (f > 0.0f) ? f : 0.0f;
+  f = (f > 1.0f) ? 1.0f : f;
+  return (uint8_t) (f * 255.0f + 0.5f);
+}
+
+static void CheckNormalize() {
+  for (unsigned v = 0; v < 256; v++) {
+    uchar4 c = {v, 255 - v, v / 2, 255};
+    float4 f = shim_normalize(c);
+    for (int i = 0; i < 4; i++) {
+      float e = (float) c[i] * (1.0f / 255.0f);
+      EXPECT("normalize", memcmp(&f[i], &e, sizeof(e)) == 0, "%u", c[i]);
+    }
+    uchar4 back = shim_denormalize(f);
+    EXPECT("round trip", Same(back, (const uint8_t *) &c), "%u", v);
+  }
+  for (int i = -1000; i <= 2000; i++) {
+    float x = i / 1000.0f;
+    float4 f = {x, -x, x * 0.5f, x + 0.25f};
+    uchar4 c = shim_denormalize(f);
+    for (int j = 0; j < 4; j++) {
+      EXPECT("denormalize", c[j] == RefDenormalize(f[j]), "%f", f[j]);
+    }
+  }
+  {
+    float4 f = {__builtin_nanf(""), -__builtin_inff(), __builtin_inff(), 0};
+    uint8_t e[4] = {0, 0, 255, 0};
+    EXPECT("denormalize", Same(shim_denormalize(f), e), "%s", "special");
+  }
+}
+
+int main() {
+  CheckUnpack();
+  CheckPack();
+  CheckNormalize();
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures != 0;
+}
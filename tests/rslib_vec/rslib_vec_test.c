@@ -0,0 +1,276 @@
+/*
+ * Copyright 2012, The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host-side accuracy and throughput check for rslib_vec.ll. The library is
+// compiled for the host by run.py and linked against this file; each float4
+// builtin is compared lane by lane against the host libm and timed against a
+// scalar loop calling libm.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef float float4 __attribute__((vector_size(16)));
+typedef float float2 __attribute__((vector_size(8)));
+
+typedef struct { float m[16]; } rs_matrix4x4;
+typedef struct { float m[4]; } rs_matrix2x2;
+
+#define RS_FUNC(ret, name, mangled, ...) \
+  extern ret name(__VA_ARGS__) __asm__(mangled)
+
+RS_FUNC(float4, vexp, "_Z3expDv4_f", float4);
+RS_FUNC(float4, vlog, "_Z3logDv4_f", float4);
+RS_FUNC(float4, vsin, "_Z3sinDv4_f", float4);
+RS_FUNC(float4, vcos, "_Z3cosDv4_f", float4);
+RS_FUNC(float4, vsqrt, "_Z4sqrtDv4_f", float4);
+RS_FUNC(float4, vrsqrt, "_Z5rsqrtDv4_f", float4);
+RS_FUNC(float4, vpow, "_Z3powDv4_fS_", float4, float4);
+RS_FUNC(float4, vclamp, "_Z5clampDv4_fS_S_", float4, float4, float4);
+RS_FUNC(float4, vclampf, "_Z5clampDv4_fff", float4, float, float);
+RS_FUNC(float4, vmix, "_Z3mixDv4_fS_S_", float4, float4, float4);
+RS_FUNC(float4, vmixf, "_Z3mixDv4_fS_f", float4, float4, float);
+RS_FUNC(float, vdot, "_Z3dotDv4_fS_", float4, float4);
+RS_FUNC(float2, vexp2, "_Z3expDv2_f", float2);
+RS_FUNC(float4, vmatmul4, "_Z16rsMatrixMultiplyPK12rs_matrix4x4Dv4_f",
+        const rs_matrix4x4 *, float4);
+RS_FUNC(float2, vmatmul2, "_Z16rsMatrixMultiplyPK12rs_matrix2x2Dv2_f",
+        const rs_matrix2x2 *, float2);
+
+#define N 4096
+
+static int failures = 0;
+
+static float RandIn(float lo, float hi) {
+  return lo + (hi - lo) * ((float) rand() / (float) RAND_MAX);
+}
+
+// Distance between a and b in units in the last place of b
+static double Ulps(float a, float b) {
+  if (isnan(a) && isnan(b)) {
+    return 0;
+  }
+  if (isinf(b) || isinf(a)) {
+    return (a == b) ? 0 : INFINITY;
+  }
+  if (b == 0 && fabsf(a) < 1e-37f) {
+    return 0;
+  }
+  float ulp = nextafterf(fabsf(b), INFINITY) - fabsf(b);
+  return fabs((double) a - (double) b) / ulp;
+}
+
+static void Check(const char *name, double maxUlps, double allowed) {
+  const char *result = (maxUlps <= allowed) ? "ok" : "FAILED";
+  printf("%-8s max error %8.2f ulp (allowed %.1f) %s\n", name, maxUlps,
+         allowed, result);
+  if (maxUlps > allowed) {
+    failures++;
+  }
+}
+
+static double Now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef float4 (*VecFn)(float4);
+typedef float (*ScalarFn)(float);
+
+static volatile float sink;
+
+static void Time(const char *name, VecFn vf, ScalarFn sf, const float *in) {
+  const int reps = 200;
+  float4 acc = {0, 0, 0, 0};
+  float sacc = 0;
+  double t0 = Now();
+  for (int r = 0; r < reps; r++) {
+    for (int i = 0; i < N; i += 4) {
+      float4 v;
+      memcpy(&v, in + i, sizeof(v));
+      acc += vf(v);
+    }
+  }
+  double t1 = Now();
+  for (int r = 0; r < reps; r++) {
+    for (int i = 0; i < N; i++) {
+      sacc += sf(in[i]);
+    }
+  }
+  double t2 = Now();
+  sink = acc[0] + acc[1] + acc[2] + acc[3] + sacc;
+  printf("%-8s %6.2f ns/element vector, %6.2f ns/element libm\n", name,
+         (t1 - t0) * 1e9 / (reps * N), (t2 - t1) * 1e9 / (reps * N));
+}
+
+static double CheckUnary(VecFn vf, ScalarFn sf, const float *in) {
+  double maxUlps = 0;
+  for (int i = 0; i < N; i += 4) {
+    float4 v;
+    memcpy(&v, in + i, sizeof(v));
+    float4 r = vf(v);
+    for (int j = 0; j < 4; j++) {
+      double e = Ulps(r[j], sf(in[i + j]));
+      if (e > maxUlps) {
+        maxUlps = e;
+      }
+    }
+  }
+  return maxUlps;
+}
+
+static float RefRsqrt(float x) {
+  return 1.0f / sqrtf(x);
+}
+
+static void Fill(float *buf, float lo, float hi) {
+  for (int i = 0; i < N; i++) {
+    buf[i] = RandIn(lo, hi);
+  }
+}
+
+int main() {
+  static float in[N], in2[N];
+  srand(1);
+
+  Fill(in, -87.0f, 88.0f);
+  Check("exp", CheckUnary(vexp, expf, in), 2);
+  Time("exp", vexp, expf, in);
+
+  Fill(in, 1e-30f, 1e30f);
+  for (int i = 0; i < N / 2; i++) {
+    in[i] = RandIn(0.01f, 10.0f);
+  }
+  Check("log", CheckUnary(vlog, logf, in), 2);
+  Time("log", vlog, logf, in);
+
+  Fill(in, -100.0f, 100.0f);
+  Check("sin", CheckUnary(vsin, sinf, in), 2);
+  Check("cos", CheckUnary(vcos, cosf, in), 2);
+  Time("sin", vsin, sinf, in);
+  Time("cos", vcos, cosf, in);
+
+  Fill(in, 0.0f, 1000.0f);
+  Check("sqrt", CheckUnary(vsqrt, sqrtf, in), 0);
+  Check("rsqrt", CheckUnary(vrsqrt, RefRsqrt, in), 0);
+
+  // Special values go through the same paths as everything else
+  {
+    float special[8] = {0.0f, -0.0f, INFINITY, -INFINITY, NAN, 1e-40f,
+                        -1.0f, 1.0f};
+    double e = 0;
+    for (int i = 0; i < 8; i += 4) {
+      float4 v;
+      memcpy(&v, special + i, sizeof(v));
+      float4 rexp = vexp(v), rlog = vlog(v), rsin = vsin(v), rcos = vcos(v);
+      for (int j = 0; j < 4; j++) {
+        float x = special[i + j];
+        e = fmax(e, Ulps(rexp[j], expf(x)));
+        e = fmax(e, Ulps(rlog[j], logf(x)));
+        e = fmax(e, Ulps(rsin[j], sinf(x)));
+        e = fmax(e, Ulps(rcos[j], cosf(x)));
+      }
+    }
+    Check("special", e, 2);
+  }
+
+  {
+    double e = 0;
+    Fill(in, 0.01f, 100.0f);
+    Fill(in2, -4.0f, 4.0f);
+    in[0] = -2.0f;  // Falls back to the intrinsic
+    in2[0] = 3.0f;
+    for (int i = 0; i < N; i += 4) {
+      float4 x, y;
+      memcpy(&x, in + i, sizeof(x));
+      memcpy(&y, in2 + i, sizeof(y));
+      float4 r = vpow(x, y);
+      for (int j = 0; j < 4; j++) {
+        e = fmax(e, Ulps(r[j], powf(in[i + j], in2[i + j])));
+      }
+    }
+    Check("pow", e, 8);
+  }
+
+  {
+    // These must match the scalar definitions exactly
+    double e = 0;
+    Fill(in, -2.0f, 2.0f);
+    Fill(in2, -2.0f, 2.0f);
+    for (int i = 0; i < N; i += 4) {
+      float4 a, b;
+      memcpy(&a, in + i, sizeof(a));
+      memcpy(&b, in2 + i, sizeof(b));
+      float4 lo = {-1, -0.5f, 0, 0.25f}, hi = {1, 0.5f, 0.75f, 1.5f};
+      float4 rc = vclamp(a, lo, hi);
+      float4 rcf = vclampf(a, -0.5f, 0.5f);
+      float4 rm = vmix(a, b, lo);
+      float4 rmf = vmixf(a, b, 0.3f);
+      float d = vdot(a, b);
+      for (int j = 0; j < 4; j++) {
+        float c = a[j] < lo[j] ? lo[j] : a[j];
+        c = c > hi[j] ? hi[j] : c;
+        e = fmax(e, Ulps(rc[j], c));
+        c = a[j] < -0.5f ? -0.5f : a[j];
+        c = c > 0.5f ? 0.5f : c;
+        e = fmax(e, Ulps(rcf[j], c));
+        e = fmax(e, Ulps(rm[j], a[j] + (b[j] - a[j]) * lo[j]));
+        e = fmax(e, Ulps(rmf[j], a[j] + (b[j] - a[j]) * 0.3f));
+      }
+      float rd = a[0] * b[0];
+      rd += a[1] * b[1];
+      rd += a[2] * b[2];
+      rd += a[3] * b[3];
+      e = fmax(e, Ulps(d, rd));
+    }
+    Check("simple", e, 0);
+  }
+
+  {
+    double e = 0;
+    rs_matrix4x4 m;
+    rs_matrix2x2 m2;
+    Fill(in, -10.0f, 10.0f);
+    memcpy(m.m, in, sizeof(m.m));
+    memcpy(m2.m, in + 16, sizeof(m2.m));
+    for (int i = 32; i < N; i += 4) {
+      float4 v;
+      memcpy(&v, in + i, sizeof(v));
+      float4 r = vmatmul4(&m, v);
+      for (int j = 0; j < 4; j++) {
+        float ref = m.m[j] * v[0] + m.m[4 + j] * v[1] + m.m[8 + j] * v[2] +
+                    m.m[12 + j] * v[3];
+        e = fmax(e, Ulps(r[j], ref));
+      }
+      float2 v2 = {v[0], v[1]};
+      float2 r2 = vmatmul2(&m2, v2);
+      for (int j = 0; j < 2; j++) {
+        e = fmax(e, Ulps(r2[j], m2.m[j] * v[0] + m2.m[2 + j] * v[1]));
+      }
+      float2 re = vexp2(v2);
+      e = fmax(e, Ulps(re[0], expf(v[0])) > 2 ? 1e9 : 0);
+      e = fmax(e, Ulps(re[1], expf(v[1])) > 2 ? 1e9 : 0);
+    }
+    Check("matrix", e, 0);
+  }
+
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures != 0;
+}
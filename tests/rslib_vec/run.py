@@ -0,0 +1,82 @@
+#!/usr/bin/env python
+#
+# Copyright 2012, The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Builds rslib_vec.ll for the host and runs the tests in this directory.
+
+Uses the llvm-as and llc found in $LLVM_AS and $LLC (or on the PATH) and the
+host C compiler in $CC.
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def Run(args):
+  print ' '.join(args)
+  return subprocess.call(args)
+
+
+# Test sources and the extra IR each one links against
+TESTS = [
+    ('rslib_vec_test.c', []),
+    ('rslib_pixel_test.c', ['rslib_pixel_shim.ll']),
+]
+
+
+def main():
+  here = os.path.dirname(os.path.abspath(__file__))
+  llvm_as = os.environ.get('LLVM_AS', 'llvm-as')
+  llc = os.environ.get('LLC', 'llc')
+  cc = os.environ.get('CC', 'cc')
+  tmp = tempfile.mkdtemp()
+
+  def Compile(ll):
+    """Assembles and compiles ll, returning the object file or None."""
+    name = os.path.splitext(os.path.basename(ll))[0]
+    bc = os.path.join(tmp, name + '.bc')
+    obj = os.path.join(tmp, name + '.o')
+    if (Run([llvm_as, ll, '-o', bc]) or
+        Run([llc, '-O2', '-relocation-model=pic', '-filetype=obj', bc,
+             '-o', obj])):
+      return None
+    return obj
+
+  lib = Compile(os.path.join(here, '..', '..', 'rslib_vec.ll'))
+  if lib is None:
+    return 1
+
+  failed = 0
+  for src, extra in TESTS:
+    objs = [lib]
+    for ll in extra:
+      obj = Compile(os.path.join(here, ll))
+      if obj is None:
+        return 1
+      objs.append(obj)
+    exe = os.path.join(tmp, os.path.splitext(src)[0])
+    if Run([cc, '-O2', '-std=gnu99', '-ffp-contract=off',
+            os.path.join(here, src)] + objs + ['-lm', '-lrt', '-o', exe]):
+      return 1
+    if Run([exe]):
+      failed += 1
+  return failed != 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -10,6 +10,7 @@ Runs subdirectories of tests for the RenderScript compiler.
 import filecmp
 import glob
 import os
+import re
 import shutil
 import string
 import subprocess
@@ -26,7 +27,11 @@ class Options(object):
 
 
 def CompareFiles(filename):
-  """Compares filename and filename.expect for equality."""
+  """Compares filename and filename.expect for equality.
+
+  In filename.expect, {{n}} stands for any decimal number (e.g. a size in
+  bytes that changes with the compiler).
+  """
   actual = filename
   expect = filename + '.expect'
 
@@ -39,7 +44,17 @@ def CompareFiles(filename):
       print 'Could not find %s' % expect
     return False
 
-  return filecmp.cmp(actual, expect, False)
+  f = open(expect, 'r')
+  expected = f.read()
+  f.close()
+  if expected.find('{{n}}') == -1:
+    return filecmp.cmp(actual, expect, False)
+
+  f = open(actual, 'r')
+  got = f.read()
+  f.close()
+  pattern = re.escape(expected).replace(re.escape('{{n}}'), '[0-9]+')
+  return re.match(pattern + '$', got) is not None
 
 
 def GetCommandLineArgs(filename):